@@ -0,0 +1,187 @@
+/**
+ * @file bidirectional_sst.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_BIDIRECTIONAL_SST_HPP
+#define SPARSE_BIDIRECTIONAL_SST_HPP
+
+#include "motion_planners/sst.hpp"
+
+/**
+ * @brief SST tree grown backward in time from the goal state
+ * @details SST tree grown backward in time from the goal state. The cost of a node is the duration of
+ * the trajectory from the node to the goal state. The tree has no goal region of its own.
+ */
+class backward_sst_t : public sst_t
+{
+public:
+	/**
+	 * @copydoc sst_t::sst_t()
+	 */
+	backward_sst_t(const double* in_start, const double* in_goal,
+	      double in_radius,
+	      const std::vector<std::pair<double, double> >& a_state_bounds,
+		  const std::vector<std::pair<double, double> >& a_control_bounds,
+		  std::function<double(const double*, const double*, unsigned int)> distance_function,
+		  unsigned int random_seed,
+		  double delta_near, double delta_drain,
+		  nearest_neighbors_factory_t nearest_neighbors_factory=nullptr);
+
+	using sst_t::grow;
+
+protected:
+	/**
+	 * @brief Extends the tree backward in time from a node.
+	 * @details Extends the tree backward in time from a node: the new state reaches the node when
+	 * propagated forward with the control. The system has to implement reversible_system_interface.
+	 */
+	bool extend(system_interface* system, const sst_node_t* nearest, const double* sample_state,
+	            double* control, double* result_state,
+	            int min_time_steps, int max_time_steps, double integration_step, double& duration) override;
+};
+
+/**
+ * Grows a tree forward from the start state and a tree backward from the goal state, alternating
+ * between the trees. When a new node of one tree is closer than the connection radius to a node of
+ * the other tree, the trees are connected: if the system can steer exactly, the gap is bridged with
+ * the steering control, then the controls of the goal tree are replayed forward from the node of the
+ * start tree. The connection is accepted if the replay is valid and ends in the goal region, so a
+ * solution is always a feasible forward trajectory. Solutions of the start tree reaching the goal
+ * region directly are found as in sst_t. Both trees are pruned with the best solution cost.
+ *
+ * The system has to implement reversible_system_interface.
+ * @brief Bidirectional SST for systems that can be propagated backward in time.
+ */
+class bidirectional_sst_t : public sst_t
+{
+public:
+	/**
+	 * @brief Bidirectional SST planner Constructor
+	 * @details Bidirectional SST planner Constructor
+	 *
+	 * @param in_start The start state.
+	 * @param in_goal The goal state
+	 * @param in_radius The radial size of the goal region centered at in_goal.
+	 * @param a_state_bounds A vector with boundaries of the state space (min and max)
+	 * @param a_control_bounds A vector with boundaries of the control space (min and max)
+	 * @param distance_function Function that returns distance between two state space points
+	 * @param random_seed The seed for the random generator, the goal tree uses random_seed + 1
+	 * @param delta_near Near distance threshold for SST
+	 * @param delta_drain Drain distance threshold for SST
+	 * @param connection_radius Distance between nodes of the two trees that triggers a connection attempt
+	 * @param nearest_neighbors_factory Creates the nearest neighbor structures (graph_nearest_neighbors_t if empty)
+	 */
+	bidirectional_sst_t(const double* in_start, const double* in_goal,
+	      double in_radius,
+	      const std::vector<std::pair<double, double> >& a_state_bounds,
+		  const std::vector<std::pair<double, double> >& a_control_bounds,
+		  std::function<double(const double*, const double*, unsigned int)> distance_function,
+		  unsigned int random_seed,
+		  double delta_near, double delta_drain,
+		  double connection_radius,
+		  nearest_neighbors_factory_t nearest_neighbors_factory=nullptr);
+	virtual ~bidirectional_sst_t();
+
+	/**
+	 * @copydoc planner_t::get_solution()
+	 */
+	virtual void get_solution(std::vector<std::vector<double>>& solution_path, std::vector<std::vector<double>>& controls, std::vector<double>& costs) override;
+
+	/**
+	 * @copydoc planner_t::step()
+	 */
+	virtual void step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step) override;
+
+	/**
+	 * @copydoc planner_t::has_solution()
+	 */
+	virtual bool has_solution() override;
+
+	/**
+	 * @copydoc planner_t::get_best_cost()
+	 */
+	virtual double get_best_cost() const override;
+
+	/**
+	 * A tree file holds a single tree, the goal tree and the connection would be lost.
+	 * Throws std::runtime_error, the bidirectional planner can not be saved.
+	 * @copydoc planner_t::export_tree()
+	 */
+	virtual void export_tree(tree_data_t& data) const override;
+
+	/**
+	 * Throws std::runtime_error, the bidirectional planner can not be loaded, see export_tree().
+	 * @copydoc planner_t::import_tree()
+	 */
+	virtual void import_tree(const tree_file_t& file) override;
+
+	/**
+	 * The goal tree is grown from the goal state, the goal can not be replaced.
+	 */
+	void set_goal(const double* in_goal, double in_radius) = delete;
+
+	/**
+	 * @brief Return the tree grown from the goal state
+	 * @return tree grown from the goal state
+	 */
+	const backward_sst_t* get_goal_tree() const { return goal_tree.get(); }
+
+protected:
+	/**
+	 * @brief Tries to connect a node of the start tree with a node of the goal tree.
+	 * @details Tries to connect a node of the start tree with a node of the goal tree and keeps the
+	 * connection if it is feasible and better than the best solution.
+	 *
+	 * @param system The system to plan for
+	 * @param start_node The node of the start tree
+	 * @param goal_node The node of the goal tree
+	 * @param integration_step Integration step in seconds to integrate the system
+	 */
+	void connect(system_interface* system, const sst_node_t* start_node, const sst_node_t* goal_node, double integration_step);
+
+	/**
+	 * @brief The tree grown backward from the goal state.
+	 */
+	std::unique_ptr<backward_sst_t> goal_tree;
+
+	/**
+	 * @brief Distance between nodes of the two trees that triggers a connection attempt.
+	 */
+	double connection_radius;
+
+	/**
+	 * @brief Whether the next iteration grows the goal tree.
+	 */
+	bool grow_goal_tree;
+
+	/**
+	 * @brief The cost of the best connection, infinity if there is none.
+	 */
+	double connection_cost;
+
+	/**
+	 * @brief The trajectory of the best connection.
+	 */
+	std::vector<std::vector<double>> connection_path;
+	std::vector<std::vector<double>> connection_controls;
+	std::vector<double> connection_durations;
+
+	/**
+	 * @brief Preallocated states of the connection attempts.
+	 */
+	std::vector<double> connection_state;
+	std::vector<double> connection_result;
+	std::vector<double> connection_control;
+};
+
+#endif
@@ -40,10 +40,11 @@
 
 #include <string>
 /**
- * @brief The motion planning algorithm SST (Stable Sparse-RRT)
- * @details The motion planning algorithm SST (Stable Sparse-RRT)
+ * @brief The motion planning algorithm SST (Stable Sparse-RRT) with neural sampling and MPC steering
+ * @details The motion planning algorithm SST (Stable Sparse-RRT) with neural sampling and MPC steering.
+ * The tree, the witnesses and the pruning are those of the sst_t engine.
  */
-class deep_smp_mpc_sst_t : public planner_t
+class deep_smp_mpc_sst_t : public sst_t
 {
 public:
 	/**
@@ -59,6 +60,7 @@ public:
 	 * @param random_seed The seed for the random generator
 	 * @param delta_near Near distance threshold for SST
 	 * @param delta_drain Drain distance threshold for SST
+	 * @param nearest_neighbors_factory Creates the nearest neighbor structures (graph_nearest_neighbors_t if empty)
 	 */
 	deep_smp_mpc_sst_t(const double* in_start, const double* in_goal,
 		double in_radius,
@@ -70,19 +72,15 @@ public:
 		trajectory_optimizers::CEM* cem,
 		networks::mpnet_cost_t *mpnet,
 		int np,
-		int shm_max_step
+		int shm_max_step,
+		nearest_neighbors_factory_t nearest_neighbors_factory=nullptr
 	);
 	virtual ~deep_smp_mpc_sst_t();
 
-	/**
-	 * @copydoc planner_t::get_solution(std::vector<std::pair<double*,double> >&)
-	 */
-	virtual void get_solution(std::vector<std::vector<double>>& solution_path, std::vector<std::vector<double>>& controls, std::vector<double>& costs);
-	
 	/**
 	 * @copydoc planner_t::step()
 	 */
-	 virtual void step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step);
+	 using sst_t::step;
 	 virtual void step(enhanced_system_interface* system, int min_time_steps, int max_time_steps, double integration_step);
 	 virtual void step_with_output(enhanced_system_interface* system, int min_time_steps, int max_time_steps, double integration_step, double* steer_start, double* steer_goal);
 	 virtual void mpc_step(enhanced_system_t* system, double integration_step);
@@ -101,20 +99,6 @@ public:
 	 virtual void neural_step_single_batch(enhanced_system_t* system, double integration_step, torch::Tensor& env_vox, 
     	bool refine, float refine_threshold, bool using_one_step_cost, bool cost_reselection, double* states, double goal_bias, const int NP);
 
-	// Expose two functions public to enable the python wrappers to call 
-	/**
-	 * @brief Finds a node to propagate from.
-	 * @details Finds a node to propagate from. It does this through a procedure called BestNear w
-	 * which examines a neighborhood around a randomly sampled point and returns the lowest cost one.
-	 */
-	sst_node_t* nearest_vertex(const double* sample_state);
-
-	/**
-	 * @brief If propagation was successful, add the new state to the tree.
-	 * @details If propagation was successful, add the new state to the tree.
-	 */
-	void add_to_tree(const double* sample_state, const double* sample_control, sst_node_t* nearest, double duration);
-	
 	/**
 	 * @brief Applies bvp or mpc or random to steer
 	 * @details Applies bvp or mpc or random to steer
@@ -148,16 +132,6 @@ public:
 	
 	// double goal_bias;
 protected:
-    /**
-     * @brief The nearest neighbor data structure.
-     */
-    graph_nearest_neighbors_t metric;
-
-	/**
-	 * @brief The best goal node found so far.
-	 */
-	sst_node_t* best_goal;
-
 	/**
 	 * @brief The best goal node found so far.
 	 */
@@ -168,65 +142,6 @@ protected:
      */
 	networks::mpnet_cost_t *mpnet_ptr;
 
-	/**
-	 * @brief Check if the currently created state is close to a witness.
-	 * @details Check if the currently created state is close to a witness.
-	 */
-	sample_node_t* find_witness(const double* sample_state);
-
-	/**
-	 * @brief Checks if this node has any children.
-	 * @details Checks if this node has any children.
-	 * 
-	 * @param node The node to examine.
-	 * @return True if no children, false if at least one child.
-	 */
-	bool is_leaf(tree_node_t* node);
-
-	/**
-	 * @brief Checks if this node is on the solution path.
-	 * @details Checks if this node is on the solution path.
-	 * 
-	 * @param v The node to check
-	 * @return True if on the solution path, false if not.
-	 */
-	bool is_best_goal(tree_node_t* v);
-
-	/**
-	 * @brief Removes a leaf node from the tree.
-	 * @details Removes a leaf node from the tree.
-	 * 
-	 * @param node The node to remove.
-	 */
-	void remove_leaf(sst_node_t* node);
-
-	/**
-	 * @brief Branch out and prune planning tree
-	 * @details Branch out and prune planning tree
-	 *
-	 * @param node The node from which to branch
-	 */
-	void branch_and_bound(sst_node_t* node);
-
-	/**
-	 * The nearest neighbor structure for witness samples.
-	 */
-	graph_nearest_neighbors_t samples;
-
-	/**
-	 * @brief Near distance threshold for SST
-	 */
-	double sst_delta_near;
-
-	/**
-	 * @brief Drain distance threshold for SST
-	 */
-	double sst_delta_drain;
-
-	/**
-	 * @brief Container for witness nodes (to avoid memory leaks)
-	 */
-    std::vector<sample_node_t*> witness_nodes;
 	/**
 	 * 
 	 */
@@ -0,0 +1,145 @@
+/**
+ * @file node_arena.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_NODE_ARENA_HPP
+#define SPARSE_NODE_ARENA_HPP
+
+#include <vector>
+
+#include "motion_planners/tree_node.hpp"
+#include "utilities/slab_allocator.hpp"
+
+/**
+ * @brief Allocates planner nodes together with their state and control.
+ * @details Allocates planner nodes together with their state and control. Every node lives in a
+ * single block of a slab_allocator_t: the node object is followed by the memory for its point and
+ * for the control of its parent edge, which are passed to the constructors as storage.
+ * Destroyed nodes are recycled by the next allocations.
+ *
+ * Usage:
+ *     void* block = arena.allocate();
+ *     node_t* node = new (block) node_t(point, state_dimension, ...,
+ *         tree_edge_t(control, control_dimension, duration, arena.get_control_storage(block)), ...,
+ *         arena.get_point_storage(block));
+ *     arena.destroy(node);
+ */
+template <class node_t>
+class node_arena_t
+{
+public:
+	/**
+	 * @brief Arena constructor
+	 * @param state_dimension Dimensionality of the state space
+	 * @param control_dimension Dimensionality of the control space
+	 */
+	node_arena_t(unsigned int state_dimension, unsigned int control_dimension)
+		: point_offset((sizeof(node_t) + alignof(double) - 1) / alignof(double) * alignof(double))
+		, control_offset(point_offset + state_dimension * sizeof(double))
+		, allocator(control_offset + control_dimension * sizeof(double))
+	{
+	}
+
+	/**
+	 * @brief Returns memory for a node, to be constructed with placement new.
+	 * @return uninitialized block
+	 */
+	void* allocate()
+	{
+		return allocator.allocate();
+	}
+
+	/**
+	 * @brief Return the memory for the point of the node in a block
+	 * @param block A block returned by allocate()
+	 * @return storage for state_dimension values
+	 */
+	double* get_point_storage(void* block) const
+	{
+		return reinterpret_cast<double*>(static_cast<char*>(block) + point_offset);
+	}
+
+	/**
+	 * @brief Return the memory for the parent edge control of the node in a block
+	 * @param block A block returned by allocate()
+	 * @return storage for control_dimension values
+	 */
+	double* get_control_storage(void* block) const
+	{
+		return reinterpret_cast<double*>(static_cast<char*>(block) + control_offset);
+	}
+
+	/**
+	 * @brief Destructs a node and recycles its block.
+	 * @param node A node constructed in a block of this arena
+	 */
+	void destroy(node_t* node)
+	{
+		node->~node_t();
+		allocator.deallocate(node);
+	}
+
+	/**
+	 * @brief Destructs a whole tree of nodes allocated from this arena.
+	 * @details Destructs a whole tree of nodes allocated from this arena. The children are
+	 * destroyed before their parents, without recursion, so deep trees are fine.
+	 *
+	 * @param root The root of the tree
+	 */
+	void destroy_tree(node_t* root)
+	{
+		std::vector<tree_node_t*> nodes(1, root);
+		for (size_t i = 0; i < nodes.size(); i++) {
+			for (tree_node_t* child: nodes[i]->get_children()) {
+				nodes.push_back(child);
+			}
+		}
+		for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+			(*it)->release_children();
+			destroy(static_cast<node_t*>(*it));
+		}
+	}
+
+	/**
+	 * @brief Return the number of live nodes
+	 * @return number of allocated and not destroyed nodes
+	 */
+	size_t get_number_of_nodes() const
+	{
+		return allocator.get_number_of_blocks();
+	}
+
+	/**
+	 * @brief Return the memory taken by the arena
+	 * @return size of all slabs in bytes
+	 */
+	size_t get_reserved_size() const
+	{
+		return allocator.get_reserved_size();
+	}
+
+private:
+	/**
+	 * @brief Offset of the point in a block.
+	 */
+	size_t point_offset;
+
+	/**
+	 * @brief Offset of the control in a block.
+	 */
+	size_t control_offset;
+
+	slab_allocator_t allocator;
+};
+
+#endif
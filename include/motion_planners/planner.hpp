@@ -16,11 +16,19 @@
 #define SPARSE_PLANNER_HPP
 
 #include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
 
 #include "systems/system.hpp"
+#include "nearest_neighbors/nearest_neighbors.hpp"
 #include "nearest_neighbors/graph_nearest_neighbors.hpp"
 #include "motion_planners/tree_node.hpp"
+#include "motion_planners/sampler.hpp"
+#include "motion_planners/tree_file.hpp"
 #include "utilities/random.hpp"
+#include "utilities/timer.hpp"
 
 /**
  * @brief The base class for motion planners.
@@ -62,6 +70,11 @@ public:
         , distance(distance_function)
         , random_generator(random_seed)
         , number_of_nodes(0)
+        , cost_bound(std::numeric_limits<double>::infinity())
+        , close_nodes(MAX_KK, nullptr)
+        , close_distances(MAX_KK, 0.)
+        , scratch_state(new double[this->state_dimension])
+        , scratch_control(new double[this->control_dimension])
     {
         std::copy(in_start, in_start + this->state_dimension, start_state);
 	    std::copy(in_goal, in_goal + this->state_dimension, goal_state);
@@ -71,6 +84,8 @@ public:
 	{
 	    delete[] start_state;
 	    delete[] goal_state;
+	    delete[] scratch_state;
+	    delete[] scratch_control;
 	}
 
 	/**
@@ -94,6 +109,130 @@ public:
 	 */
 	virtual void step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step) = 0;
 
+	/**
+	 * @brief Check whether a solution was found.
+	 * @details Check whether a solution was found, without building the solution path.
+	 *
+	 * @return True if get_solution() returns a path.
+	 */
+	virtual bool has_solution() = 0;
+
+	/**
+	 * @brief Return the cost of the best solution.
+	 * @details Return the cost of the best solution, infinity if no solution was found.
+	 *
+	 * @return cost of the best solution
+	 */
+	virtual double get_best_cost() const = 0;
+
+	/**
+	 * @brief Return the distance of a state from the closest start state.
+	 * @details Return the distance of a state from the closest start state. Planners that grow
+	 * trees from several start states measure it from all of them.
+	 *
+	 * @param state The state
+	 * @return distance from the closest start state
+	 */
+	virtual double get_start_distance(const double* state) const
+	{
+		return this->distance(this->start_state, state, this->state_dimension);
+	}
+
+	/**
+	 * @brief Copy the tree into the layout of a tree file.
+	 * @details Copy the tree into the layout of a tree file, see tree_data_t.
+	 *
+	 * @param data Storage for the tree
+	 */
+	virtual void export_tree(tree_data_t& data) const = 0;
+
+	/**
+	 * The tree of the planner is replaced by the tree of the file, the start state becomes the state of
+	 * the first root. The goal of the planner is kept and the best goal is searched in the new tree.
+	 * The random generator is not restored, so planning continues with the seed of this planner.
+	 * Throws std::runtime_error if the dimensions do not match or the file is corrupted.
+	 * Loading time is dominated by rebuilding the proximity structures, services that only query
+	 * a tree should map it with tree_file_t instead.
+	 * @brief Replace the tree with the tree of a tree file.
+	 *
+	 * @param file The mapped tree file
+	 */
+	virtual void import_tree(const tree_file_t& file) = 0;
+
+	/**
+	 * @brief Save the tree to a tree file.
+	 * @details Save the tree to a tree file that can be loaded by load_tree() or mapped by tree_file_t.
+	 *
+	 * @param filename The file to write
+	 */
+	void save_tree(const std::string& filename) const
+	{
+		tree_data_t data;
+		this->export_tree(data);
+		tree_file_t::write(filename, data);
+	}
+
+	/**
+	 * @brief Load the tree from a tree file.
+	 * @details Load the tree from a tree file, see import_tree().
+	 *
+	 * @param filename The file written by save_tree()
+	 */
+	void load_tree(const std::string& filename)
+	{
+		tree_file_t file(filename);
+		this->import_tree(file);
+	}
+
+	/**
+	 * @brief Perform a number of iterations of a motion planning algorithm.
+	 * @details Perform a number of iterations of a motion planning algorithm.
+	 *
+	 * @param system System object that has to be integrated under planner control
+	 * @param number_of_iterations Number of iterations to perform
+	 * @param min_time_steps Minimum number of control steps for the system
+	 * @param max_time_steps Maximum number of control steps for the system
+	 * @param integration_step Integration step in seconds to integrate the system
+	 */
+	void step_n(system_interface* system, unsigned int number_of_iterations, int min_time_steps, int max_time_steps, double integration_step)
+	{
+		for (unsigned int i = 0; i < number_of_iterations; ++i) {
+			this->step(system, min_time_steps, max_time_steps, integration_step);
+		}
+	}
+
+	/**
+	 * @brief Perform iterations of a motion planning algorithm until a budget is exhausted.
+	 * @details Perform iterations of a motion planning algorithm until the time budget is used,
+	 * the tree reaches the node budget or, if requested, a solution is found. At least one of
+	 * the stopping conditions has to be given.
+	 *
+	 * @param system System object that has to be integrated under planner control
+	 * @param min_time_steps Minimum number of control steps for the system
+	 * @param max_time_steps Maximum number of control steps for the system
+	 * @param integration_step Integration step in seconds to integrate the system
+	 * @param time_budget Planning time in seconds, infinity for no limit
+	 * @param node_budget Number of nodes in the tree, 0 for no limit
+	 * @param stop_at_solution Whether to stop as soon as a solution is found
+	 *
+	 * @return The number of iterations performed
+	 */
+	unsigned int run_until(system_interface* system, int min_time_steps, int max_time_steps, double integration_step,
+	                       double time_budget, unsigned int node_budget, bool stop_at_solution)
+	{
+		assert(time_budget < std::numeric_limits<double>::infinity() || node_budget > 0 || stop_at_solution);
+		sys_timer_t timer;
+		timer.reset();
+		unsigned int iterations = 0;
+		while (!(stop_at_solution && this->has_solution()) &&
+		       !(node_budget > 0 && this->number_of_nodes >= node_budget) &&
+		       timer.measure() < time_budget) {
+			this->step(system, min_time_steps, max_time_steps, integration_step);
+			iterations++;
+		}
+		return iterations;
+	}
+
     /**
 	 * @brief Return the root of the planning tree
 	 * @details Return the root of the planning tree
@@ -110,11 +249,69 @@ public:
 	 */
 	void random_state(double* state)
 	{
+		if (this->sampler) {
+			this->sampler->sample(this->random_generator, this->get_best_cost(), state);
+			return;
+		}
 		for (unsigned int i =0; i < this->state_bounds.size(); ++i) {
             state[i] = this->random_generator.uniform_random(this->state_bounds[i].first, this->state_bounds[i].second);
         }
 	}
 
+	/**
+	 * @brief Set an external bound of the solution cost.
+	 * @details Set an external bound of the solution cost, e.g. the cost of a solution found by another
+	 * planner for the same query. Planners do not add nodes more expensive than the bound, planners that
+	 * prune by cost also remove the nodes more expensive than a tighter bound from their trees.
+	 * The bound belongs to the current query, planners clear it when their goal or tree is replaced.
+	 *
+	 * @param bound The cost bound, infinity for no bound
+	 */
+	virtual void set_cost_bound(double bound)
+	{
+		this->cost_bound = bound;
+	}
+
+	/**
+	 * @brief Set the strategy of the state sampling.
+	 * @details Set the strategy of the state sampling. The planner takes ownership of the sampler.
+	 *
+	 * @param new_sampler The sampler to use, nullptr to sample uniformly within the state bounds
+	 */
+	void set_sampler(sampler_t* new_sampler)
+	{
+		this->sampler.reset(new_sampler);
+	}
+
+	/**
+	 * The samples of the base sampler are replaced with the goal state with probability goal_bias.
+	 * If cost_per_distance is positive, samples are rejected once a solution is found if the cost
+	 * of a path through them, estimated as cost_per_distance times the distance from the closest start
+	 * plus the distance to the goal region, exceeds the best cost. The estimate has to be a lower
+	 * bound of the true cost, e.g. the inverse of the maximum speed for time optimal planning.
+	 * @brief Configure goal biased and informed sampling.
+	 *
+	 * @param goal_bias The probability of sampling the goal state
+	 * @param cost_per_distance Lower bound of the cost of moving a unit of distance, 0 disables informed sampling
+	 * @param base_sampler The sampler to draw from, the planner takes ownership. Uniform sampling if nullptr.
+	 */
+	void set_sampling(double goal_bias, double cost_per_distance, sampler_t* base_sampler=nullptr)
+	{
+		sampler_t* new_sampler = base_sampler ? base_sampler : new uniform_sampler_t(this->state_bounds);
+		if (cost_per_distance > 0) {
+			// The bound reads the query of the planner, so it follows changes of the goal and added starts
+			new_sampler = new informed_sampler_t(new_sampler,
+				[this, cost_per_distance](const double* state) {
+					double cost_to_go = std::max(0., this->distance(state, this->goal_state, this->state_dimension) - this->goal_radius);
+					return cost_per_distance*(this->get_start_distance(state) + cost_to_go);
+				});
+		}
+		if (goal_bias > 0) {
+			new_sampler = new goal_biased_sampler_t(new_sampler, this->goal_state, this->state_dimension, goal_bias);
+		}
+		this->set_sampler(new_sampler);
+	}
+
 	/**
 	 * @brief Performs a random sampling for a new control.
 	 * @details Performs a random sampling for a new control.
@@ -168,6 +365,63 @@ public:
 
 protected:
 
+	/**
+	 * Every parent precedes its children, and the children of a node are listed in the reverse order of its
+	 * children list, so that adding the nodes in this order with add_child() restores the children lists.
+	 * The controls of the roots are zeros, the node witnesses are -1 and all nodes are flagged active.
+	 * @brief Copies the nodes of trees into the layout of a tree file.
+	 *
+	 * @param tree_roots The roots of the trees
+	 * @param data Storage for the tree, the witness arrays are left empty
+	 * @param nodes Storage for the nodes in the order of the file
+	 */
+	void export_nodes(const std::vector<tree_node_t*>& tree_roots, tree_data_t& data, std::vector<const tree_node_t*>& nodes) const
+	{
+		data.state_dimension = this->state_dimension;
+		data.control_dimension = this->control_dimension;
+		std::vector<std::pair<const tree_node_t*, int32_t>> stack;
+		for (auto it = tree_roots.rbegin(); it != tree_roots.rend(); ++it) {
+			stack.push_back(std::make_pair(*it, -1));
+		}
+		while (!stack.empty()) {
+			const tree_node_t* node = stack.back().first;
+			int32_t parent = stack.back().second;
+			stack.pop_back();
+			int32_t index = nodes.size();
+			nodes.push_back(node);
+			data.states.insert(data.states.end(), node->get_point(), node->get_point() + this->state_dimension);
+			if (parent < 0) {
+				data.controls.insert(data.controls.end(), this->control_dimension, 0.);
+			} else {
+				const double* control = node->get_parent_edge().get_control();
+				data.controls.insert(data.controls.end(), control, control + this->control_dimension);
+			}
+			data.durations.push_back(node->get_parent_edge().get_duration());
+			data.costs.push_back(node->get_cost());
+			data.parents.push_back(parent);
+			data.node_witnesses.push_back(-1);
+			data.flags.push_back(TREE_FILE_NODE_ACTIVE);
+			for (tree_node_t* child: node->get_children()) {
+				stack.push_back(std::make_pair(child, index));
+			}
+		}
+	}
+
+	/**
+	 * @brief Creates a nearest neighbor structure for the planner.
+	 * @details Creates a nearest neighbor structure for the planner.
+	 *
+	 * @param nearest_neighbors_factory The factory to use, graph_nearest_neighbors_t is created if it is empty
+	 * @return The created structure
+	 */
+	static nearest_neighbors_t* create_nearest_neighbors(const nearest_neighbors_factory_t& nearest_neighbors_factory)
+	{
+	    if (nearest_neighbors_factory) {
+	        return nearest_neighbors_factory();
+	    }
+	    return new graph_nearest_neighbors_t();
+	}
+
     /**
      * @brief Dimensionality of the state space
      */
@@ -217,8 +471,38 @@ protected:
      */
 	RandomGenerator random_generator;
 
+	/**
+	 * @brief Strategy of the state sampling, uniform within the state bounds if empty
+	 */
+	std::unique_ptr<sampler_t> sampler;
+
 	/** @brief The number of nodes in the tree. */
 	unsigned number_of_nodes;
+
+	/**
+	 * @brief External bound of the solution cost
+	 */
+	double cost_bound;
+
+	/**
+	 * @brief Preallocated output of the nearest neighbor queries.
+	 */
+	std::vector<proximity_node_t*> close_nodes;
+
+	/**
+	 * @brief Preallocated output of the nearest neighbor queries.
+	 */
+	std::vector<double> close_distances;
+
+	/**
+	 * @brief Preallocated sample state of an iteration.
+	 */
+	double* scratch_state;
+
+	/**
+	 * @brief Preallocated sample control of an iteration.
+	 */
+	double* scratch_control;
 };
 
 
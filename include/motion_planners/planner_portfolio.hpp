@@ -0,0 +1,116 @@
+/**
+ * @file planner_portfolio.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_PLANNER_PORTFOLIO_HPP
+#define SPARSE_PLANNER_PORTFOLIO_HPP
+
+#include <atomic>
+#include <vector>
+
+#include "systems/system.hpp"
+#include "motion_planners/planner.hpp"
+
+/**
+ * Runs independent planners for the same query in parallel, one thread per planner, and keeps the
+ * best solution. The planners differ by their random seeds, which reduces the variance of the time
+ * to the first solution. The planners share the best cost found by any of them as cost bound, so
+ * that every planner prunes with the best known solution, and at the end of the run all trees are
+ * pruned with the best cost of the portfolio. The run stops when the time budget is
+ * used, when cancel() is called or, if requested, as soon as one of the planners finds a solution.
+ * @brief A portfolio of planners solving the same query in parallel.
+ */
+class planner_portfolio_t
+{
+public:
+	/**
+	 * @brief Portfolio constructor
+	 * @details Portfolio constructor, the portfolio does not take ownership of the planners and systems.
+	 *
+	 * @param planners The planners, usually created with different random seeds
+	 * @param systems One system per planner. The systems must be distinct instances of the same system.
+	 */
+	planner_portfolio_t(const std::vector<planner_t*>& planners, const std::vector<system_interface*>& systems);
+
+	/**
+	 * @brief Runs the planners in parallel until a stopping condition is met.
+	 * @details Runs the planners in parallel until the time budget is used, cancel() is called or,
+	 * if requested, a planner finds a solution. At least one of the stopping conditions has to be given.
+	 *
+	 * @param min_time_steps Minimum number of control steps for the system
+	 * @param max_time_steps Maximum number of control steps for the system
+	 * @param integration_step Integration step in seconds to integrate the system
+	 * @param time_budget Planning time in seconds, infinity for no limit
+	 * @param stop_at_solution Whether to cancel all planners as soon as one finds a solution
+	 * @param share_cost_bound Whether the planners prune with the best cost found by any planner,
+	 * the cost bounds of the planners are cleared when the run returns
+	 *
+	 * @return The index of the planner with the best solution, -1 if no solution was found
+	 */
+	int run(int min_time_steps, int max_time_steps, double integration_step,
+	        double time_budget, bool stop_at_solution, bool share_cost_bound=true);
+
+	/**
+	 * @brief Stops a running portfolio.
+	 * @details Stops a running portfolio, can be called from any thread. The planners finish their current iteration.
+	 */
+	void cancel()
+	{
+		cancelled.store(true);
+	}
+
+	/**
+	 * @brief Return the cost of the best solution found by any planner
+	 * @return cost of the best solution, infinity if there is none
+	 */
+	double get_best_cost() const
+	{
+		return best_cost.load();
+	}
+
+	/**
+	 * @brief Return the number of iterations every planner performed in the last run
+	 * @return number of iterations per planner
+	 */
+	const std::vector<unsigned int>& get_number_of_iterations() const
+	{
+		return number_of_iterations;
+	}
+
+private:
+	/**
+	 * @brief Lowers the shared best cost if the cost is better.
+	 * @param cost The cost of a solution
+	 */
+	void offer_cost(double cost);
+
+	std::vector<planner_t*> planners;
+	std::vector<system_interface*> systems;
+
+	/**
+	 * @brief Set to stop the worker threads.
+	 */
+	std::atomic<bool> cancelled;
+
+	/**
+	 * @brief The best cost found by any planner.
+	 */
+	std::atomic<double> best_cost;
+
+	/**
+	 * @brief Iterations performed by every planner in the last run.
+	 */
+	std::vector<unsigned int> number_of_iterations;
+};
+
+#endif
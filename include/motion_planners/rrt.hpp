@@ -36,7 +36,7 @@ public:
 	 * @param a_parent_edge An edge between the parent and this node
 	 * @param a_cost Cost of the edge
 	 */
-	rrt_node_t(double* point, unsigned int state_dimension, rrt_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost);
+	rrt_node_t(const double* point, unsigned int state_dimension, rrt_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost);
 
 	~rrt_node_t();
 
@@ -59,7 +59,8 @@ private:
 
 /**
  * @brief The motion planning algorithm RRT (Rapidly-exploring Random Tree)
- * @details The motion planning algorithm RRT (Rapidly-exploring Random Tree)
+ * @details The motion planning algorithm RRT (Rapidly-exploring Random Tree). The tree is never
+ * pruned, but nodes more expensive than the cost bound are not added.
  */
 class rrt_t : public planner_t
 {
@@ -72,23 +73,27 @@ public:
 	      const std::vector<std::pair<double, double> >& a_state_bounds,
 		  const std::vector<std::pair<double, double> >& a_control_bounds,
 		  std::function<double(const double*, const double*, unsigned int)> a_distance_function,
-          unsigned int random_seed)
+          unsigned int random_seed,
+          nearest_neighbors_factory_t nearest_neighbors_factory=nullptr)
 			: planner_t(in_start, in_goal, in_radius,
 			            a_state_bounds, a_control_bounds, a_distance_function, random_seed)
+			, metric(create_nearest_neighbors(nearest_neighbors_factory))
+			, best_goal(nullptr)
 	{
         //initialize the metric
         unsigned int state_dimensions = this->get_state_dimension();
-        metric.set_distance(
+        metric->set_distance(
             [state_dimensions, a_distance_function](const double* s0, const double* s1) {
                 return a_distance_function(s0, s1, state_dimensions);
-            }
+            },
+            state_dimensions
         );
 
         this->root = new rrt_node_t(start_state, this->state_dimension, NULL, tree_edge_t(NULL, 0, -1.), 0.);
         number_of_nodes++;
 
         //add root to nearest neighbor structure
-        metric.add_node(root);
+        metric->add_node(root);
 	}
 	virtual ~rrt_t(){
         delete this->root;
@@ -105,12 +110,32 @@ public:
 	 */
 	virtual void step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step);
 
+	/**
+	 * @copydoc planner_t::has_solution()
+	 */
+	virtual bool has_solution() { return best_goal != nullptr; }
+
+	/**
+	 * @copydoc planner_t::get_best_cost()
+	 */
+	virtual double get_best_cost() const { return best_goal ? best_goal->get_cost() : std::numeric_limits<double>::infinity(); }
+
+	/**
+	 * @copydoc planner_t::export_tree()
+	 */
+	virtual void export_tree(tree_data_t& data) const override;
+
+	/**
+	 * @copydoc planner_t::import_tree()
+	 */
+	virtual void import_tree(const tree_file_t& file) override;
+
 protected:
 
     /**
      * @brief The nearest neighbor data structure.
      */
-    graph_nearest_neighbors_t metric;
+    std::unique_ptr<nearest_neighbors_t> metric;
 
 	/**
 	 * @brief The result of a query in the nearest neighbor structure.
@@ -123,6 +148,11 @@ protected:
 	 */
 	rrt_node_t* nearest_vertex(const double* state) const;
 
+	/**
+	 * @brief The node with the lowest cost inside the goal region, updated when nodes are added.
+	 */
+	rrt_node_t* best_goal;
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+/**
+ * @file sampler.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_SAMPLER_HPP
+#define SPARSE_SAMPLER_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "utilities/random.hpp"
+
+#define INFORMED_SAMPLER_MAX_ATTEMPTS 100
+
+/**
+ * @brief Strategy drawing the states a planner grows its tree towards.
+ * @details Strategy drawing the states a planner grows its tree towards. Samplers draw their random
+ * numbers from the random generator of the planner, so that planning stays reproducible for a seed.
+ */
+class sampler_t
+{
+public:
+	virtual ~sampler_t() {}
+
+	/**
+	 * @brief Draws a state
+	 * @details Draws a state
+	 *
+	 * @param random_generator The random generator of the planner
+	 * @param best_cost The cost of the best solution found so far, infinity if there is none
+	 * @param state Storage for the sample
+	 */
+	virtual void sample(RandomGenerator& random_generator, double best_cost, double* state) = 0;
+};
+
+/**
+ * @brief Samples uniformly within the state bounds
+ * @details Samples uniformly within the state bounds, the default strategy of the planners.
+ */
+class uniform_sampler_t : public sampler_t
+{
+public:
+	/**
+	 * @brief Sampler constructor
+	 * @param state_bounds A vector with boundaries of the state space (min and max)
+	 */
+	uniform_sampler_t(const std::vector<std::pair<double, double> >& state_bounds);
+
+	void sample(RandomGenerator& random_generator, double best_cost, double* state) override;
+
+private:
+	std::vector<std::pair<double, double> > state_bounds;
+};
+
+/**
+ * @brief Returns the goal state with a fixed probability
+ * @details Returns the goal state with a fixed probability, otherwise a sample of another sampler.
+ */
+class goal_biased_sampler_t : public sampler_t
+{
+public:
+	/**
+	 * @brief Sampler constructor
+	 * @param base_sampler The sampler used when the goal is not returned, the sampler takes ownership
+	 * @param goal_state The goal state, it is read at every sample and has to outlive the sampler
+	 * @param state_dimension Dimensionality of the state space
+	 * @param goal_bias The probability of returning the goal state
+	 */
+	goal_biased_sampler_t(sampler_t* base_sampler, const double* goal_state, unsigned int state_dimension, double goal_bias);
+
+	void sample(RandomGenerator& random_generator, double best_cost, double* state) override;
+
+private:
+	std::unique_ptr<sampler_t> base_sampler;
+	const double* goal_state;
+	unsigned int state_dimension;
+	double goal_bias;
+};
+
+/**
+ * Once a solution is known, samples of another sampler are rejected if every path through them costs more
+ * than the solution, according to an admissible lower bound of the cost-to-come plus the cost-to-go.
+ * Extending the tree towards such states can not improve the solution. To never stall the planner,
+ * the last sample is returned if max_attempts samples in a row are rejected.
+ * @brief Informed sampling: rejects samples that can not improve the solution
+ */
+class informed_sampler_t : public sampler_t
+{
+public:
+	/**
+	 * @brief Sampler constructor
+	 * @param base_sampler The sampler of the candidates, the sampler takes ownership
+	 * @param cost_lower_bound Lower bound of the cost of a solution through a state (cost-to-come plus cost-to-go)
+	 * @param max_attempts The maximum number of candidates drawn for one sample
+	 */
+	informed_sampler_t(sampler_t* base_sampler, std::function<double(const double*)> cost_lower_bound,
+	                   unsigned int max_attempts=INFORMED_SAMPLER_MAX_ATTEMPTS);
+
+	void sample(RandomGenerator& random_generator, double best_cost, double* state) override;
+
+	/**
+	 * @brief Return the number of rejected candidates
+	 * @return number of rejected candidates so far
+	 */
+	unsigned long get_number_of_rejections() const
+	{
+		return number_of_rejections;
+	}
+
+private:
+	std::unique_ptr<sampler_t> base_sampler;
+	std::function<double(const double*)> cost_lower_bound;
+	unsigned int max_attempts;
+	unsigned long number_of_rejections;
+};
+
+/**
+ * @brief Hook for external samplers, for example learned ones
+ * @details Hook for external samplers, for example learned ones. The function receives the cost of the
+ * best solution and fills the sample; it does not use the random generator of the planner.
+ */
+class function_sampler_t : public sampler_t
+{
+public:
+	/**
+	 * @brief Sampler constructor
+	 * @param sample_function Function that receives the best cost and fills the sample
+	 */
+	function_sampler_t(std::function<void(double, double*)> sample_function);
+
+	void sample(RandomGenerator& random_generator, double best_cost, double* state) override;
+
+private:
+	std::function<void(double, double*)> sample_function;
+};
+
+#endif
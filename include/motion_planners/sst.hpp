@@ -17,6 +17,8 @@
 
 #include "systems/system.hpp"
 #include "motion_planners/planner.hpp"
+#include "motion_planners/node_arena.hpp"
+#include "utilities/thread_pool.hpp"
 
 class sample_node_t;
 
@@ -36,8 +38,10 @@ public:
 	 * @param a_parent Parent node in the planning graph
 	 * @param a_parent_edge An edge between the parent and this node
 	 * @param a_cost Cost of the edge
+	 * @param storage Memory for the point owned by the caller, the node allocates its own if NULL
 	 */
-	sst_node_t(const double* point, unsigned int state_dimension, sst_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost);
+	sst_node_t(const double* point, unsigned int state_dimension, sst_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost,
+	           double* storage=NULL);
 	~sst_node_t();
 
     /**
@@ -89,19 +93,100 @@ public:
         return this->parent;
     }
 
+    /**
+	 * @brief Return an upper bound of the costs in the subtree of this node
+	 * @details Return an upper bound of the costs in the subtree of this node. Branch and bound
+	 * skips the subtrees whose bound does not exceed the cost of the best goal.
+	 *
+	 * @return upper bound of the subtree costs
+	 */
+    double get_subtree_cost_bound() const {
+        return this->subtree_cost_bound;
+    }
+
+    /**
+	 * @brief Set the upper bound of the costs in the subtree of this node
+	 * @details Set the upper bound of the costs in the subtree of this node
+	 *
+	 * @param bound The new bound
+	 */
+    void set_subtree_cost_bound(double bound) {
+        this->subtree_cost_bound = bound;
+    }
+
+    /**
+	 * @brief Return whether the node is on the path to the best goal
+	 * @details Return whether the node is on the path to the best goal (the root is not marked)
+	 *
+	 * @return whether the node is on the solution path
+	 */
+    bool is_on_solution_path() const {
+        return this->on_solution_path;
+    }
+
+    /**
+	 * @brief Mark or unmark the node as a part of the solution path
+	 * @details Mark or unmark the node as a part of the solution path
+	 *
+	 * @param value Whether the node is on the solution path
+	 */
+    void set_on_solution_path(bool value) {
+        this->on_solution_path = value;
+    }
+
 private:
     /**
      * @brief Parent node.
      */
     sst_node_t* parent;
 
+    /**
+     * @brief Upper bound of the costs in the subtree of this node.
+     */
+    double subtree_cost_bound;
+
 	/**
 	 * A flag for inclusion in the metric.
 	 */
 	bool active;
+
+	/**
+	 * A flag for the nodes on the path to the best goal.
+	 */
+	bool on_solution_path;
     sample_node_t* witness;
 };
 
+/**
+ * Sets the subtree cost bound of a leaf just added to the tree and raises the bounds of its ancestors.
+ * Before the first solution the bounds are infinite, so that the first branch and bound visits the whole tree.
+ * @brief Initializes the subtree cost bound of a new leaf.
+ * @param node The new leaf.
+ * @param has_solution Whether the planner has already found a solution.
+ */
+void init_subtree_cost_bound(sst_node_t* node, bool has_solution);
+
+/**
+ * Moves the solution path marks from the path of the previous best goal to the path of the new one.
+ * Called whenever the best goal changes, so that the solution path membership is a constant time check.
+ * @brief Marks the nodes on the path to a new best goal.
+ * @param previous_goal The previous best goal, NULL if there was none.
+ * @param new_goal The new best goal.
+ */
+void update_solution_path(sst_node_t* previous_goal, sst_node_t* new_goal);
+
+/**
+ * Iterative equivalent of a recursive post-order traversal: children are visited before their parent, in the
+ * order of the children lists, using the parent and sibling links instead of the call stack. Subtrees whose cost
+ * bound does not exceed the threshold are skipped, and the bounds of visited nodes are lowered to the threshold.
+ * The visitor may remove the visited node from the tree.
+ * @brief Visits the nodes of a subtree that may cost more than a threshold.
+ * @param start The root of the subtree.
+ * @param cost_threshold Subtrees without nodes more expensive than this are skipped.
+ * @param visit The function called for every visited node.
+ */
+void visit_costlier_nodes(sst_node_t* start, double cost_threshold, const std::function<void(sst_node_t*)>& visit);
+
 /**
  * @brief A special storage node for witness nodes in SST.
  * @details A special storage node for witness nodes in SST.
@@ -117,9 +202,10 @@ public:
 	 * @param representative SST pointer node
 	 * @param a_point A point in the state space
 	 * @param state_dimension Dimensionality of the state space
+	 * @param storage Memory for the point owned by the caller, the node allocates its own if NULL
 	 */
 	sample_node_t(sst_node_t* const representative,
-	              const double* a_point, unsigned int state_dimension);
+	              const double* a_point, unsigned int state_dimension, double* storage=NULL);
 	~sample_node_t();
 
     /**
@@ -141,17 +227,45 @@ public:
     sst_node_t* get_representative() const {
         return this->rep;
     }
+
+    /**
+	 * @brief Set the distance from the witness to the goal state
+	 * @details Set the distance from the witness to the goal state
+	 *
+	 * @param distance The distance to the goal state
+	 */
+    void set_goal_distance(double distance) {
+        this->goal_distance = distance;
+    }
+
+    /**
+	 * @brief Return the distance from the witness to the goal state
+	 * @details Return the distance from the witness to the goal state
+	 *
+	 * @return distance to the goal state
+	 */
+    double get_goal_distance() const {
+        return this->goal_distance;
+    }
 private:
     /**
 	 * The node that represents this sample.
 	 */
 	sst_node_t* rep;
+
+    /**
+	 * The distance from the witness to the goal state.
+	 */
+	double goal_distance;
 };
 
 
 /**
  * @brief The motion planning algorithm SST (Stable Sparse-RRT)
- * @details The motion planning algorithm SST (Stable Sparse-RRT)
+ * @details The motion planning algorithm SST (Stable Sparse-RRT). This is the SST engine shared by all SST
+ * planners: it owns the tree, the witnesses and the pruning. Planners with other sampling or steering
+ * strategies derive from it and override draw_sample() and extend(), or drive nearest_vertex() and
+ * add_to_tree() directly.
  */
 class sst_t : public planner_t
 {
@@ -169,6 +283,7 @@ public:
 	 * @param random_seed The seed for the random generator
 	 * @param delta_near Near distance threshold for SST
 	 * @param delta_drain Drain distance threshold for SST
+	 * @param nearest_neighbors_factory Creates the nearest neighbor structures (graph_nearest_neighbors_t if empty)
 	 */
 	sst_t(const double* in_start, const double* in_goal,
 	      double in_radius,
@@ -176,7 +291,8 @@ public:
 		  const std::vector<std::pair<double, double> >& a_control_bounds,
 		  std::function<double(const double*, const double*, unsigned int)> distance_function,
 		  unsigned int random_seed,
-		  double delta_near, double delta_drain);
+		  double delta_near, double delta_drain,
+		  nearest_neighbors_factory_t nearest_neighbors_factory=nullptr);
 	virtual ~sst_t();
 
 	/**
@@ -189,17 +305,58 @@ public:
 	 */
 	 virtual void step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step);
 
-protected:
+	/**
+	 * @copydoc planner_t::has_solution()
+	 */
+	virtual bool has_solution() { return best_goal != nullptr; }
 
-    /**
-     * @brief The nearest neighbor data structure.
-     */
-    graph_nearest_neighbors_t metric;
+	/**
+	 * @copydoc planner_t::get_best_cost()
+	 */
+	virtual double get_best_cost() const { return best_goal ? best_goal->get_cost() : std::numeric_limits<double>::infinity(); }
 
 	/**
-	 * @brief The best goal node found so far.
+	 * The distance is the minimum over the roots of all trees, see add_start().
+	 * @copydoc planner_t::get_start_distance()
 	 */
-	sst_node_t* best_goal;
+	virtual double get_start_distance(const double* state) const override;
+
+	/**
+	 * @copydoc planner_t::export_tree()
+	 */
+	virtual void export_tree(tree_data_t& data) const override;
+
+	/**
+	 * The file has to be saved by SST, the witnesses and the inactive nodes are restored.
+	 * @copydoc planner_t::import_tree()
+	 */
+	virtual void import_tree(const tree_file_t& file) override;
+
+	/**
+	 * A bound tighter than the previous one and than the best solution prunes the trees, unless the
+	 * tree is retained. The nodes on the path to the own best goal are kept.
+	 * @copydoc planner_t::set_cost_bound()
+	 */
+	virtual void set_cost_bound(double bound) override;
+
+	/**
+	 * @brief Perform a batch of iterations with the propagations executed in parallel.
+	 * @details Perform a batch of iterations with the propagations executed in parallel.
+	 * Sampling, the nearest neighbor queries and the tree updates stay sequential, only the
+	 * propagations run on a thread pool with one system per thread. The random numbers are drawn
+	 * sequentially and the new nodes are added in sampling order, so the result depends only on the
+	 * random seed and the batch size, not on the number of threads or their timing.
+	 * A sample is dropped if its parent was deactivated by an earlier sample of the same batch.
+	 * With a batch size of one the iterations are identical to step().
+	 *
+	 * @param systems One system per worker thread. The systems must be distinct instances of the same system.
+	 * @param min_time_steps Minimum number of control steps for the system
+	 * @param max_time_steps Maximum number of control steps for the system
+	 * @param integration_step Integration step in seconds to integrate the system
+	 * @param batch_size Number of iterations to perform
+	 */
+	void step_parallel(const std::vector<system_interface*>& systems, int min_time_steps, int max_time_steps,
+	                   double integration_step, unsigned int batch_size);
 
 	/**
 	 * @brief Finds a node to propagate from.
@@ -211,14 +368,158 @@ protected:
 	/**
 	 * @brief If propagation was successful, add the new state to the tree.
 	 * @details If propagation was successful, add the new state to the tree.
+	 *
+	 * @return The new node, NULL if the state was not added
 	 */
-	void add_to_tree(const double* sample_state, const double* sample_control, sst_node_t* nearest, double duration);
+	sst_node_t* add_to_tree(const double* sample_state, const double* sample_control, sst_node_t* nearest, double duration);
+
+	/**
+	 * @brief Finds the cheapest active node near a state.
+	 * @details Finds the cheapest active node closer than a radius to a state.
+	 *
+	 * @param state The query state
+	 * @param radius The radius to search within
+	 * @return The cheapest node, NULL if there is no node within the radius
+	 */
+	sst_node_t* find_cheapest_near(const double* state, double radius);
+
+	/**
+	 * The explored tree and the witnesses are kept, so a new query in the same environment only pays
+	 * for the incremental expansion. The best goal is searched among all tree nodes except the roots,
+	 * including the inactive ones, and the tree is pruned against its cost unless it is retained, see
+	 * set_retain_tree(). Nodes pruned against a previous goal are not restored.
+	 * @brief Change the goal of the planning query without rebuilding the tree.
+	 *
+	 * @param in_goal The new goal state
+	 * @param in_radius The radial size of the goal region centered at in_goal.
+	 */
+	void set_goal(const double* in_goal, double in_radius);
+
+	/**
+	 * Forest mode: the tree of the new start is grown together with the existing trees and a
+	 * solution may start at any of the starts. The first state of the solution path is its start.
+	 * @brief Add a start state with its own tree.
+	 *
+	 * @param in_start The new start state
+	 */
+	void add_start(const double* in_start);
+
+	/**
+	 * The goal check skips the distance computation for nodes whose witness is far from the goal,
+	 * which is only correct if the distance satisfies the triangle inequality. Distances that are
+	 * not metrics, e.g. ones defined in python, have to disable it.
+	 * @brief Set whether the distance function satisfies the triangle inequality.
+	 *
+	 * @param value True if the distance is a metric (the default), false to always compute the exact goal distance.
+	 */
+	void set_metric_distance(bool value) { metric_distance = value; }
+
+	/**
+	 * Multi-query mode: by default the tree is pruned against the cost of the best solution, so
+	 * nodes costlier than the solution of one goal are lost for the next goals. With the tree
+	 * retained, solutions never prune the tree and nodes are not rejected for their cost,
+	 * the tree is only pruned when prune() is called.
+	 * @brief Set whether the tree is kept for later queries.
+	 *
+	 * @param value True to keep the tree, false to prune it with every better solution (the default).
+	 */
+	void set_retain_tree(bool value) { retain_tree = value; }
+
+	/**
+	 * @brief Remove the nodes costlier than the best solution.
+	 * @details Remove the nodes costlier than the best solution, as every new solution does when the
+	 * tree is not retained. Does nothing if there is no solution.
+	 */
+	void prune();
+
+	/**
+	 * @brief Return the roots of the trees
+	 * @details Return the roots of the trees, the root of the first start first
+	 *
+	 * @return roots of the trees
+	 */
+	const std::vector<sst_node_t*>& get_roots() const { return roots; }
+
+protected:
+
+	/**
+	 * @brief Performs an iteration of step().
+	 * @details Performs an iteration of step(): draws a sample, extends the tree from the best near node
+	 * and adds the new state.
+	 *
+	 * @return The new node, NULL if no node was added
+	 */
+	sst_node_t* grow(system_interface* system, int min_time_steps, int max_time_steps, double integration_step);
+
+	/**
+	 * @brief Searches the cheapest node in the goal region and prunes the tree against it.
+	 * @details Searches the cheapest node in the goal region among all tree nodes except the roots,
+	 * makes it the best goal and prunes the tree against its cost.
+	 */
+	void search_best_goal();
+
+	/**
+	 * @brief Draws the state the tree is grown towards.
+	 * @details Sampling strategy of step(). Draws a uniformly random state by default.
+	 *
+	 * @param sample_state Storage for the sample
+	 */
+	virtual void draw_sample(double* sample_state);
+
+	/**
+	 * @brief Extends the tree from a node towards a sample.
+	 * @details Steering strategy of step(). By default the system is propagated with a random control
+	 * for a random number of steps, the sample is ignored.
+	 *
+	 * @param system The system to plan for
+	 * @param nearest The node to extend
+	 * @param sample_state The sample drawn by draw_sample()
+	 * @param control Storage for the control of the new edge
+	 * @param result_state Storage for the new state, may be the same as sample_state
+	 * @param min_time_steps Minimum number of control steps for the system
+	 * @param max_time_steps Maximum number of control steps for the system
+	 * @param integration_step Integration step in seconds to integrate the system
+	 * @param duration The duration of the new edge
+	 * @return True if the new state is valid and should be added to the tree
+	 */
+	virtual bool extend(system_interface* system, const sst_node_t* nearest, const double* sample_state,
+	                    double* control, double* result_state,
+	                    int min_time_steps, int max_time_steps, double integration_step, double& duration);
+
+    /**
+     * @brief The nearest neighbor data structure.
+     */
+    std::unique_ptr<nearest_neighbors_t> metric;
+
+	/**
+	 * @brief The best goal node found so far.
+	 */
+	sst_node_t* best_goal;
 
 	/**
 	 * @brief Check if the currently created state is close to a witness.
-	 * @details Check if the currently created state is close to a witness.
+	 * @details Check if the currently created state is close to a witness. A new witness is created
+	 * at the state if there is none.
+	 *
+	 * @param sample_state The created state
+	 * @param witness_distance Storage for the distance between the state and its witness
+	 * @return The witness of the state
+	 */
+	sample_node_t* find_witness(const double* sample_state, double& witness_distance);
+
+	/**
+	 * Witnesses keep their distance to the goal, so by the triangle inequality a node farther
+	 * than goal_radius plus its witness distance from the goal needs no distance computation.
+	 * Only nodes near the goal region pay for an exact check, and every node does if the distance
+	 * is not a metric, see set_metric_distance().
+	 * @brief Check if a new node is inside the goal region.
+	 *
+	 * @param node The new node
+	 * @param witness The witness of the node
+	 * @param witness_distance The distance between the node and its witness
+	 * @return True if the node is closer than goal_radius to the goal state
 	 */
-	sample_node_t* find_witness(const double* sample_state);
+	bool is_in_goal_region(const sst_node_t* node, const sample_node_t* witness, double witness_distance) const;
 
 	/**
 	 * @brief Checks if this node has any children.
@@ -231,7 +532,7 @@ protected:
 
 	/**
 	 * @brief Checks if this node is on the solution path.
-	 * @details Checks if this node is on the solution path.
+	 * @details Checks if this node is on the solution path. Uses the solution path marks, so it takes constant time.
 	 * 
 	 * @param v The node to check
 	 * @return True if on the solution path, false if not.
@@ -248,16 +549,50 @@ protected:
 
 	/**
 	 * @brief Branch out and prune planning tree
-	 * @details Branch out and prune planning tree
+	 * @details Branch out and prune planning tree. Removes the nodes more expensive than the threshold
+	 * without recursion, visiting only the subtrees whose cost bound exceeds the threshold. The nodes on
+	 * the path to the best goal are kept.
 	 *
 	 * @param node The node from which to branch
+	 * @param cost_threshold The cost above which the nodes are removed
 	 */
-	void branch_and_bound(sst_node_t* node);
+	void branch_and_bound(sst_node_t* node, double cost_threshold);
+
+	/**
+	 * @brief Creates a tree node in the node arena
+	 * @details Creates a tree node in the node arena, the node is not attached to the parent
+	 *
+	 * @param point State space point
+	 * @param parent Parent node in the planning graph
+	 * @param control Control of the edge from the parent
+	 * @param duration Duration of the edge from the parent
+	 * @param cost Cost of the node
+	 * @return the new node
+	 */
+	sst_node_t* create_node(const double* point, sst_node_t* parent, const double* control, double duration, double cost);
+
+	/**
+	 * @brief Creates a witness sample in the witness arena and computes its distance to the goal
+	 * @param representative The node represented by the witness
+	 * @param point State space point
+	 * @return the new witness
+	 */
+	sample_node_t* create_witness(sst_node_t* representative, const double* point);
+
+	/**
+	 * @brief Memory of the tree nodes, their states and parent controls.
+	 */
+	node_arena_t<sst_node_t> node_arena;
+
+	/**
+	 * @brief Memory of the witness samples and their states.
+	 */
+	node_arena_t<sample_node_t> witness_arena;
 
 	/**
 	 * The nearest neighbor structure for witness samples.
 	 */
-	graph_nearest_neighbors_t samples;
+	std::unique_ptr<nearest_neighbors_t> samples;
 
 	/**
 	 * @brief Near distance threshold for SST
@@ -273,6 +608,46 @@ protected:
 	 * @brief Container for witness nodes (to avoid memory leaks)
 	 */
     std::vector<sample_node_t*> witness_nodes;
+
+	/**
+	 * @brief The roots of the trees, one per start state.
+	 */
+	std::vector<sst_node_t*> roots;
+
+	/**
+	 * @brief The worker threads of step_parallel().
+	 */
+	std::unique_ptr<thread_pool_t> thread_pool;
+
+	/**
+	 * @brief Whether removed nodes are kept alive until the end of the parallel batch.
+	 */
+	bool defer_node_deletion;
+
+	/**
+	 * @brief Whether the distance satisfies the triangle inequality, see set_metric_distance().
+	 */
+	bool metric_distance;
+
+	/**
+	 * @brief Whether solutions leave the tree unpruned, see set_retain_tree().
+	 */
+	bool retain_tree;
+
+	/**
+	 * @brief Nodes removed during the parallel batch.
+	 */
+	std::vector<sst_node_t*> removed_nodes;
+
+	/**
+	 * @brief Preallocated samples of the parallel batch.
+	 */
+	std::vector<double> batch_states;
+	std::vector<double> batch_controls;
+	std::vector<double> batch_results;
+	std::vector<int> batch_steps;
+	std::vector<sst_node_t*> batch_nearest;
+	std::vector<char> batch_valid;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,180 @@
+/**
+ * @file tree_file.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_TREE_FILE_HPP
+#define SPARSE_TREE_FILE_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+#define TREE_FILE_MAGIC "SPRTTREE"
+#define TREE_FILE_VERSION 1
+#define TREE_FILE_ALIGNMENT 8
+
+/**
+ * The file starts with this header, followed by the arrays at the given byte offsets. Every array
+ * starts at a multiple of TREE_FILE_ALIGNMENT bytes, so the arrays of a mapped file can be used in place.
+ * Values are stored in the native byte order.
+ * @brief Header of a tree file.
+ */
+struct tree_file_header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t state_dimension;
+    uint32_t control_dimension;
+    uint32_t number_of_nodes;
+    uint32_t number_of_witnesses;
+    uint32_t reserved;
+    uint64_t states_offset;
+    uint64_t controls_offset;
+    uint64_t durations_offset;
+    uint64_t costs_offset;
+    uint64_t parents_offset;
+    uint64_t node_witnesses_offset;
+    uint64_t flags_offset;
+    uint64_t witness_states_offset;
+    uint64_t representatives_offset;
+};
+
+/**
+ * @brief Flag of the nodes that are in the nearest neighbor structure of the planner.
+ */
+#define TREE_FILE_NODE_ACTIVE 1
+
+/**
+ * Nodes are stored so that every parent precedes its children, the roots have the parent -1.
+ * Controls and durations are the ones of the edges from the parents. Witnesses are stored only
+ * by SST, an index of -1 means that there is no witness or representative.
+ * @brief The arrays of a tree in the layout of a tree file.
+ */
+struct tree_data_t
+{
+    unsigned int state_dimension;
+    unsigned int control_dimension;
+    std::vector<double> states;
+    std::vector<double> controls;
+    std::vector<double> durations;
+    std::vector<double> costs;
+    std::vector<int32_t> parents;
+    std::vector<int32_t> node_witnesses;
+    std::vector<uint8_t> flags;
+    std::vector<double> witness_states;
+    std::vector<int32_t> representatives;
+};
+
+/**
+ * The file is memory-mapped read-only and the arrays are used in place, so opening a file
+ * takes constant time and the pages of a large tree are shared by the processes that map it.
+ * Query-only services can read solutions directly from the file, planners import it to continue planning.
+ * Open and format errors throw std::runtime_error.
+ * @brief A read-only memory-mapped tree file.
+ */
+class tree_file_t
+{
+public:
+    /**
+     * @brief Maps a tree file
+     * @param filename The file written by write()
+     */
+    tree_file_t(const std::string& filename);
+    ~tree_file_t();
+
+    tree_file_t(const tree_file_t&) = delete;
+    tree_file_t& operator=(const tree_file_t&) = delete;
+
+    /**
+     * @brief Writes a tree to a file
+     * @param filename The file to write
+     * @param data The tree
+     */
+    static void write(const std::string& filename, const tree_data_t& data);
+
+    unsigned int get_state_dimension() const { return header->state_dimension; }
+    unsigned int get_control_dimension() const { return header->control_dimension; }
+    unsigned int get_number_of_nodes() const { return header->number_of_nodes; }
+    unsigned int get_number_of_witnesses() const { return header->number_of_witnesses; }
+
+    /**
+     * @brief Arrays of the nodes, see tree_data_t
+     */
+    const double* get_states() const { return array<double>(header->states_offset); }
+    const double* get_controls() const { return array<double>(header->controls_offset); }
+    const double* get_durations() const { return array<double>(header->durations_offset); }
+    const double* get_costs() const { return array<double>(header->costs_offset); }
+    const int32_t* get_parents() const { return array<int32_t>(header->parents_offset); }
+    const int32_t* get_node_witnesses() const { return array<int32_t>(header->node_witnesses_offset); }
+    const uint8_t* get_flags() const { return array<uint8_t>(header->flags_offset); }
+
+    /**
+     * @brief Arrays of the witnesses, see tree_data_t
+     */
+    const double* get_witness_states() const { return array<double>(header->witness_states_offset); }
+    const int32_t* get_representatives() const { return array<int32_t>(header->representatives_offset); }
+
+    /**
+     * Checks that the tree has the given dimensions, at least one node, and that all indices are valid
+     * and every parent precedes its children. Throws std::runtime_error otherwise.
+     * @brief Checks the tree before it is imported by a planner
+     * @param state_dimension Dimensionality of the state space of the planner
+     * @param control_dimension Dimensionality of the control space of the planner
+     */
+    void check_tree(unsigned int state_dimension, unsigned int control_dimension) const;
+
+    /**
+     * @brief Finds the cheapest node closer than a radius to a state
+     * @param state The query state
+     * @param radius The radius to search within
+     * @param distance Function that returns distance between two state space points
+     * @return The index of the node, -1 if there is no node within the radius
+     */
+    int find_cheapest_near(const double* state, double radius,
+                           const std::function<double(const double*, const double*, unsigned int)>& distance) const;
+
+    /**
+     * @brief Returns the trajectory from the root to a node, in the format of planner_t::get_solution()
+     * @param node The index of the node
+     * @param solution_path Storage for the states from the root to the node
+     * @param controls Storage for the controls of the edges
+     * @param costs Storage for the durations of the edges
+     */
+    void get_branch(int node, std::vector<std::vector<double>>& solution_path,
+                    std::vector<std::vector<double>>& controls, std::vector<double>& costs) const;
+
+private:
+    template <class value_t>
+    const value_t* array(uint64_t offset) const
+    {
+        return reinterpret_cast<const value_t*>(static_cast<const char*>(mapping) + offset);
+    }
+
+    /**
+     * @brief The mapped file.
+     */
+    void* mapping;
+
+    /**
+     * @brief The size of the mapped file in bytes.
+     */
+    size_t mapping_size;
+
+    /**
+     * @brief The header at the start of the mapping.
+     */
+    const tree_file_header_t* header;
+};
+
+#endif
@@ -15,7 +15,6 @@
 #ifndef SPARSE_TREE_NODE_HPP
 #define SPARSE_TREE_NODE_HPP
 
-#include <list>
 #include <cstddef>
 
 class proximity_node_t;
@@ -34,10 +33,12 @@ public:
 	 * @param a_control A point in the control space
 	 * @param control_dimension Dimensionality of the control space
 	 * @param a_duration The time duration of the edge
+	 * @param storage Memory for the control owned by the caller, the edge allocates its own if NULL
 	 */
-    tree_edge_t(const double* a_control, unsigned int control_dimension, double a_duration)
+    tree_edge_t(const double* a_control, unsigned int control_dimension, double a_duration, double* storage=NULL)
         : duration(a_duration)
-        , control(new double[control_dimension])
+        , control(storage ? storage : new double[control_dimension])
+        , owns_control(storage == NULL)
     {
         if (a_control) {
             std::copy(a_control, a_control + control_dimension, this->control);
@@ -53,6 +54,7 @@ public:
     tree_edge_t(tree_edge_t&& other)
         : duration(other.duration)
         , control(other.control)
+        , owns_control(other.owns_control)
     {
         other.control = nullptr;
         other.duration = -1;
@@ -79,7 +81,7 @@ public:
 	}
 
 	~tree_edge_t() {
-        if (control != NULL) {
+        if (control != NULL && owns_control) {
             delete[] control;
         }
         control = NULL;
@@ -95,6 +97,10 @@ private:
      * @brief The control for this edge.
      */
 	double* control;
+	 /**
+     * @brief Whether the control memory was allocated by the edge.
+     */
+	bool owns_control;
 };
 
 /**
@@ -110,10 +116,12 @@ public:
 	 *
 	 * @param a_point A point in the state space
 	 * @param state_dimension Dimensionality of the state space
+	 * @param storage Memory for the point owned by the caller, the point allocates its own if NULL
 	 */
-	state_point_t(const double* a_point, unsigned int state_dimension)
-	    : point(new double[state_dimension])
+	state_point_t(const double* a_point, unsigned int state_dimension, double* storage=NULL)
+	    : point(storage ? storage : new double[state_dimension])
 	    , prox_node(NULL)
+	    , owns_point(storage == NULL)
 	{
 	    if (a_point) {
             std::copy(a_point, a_point + state_dimension, this->point);
@@ -123,7 +131,7 @@ public:
 	state_point_t(const state_point_t&) = delete;
 
 	virtual ~state_point_t() {
-	    if (point) {
+	    if (point && owns_point) {
 	        delete[] point;
             point = NULL;
 	    }
@@ -167,12 +175,76 @@ private:
      * @brief A pointer to the node in the nearest neighbor structure for easy removal.
      */
     proximity_node_t* prox_node;
+    /**
+     * @brief Whether the point memory was allocated by this object.
+     */
+    bool owns_point;
+};
+
+
+class tree_node_t;
+
+/**
+ * @brief Iterator over the children of a tree node
+ * @details Iterator over the children of a tree node. Follows the sibling links, so it stays valid
+ * when other children are removed, but not when the child it points to is removed.
+ */
+class tree_children_iterator_t
+{
+public:
+    explicit tree_children_iterator_t(tree_node_t* a_node)
+        : node(a_node)
+    {
+    }
+
+    tree_node_t* operator*() const {
+        return node;
+    }
+
+    tree_children_iterator_t& operator++();
+
+    bool operator==(const tree_children_iterator_t& other) const {
+        return node == other.node;
+    }
+
+    bool operator!=(const tree_children_iterator_t& other) const {
+        return node != other.node;
+    }
+
+private:
+    tree_node_t* node;
+};
+
+/**
+ * @brief Range over the children of a tree node
+ * @details Range over the children of a tree node that can be used in range-based for loops without copying the children
+ */
+class tree_children_t
+{
+public:
+    explicit tree_children_t(tree_node_t* a_first_child)
+        : first_child(a_first_child)
+    {
+    }
+
+    tree_children_iterator_t begin() const {
+        return tree_children_iterator_t(first_child);
+    }
+
+    tree_children_iterator_t end() const {
+        return tree_children_iterator_t(NULL);
+    }
+
+private:
+    tree_node_t* first_child;
 };
 
 
 /**
  * @brief A node of the tree
- * @details A node of the tree (state space point, parent and parent edge)
+ * @details A node of the tree (state space point, parent and parent edge).
+ * The children are kept in an intrusive doubly linked list of siblings, so adding and removing
+ * a child takes constant time and does not allocate.
  */
 class tree_node_t: public state_point_t
 {
@@ -185,28 +257,56 @@ public:
 	 * @param state_dimension Dimensionality of the state space
 	 * @param a_parent_edge Edge to the parent node
 	 * @param cost The path cost to this node.
+	 * @param storage Memory for the point owned by the caller, the node allocates its own if NULL
 	 */
-	tree_node_t(const double* a_point, unsigned int state_dimension, tree_edge_t&& a_parent_edge, double a_cost)
-	    : state_point_t(a_point, state_dimension)
+	tree_node_t(const double* a_point, unsigned int state_dimension, tree_edge_t&& a_parent_edge, double a_cost,
+	            double* storage=NULL)
+	    : state_point_t(a_point, state_dimension, storage)
 	    , parent_edge(std::move(a_parent_edge))
 	    , cost(a_cost)
+	    , first_child(NULL)
+	    , next_sibling(NULL)
+	    , prev_sibling(NULL)
 	{
 	}
 
     virtual ~tree_node_t() {
-        for (auto child: this->children) {
+        tree_node_t* child = this->first_child;
+        while (child != NULL) {
+            tree_node_t* next = child->next_sibling;
             delete child;
+            child = next;
         }
 	}
 
 	/**
 	 * @brief Return children of this node
-	 * @details Return children of this node
+	 * @details Return children of this node, the most recently added first
 	 *
-	 * @return children of this node
+	 * @return range over the children of this node
 	 */
-    const std::list<tree_node_t*>& get_children() const {
-        return this->children;
+    tree_children_t get_children() const {
+        return tree_children_t(this->first_child);
+    }
+
+	/**
+	 * @brief Return the most recently added child
+	 * @details Return the most recently added child
+	 *
+	 * @return first child or NULL for leaves
+	 */
+    tree_node_t* get_first_child() const {
+        return this->first_child;
+    }
+
+	/**
+	 * @brief Return the next child of the parent
+	 * @details Return the next child of the parent
+	 *
+	 * @return next sibling or NULL for the last child
+	 */
+    tree_node_t* get_next_sibling() const {
+        return this->next_sibling;
     }
 
 	/**
@@ -217,18 +317,40 @@ public:
 	 * @return child node
 	 */
     tree_node_t* add_child(tree_node_t* node) {
-        this->children.insert(this->children.begin(), node);
+        node->prev_sibling = NULL;
+        node->next_sibling = this->first_child;
+        if (this->first_child != NULL) {
+            this->first_child->prev_sibling = node;
+        }
+        this->first_child = node;
         return node;
     }
 
 	/**
 	 * @brief Remove a child from this node
-	 * @details Remove a child from this node
+	 * @details Remove a child from this node in constant time
 	 *
 	 * @param node Child tree_node_t node
 	 */
     void remove_child(tree_node_t* node) {
-        this->children.remove(node);
+        if (node->prev_sibling != NULL) {
+            node->prev_sibling->next_sibling = node->next_sibling;
+        } else {
+            this->first_child = node->next_sibling;
+        }
+        if (node->next_sibling != NULL) {
+            node->next_sibling->prev_sibling = node->prev_sibling;
+        }
+        node->next_sibling = NULL;
+        node->prev_sibling = NULL;
+    }
+
+	/**
+	 * @brief Forget all children without deleting them
+	 * @details Forget all children without deleting them. Used by owners that release the children themselves.
+	 */
+    void release_children() {
+        this->first_child = NULL;
     }
 
 	/**
@@ -238,7 +360,7 @@ public:
 	 * @return whether the node is leaf (doesn't have children)
 	 */
     bool is_leaf() const {
-        return this->children.size()==0;
+        return this->first_child == NULL;
     }
 
 	/**
@@ -272,9 +394,19 @@ private:
      */
     double cost;
      /**
-     * @brief Children vertices
+     * @brief Most recently added child
      */
-    std::list<tree_node_t*> children;
+    tree_node_t* first_child;
+     /**
+     * @brief Siblings in the children list of the parent
+     */
+    tree_node_t* next_sibling;
+    tree_node_t* prev_sibling;
 };
 
+inline tree_children_iterator_t& tree_children_iterator_t::operator++() {
+    node = node->get_next_sibling();
+    return *this;
+}
+
 #endif
\ No newline at end of file
@@ -16,146 +16,47 @@
 #define SPARSE_GRAPH_NEIGHBORS_HPP
 
 #include <vector>
-#include <unordered_map>
 #include <functional>
 
+#include "nearest_neighbors/nearest_neighbors.hpp"
 #include "utilities/random.hpp"
+#include "utilities/aligned_allocator.hpp"
 
-class state_point_t;
-
-#define INIT_NODE_SIZE    1000
 #define INIT_CAP_NEIGHBORS 200
-#define MAX_KK          2000
-
-/**
- * @brief A node for the nearest neighbor structure.
- * @details A node for the nearest neighbor structure.
- * 
- */
-class proximity_node_t
-{
-    public:
-        /**
-         * @brief Constructor
-         * @param st The node to store.
-         */
-        proximity_node_t( const state_point_t* st );
-
-        /**
-         * Gets the internal node that is represented.
-         * @brief Gets the internal node that is represented.
-         * @return The internal node.
-         */
-        const state_point_t* get_state( ) const;
-
-        /**
-         * Gets the position of the node in the data structure. Used for fast deletion.
-         * @brief Gets the position of the node in the data structure.
-         * @return The index value.
-         */
-        int get_index() const;
-        
-        /**
-         * Sets the position of the node in the data structure. Used for fast deletion.
-         * @brief Sets the position of the node in the data structure.
-         * @param indx The index value.
-         */
-        void set_index( int indx );
-
-        /**
-         * Returns the stored neighbors.
-         * @brief Returns the stored neighbors.
-         * @param nr_neigh Storage for the number of neighbors returned.
-         * @return The neighbor indices.
-         */
-        const std::vector<unsigned int>& get_neighbors() const;
-
-        /**
-         * Adds a node index into this node's neighbor list.
-         * @brief Adds a node index into this node's neighbor list.
-         * @param node The index to add.
-         */
-        void add_neighbor( unsigned int node );
-
-        /**
-         * Deletes a node index from this node's neighbor list.
-         * @brief Deletes a node index from this node's neighbor list.
-         * @param node The index to delete.
-         */
-        void delete_neighbor( unsigned int node );
-
-        /**
-         * Replaces a node index from this node's neighbor list.
-         * @brief Replaces a node index from this node's neighbor list.
-         * @param prev The index to look for.
-         * @param new_index The index to replace with.
-         */
-        void replace_neighbor( unsigned prev, int new_index );
-
-    protected:
-        /**
-         * @brief The node represented.
-         */
-        const state_point_t* state;
-
-        /**
-         * @brief Index in the data structure. Serves as an identifier to other nodes.
-         */
-        int index;
-
-        /**
-         * @brief The neighbor container for this node.
-         */
-        std::vector<unsigned int> neighbors;
-};
-
-
-
-/**
- * Sorts a list of proximity_node_t's. Performed using a quick sort operation. 
- * @param close_nodes The list to sort.
- * @param distances The distances that determine the ordering.
- * @param low The lower index.
- * @param high The upper index.
- */
-void sort( proximity_node_t** close_nodes, double* distances, int low, int high );
-
-/**
- * Performs sorting over a list of nodes. Assumes all nodes before index are sorted.
- * @param close_nodes The list to sort.
- * @param distances The distances that determine the ordering.
- * @param index The index to start from.
- */
-unsigned int resort( proximity_node_t** close_nodes, double* distances, unsigned int index );
 
 /**
  * A proximity structure based on graph literature. Each node maintains a list of neighbors.
  * When performing queries, the graph is traversed to determine other locally close nodes.
+ *
+ * The distance is evaluated through distance_function_t, a callable taking two state points.
+ * With a concrete functor type the distance is inlined into the graph traversal;
+ * graph_nearest_neighbors_t uses the type-erased function given in set_distance().
  * @brief A proximity structure based on graph literature.
  * @author Kostas Bekris
  */
-class graph_nearest_neighbors_t
+template <class distance_function_t>
+class basic_graph_nearest_neighbors_t : public nearest_neighbors_t
 {
     public:
         /**
          * @brief Constructor
-         * @param state The first node to add to the structure.
+         * @param a_distance_function The distance between state points.
          */
-        graph_nearest_neighbors_t();
-        ~graph_nearest_neighbors_t();
+        basic_graph_nearest_neighbors_t(const distance_function_t& a_distance_function=distance_function_t());
+        ~basic_graph_nearest_neighbors_t();
 
         /**
          * Adds a node to the proximity structure
          * @brief Adds a node to the proximity structure
          * @param node The node to insert.
          */
-        void add_node( state_point_t* node );
+        void add_node( state_point_t* node ) override;
         
         /**
          * @brief Removes a node from the structure.
          * @param node
          */
-        void remove_node( state_point_t* node );
+        void remove_node( state_point_t* node ) override;
 
         /**
          * Prints the average degree of all vertices in the data structure.
@@ -170,7 +71,7 @@ class graph_nearest_neighbors_t
          * @param distance The resulting distance between the closest point and the query point.
          * @return The closest point.
          */
-        proximity_node_t* find_closest( const double* state, double* distance ) const;
+        proximity_node_t* find_closest( const double* state, double* distance ) const override;
         
         /**
          * Find the k closest nodes to the query point. This is performed using a graph search starting from sqrt(nr_points) random points.
@@ -181,19 +82,14 @@ class graph_nearest_neighbors_t
          * @param k The number to return.
          * @return The number of nodes actually returned.
          */
-        unsigned int find_k_close( const double* state, proximity_node_t** close_nodes, double* distances, unsigned int k );
+        unsigned int find_k_close( const double* state, proximity_node_t** close_nodes, double* distances, unsigned int k ) override;
         
         /**
-         * Find all nodes within a radius and the closest node. 
-         * @brief Find all nodes within a radius and the closest node.
-         * @param state The query state.
-         * @param close_nodes The returned close nodes.
-         * @param distances The corresponding distances to the query point.
-         * @param delta The radius to search within.
-         * @return The number of nodes returned.
+         * @copydoc nearest_neighbors_t::find_delta_close_and_closest(const double*, proximity_node_t**, double*, double)
          */
-        std::vector<proximity_node_t*> find_delta_close_and_closest( const double* state, double delta );
-        
+        unsigned int find_delta_close_and_closest( const double* state, proximity_node_t** close_nodes, double* distances, double delta ) override;
+        using nearest_neighbors_t::find_delta_close_and_closest;
+
         /**
          * Find all nodes within a radius. 
          * @brief Find all nodes within a radius.
@@ -203,33 +99,59 @@ class graph_nearest_neighbors_t
          * @param delta The radius to search within.
          * @return The number of nodes returned.
          */
-        unsigned int find_delta_close( const double* state, proximity_node_t** close_nodes, double* distances, double delta );
+        unsigned int find_delta_close( const double* state, proximity_node_t** close_nodes, double* distances, double delta ) override;
 
         /**
-         * Set distance function for NN structure
+         * Set distance function for NN structure. Structures with a concrete distance functor
+         * only take the dimension and keep their functor.
          * @brief Set distance function for NN structure
          * @param new_distance distance function that returns distance between state point
+         * @param state_dimension The dimensionality of the stored points.
          */
-        void set_distance(std::function<double(const double*, const double*)> new_distance)
-        {
-            this->distance_function = new_distance;
-        }
+        void set_distance(std::function<double(const double*, const double*)> new_distance, unsigned int state_dimension) override;
 
     protected:
 
         /**
          * @brief Distance function between state space points
          */
-        std::function<double(const double*, const double*)> distance_function;
+        distance_function_t distance_function;
 
         /**
-         * Helper function for determining existance in a list.
-         * @brief Helper function for determining existance in a list.
-         * @param query_node The node to search for.
-         * @return If query_node exists in node_list.
+         * Starts a new query: all nodes become unvisited.
+         * @brief Starts a new query: all nodes become unvisited.
          */
-        bool does_node_exist(std::unordered_map<proximity_node_t*,bool> const& added_nodes, proximity_node_t* query_node);
-        
+        void start_visit();
+
+        /**
+         * Checks if the node was visited by the current query.
+         * @brief Checks if the node was visited by the current query.
+         * @param node The node to check.
+         * @return If the node was visited.
+         */
+        bool is_visited( const proximity_node_t* node ) const
+        {
+            return visited[node->get_slot()] == visit_generation;
+        }
+
+        /**
+         * @brief Marks the node as visited by the current query.
+         * @param node The node to mark.
+         */
+        void mark_visited( const proximity_node_t* node )
+        {
+            visited[node->get_slot()] = visit_generation;
+        }
+
+        /**
+         * @brief Marks the node as not visited by the current query.
+         * @param node The node to unmark.
+         */
+        void unmark_visited( const proximity_node_t* node )
+        {
+            visited[node->get_slot()] = 0;
+        }
+
         /**
          * Determine the number of nodes to sample for initial populations in queries.
          * @brief Determine the number of nodes to sample for initial populations in queries.
@@ -256,15 +178,78 @@ class graph_nearest_neighbors_t
          * @brief Temporary storage for query functions.
          */
         std::vector<double> second_distances;
+
+        /**
+         * @brief Dimensionality of the stored points.
+         */
+        unsigned int point_dimension;
+
+        /**
+         * @brief Distance between consecutive points in the point store (padded point dimension).
+         */
+        unsigned int point_stride;
+
+        /**
+         * @brief Contiguous copy of the coordinates of all stored points, addressed by slot.
+         */
+        std::vector<double, aligned_allocator_t<double> > point_store;
+
+        /**
+         * @brief Slot of every node, parallel to nodes so that queries do not touch the node objects.
+         */
+        std::vector<unsigned int> node_slots;
+
+        /**
+         * @brief Slots released by removed nodes, reused by subsequent insertions.
+         */
+        std::vector<unsigned int> free_slots;
+
+        /**
+         * @brief Generation of the query that visited each slot last.
+         */
+        std::vector<unsigned int> visited;
+
+        /**
+         * @brief Generation of the current query.
+         */
+        unsigned int visit_generation;
     private:
         /**
          * Helper function to compute distance between NN node and state space point
          * @brief Helper function to compute distance between NN node and state space point
-         * @node node NN node
-         * @state state State space point
+         * @param index Index of the NN node
+         * @param state State space point
          * @return distance between state space point, represented by node and state
          */
-        double compute_distance(const proximity_node_t* node, const double* state) const;
+        double compute_distance(unsigned int index, const double* state) const
+        {
+            return this->distance_function(&point_store[node_slots[index] * point_stride], state);
+        }
+
+        /**
+         * @brief Replaces a type-erased distance function.
+         */
+        static void assign_distance(std::function<double(const double*, const double*)>& target,
+                                    const std::function<double(const double*, const double*)>& source)
+        {
+            target = source;
+        }
+
+        /**
+         * @brief Keeps a concrete distance functor.
+         */
+        template <class functor_t>
+        static void assign_distance(functor_t&, const std::function<double(const double*, const double*)>&)
+        {
+        }
+
+        /**
+         * Reserves a slot in the point store and copies the point into it.
+         * @brief Reserves a slot in the point store and copies the point into it.
+         * @param point State space point
+         * @return The reserved slot.
+         */
+        unsigned int store_point(const double* point);
 
         /**
          * @brief Random number generator
@@ -272,4 +257,48 @@ class graph_nearest_neighbors_t
         mutable RandomGenerator random_generator;
 };
 
+/**
+ * @brief Graph proximity structure using the distance function given in set_distance().
+ */
+class graph_nearest_neighbors_t : public basic_graph_nearest_neighbors_t<std::function<double(const double*, const double*)> >
+{
+};
+
+/**
+ * Graph proximity structure specialized for a distance functor type, e.g. one from
+ * systems/distance_functions.h with a fixed state dimension, so that the compiler can
+ * inline and unroll the distance evaluations.
+ * @brief Graph proximity structure specialized for a distance functor type.
+ */
+template <class distance_functor_t>
+class specialized_graph_nearest_neighbors_t : public basic_graph_nearest_neighbors_t<distance_functor_t>
+{
+    public:
+        /**
+         * @brief Constructor
+         * @param a_distance_function The distance between state points.
+         */
+        specialized_graph_nearest_neighbors_t(const distance_functor_t& a_distance_function=distance_functor_t())
+            : basic_graph_nearest_neighbors_t<distance_functor_t>(a_distance_function)
+        {
+        }
+};
+
+/**
+ * @brief Creates a factory of graph proximity structures specialized for a distance functor.
+ * @param a_distance_function The distance between state points.
+ * @return The factory.
+ */
+template <class distance_functor_t>
+nearest_neighbors_factory_t specialized_graph_nearest_neighbors_factory(const distance_functor_t& a_distance_function)
+{
+    return [a_distance_function]() -> nearest_neighbors_t* {
+        return new specialized_graph_nearest_neighbors_t<distance_functor_t>(a_distance_function);
+    };
+}
+
+extern template class basic_graph_nearest_neighbors_t<std::function<double(const double*, const double*)> >;
+
+#include "nearest_neighbors/graph_nearest_neighbors_impl.hpp"
+
 #endif 
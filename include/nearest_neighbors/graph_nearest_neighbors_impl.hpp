@@ -0,0 +1,459 @@
+/**
+ * @file graph_nearest_neighbors_impl.hpp
+ * 
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ * 
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ * 
+ */
+
+#ifndef SPARSE_GRAPH_NEIGHBORS_IMPL_HPP
+#define SPARSE_GRAPH_NEIGHBORS_IMPL_HPP
+
+#include <assert.h>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+#include "nearest_neighbors/graph_nearest_neighbors.hpp"
+#include "motion_planners/tree_node.hpp"
+
+template <class distance_function_t>
+basic_graph_nearest_neighbors_t<distance_function_t>::basic_graph_nearest_neighbors_t(const distance_function_t& a_distance_function)
+    : distance_function(a_distance_function)
+    , nodes()
+    , second_nodes(MAX_KK, nullptr)
+    , second_distances(MAX_KK, 0.)
+    , point_dimension(0)
+    , point_stride(0)
+    , visit_generation(0)
+    , random_generator(0)
+{
+    nodes.reserve(INIT_NODE_SIZE);
+    node_slots.reserve(INIT_NODE_SIZE);
+}
+
+template <class distance_function_t>
+basic_graph_nearest_neighbors_t<distance_function_t>::~basic_graph_nearest_neighbors_t()
+{
+    for (auto n: nodes) {
+        delete n;
+    }
+    nodes.clear();
+}
+
+template <class distance_function_t>
+void basic_graph_nearest_neighbors_t<distance_function_t>::set_distance(std::function<double(const double*, const double*)> new_distance, unsigned int state_dimension)
+{
+    assert( nodes.size() == 0 );
+    assign_distance(this->distance_function, new_distance);
+    point_dimension = state_dimension;
+    point_stride = ((state_dimension + POINT_STORE_STRIDE_MULTIPLE - 1) / POINT_STORE_STRIDE_MULTIPLE) * POINT_STORE_STRIDE_MULTIPLE;
+    point_store.clear();
+    point_store.reserve(INIT_NODE_SIZE * point_stride);
+    free_slots.clear();
+    visited.clear();
+    visited.reserve(INIT_NODE_SIZE);
+}
+
+template <class distance_function_t>
+double basic_graph_nearest_neighbors_t<distance_function_t>::average_valence() const
+{
+    double all_neighs = 0;
+    for( unsigned int i=0; i<nodes.size(); i++ )
+    {
+        all_neighs += nodes[i]->get_neighbors().size();
+    }
+    all_neighs /= (double)nodes.size();
+    return all_neighs;
+}
+
+template <class distance_function_t>
+void basic_graph_nearest_neighbors_t<distance_function_t>::add_node( state_point_t* state )
+{
+    proximity_node_t* graph_node = new proximity_node_t(state);
+	state->set_proximity_node(graph_node);
+
+    int k = percolation_threshold();
+
+    unsigned int new_k = this->find_k_close(graph_node->get_state()->get_point(), &second_nodes[0], &second_distances[0], k );
+
+    graph_node->set_index(nodes.size());
+    graph_node->set_slot(store_point(graph_node->get_state()->get_point()));
+    nodes.push_back(graph_node);
+    node_slots.push_back(graph_node->get_slot());
+
+    for( unsigned int i=0; i<new_k; i++ )
+    {
+	    graph_node->add_neighbor( second_nodes[i]->get_index() );
+	    second_nodes[i]->add_neighbor( graph_node->get_index() );
+    }
+
+}
+ 
+template <class distance_function_t>
+void basic_graph_nearest_neighbors_t<distance_function_t>::remove_node( state_point_t* state )
+{
+    const proximity_node_t* graph_node = state->get_proximity_node();
+    state->set_proximity_node(nullptr);
+
+    const std::vector<unsigned int>& removed_neighbors = graph_node->get_neighbors();
+    for( unsigned int i=0; i<removed_neighbors.size(); i++ ) {
+        nodes[ removed_neighbors[i] ]->delete_neighbor( graph_node->get_index() );
+    }
+
+    free_slots.push_back(graph_node->get_slot());
+
+    unsigned int index = graph_node->get_index();
+    if( index < nodes.size()-1 )
+    {
+        nodes[index] = nodes[nodes.size()-1];
+        nodes[index]->set_index( index );
+        node_slots[index] = node_slots[nodes.size()-1];
+
+        const std::vector<unsigned int>& neighbors = nodes[index]->get_neighbors();
+        for( unsigned int i=0; i<neighbors.size(); i++ )
+            nodes[ neighbors[i] ]->replace_neighbor( nodes.size()-1, index );
+    }
+    nodes.pop_back();
+    node_slots.pop_back();
+
+    delete graph_node;
+}
+
+template <class distance_function_t>
+proximity_node_t* basic_graph_nearest_neighbors_t<distance_function_t>::find_closest( const double* state, double* the_distance ) const
+{
+    if( nodes.size() == 0 )
+        return NULL;
+    
+    unsigned int nr_samples = sampling_function();
+    double min_distance = std::numeric_limits<double>::max();
+    int min_index = -1;
+    for( unsigned int i=0; i<nr_samples; i++ )
+    {
+        int index = random_generator.uniform_int_random(0, nodes.size()-1);
+        double distance = this->compute_distance(index, state);
+        if( distance < min_distance )
+        {
+            min_distance = distance;
+            min_index = index;
+        }
+    }
+
+    int old_min_index = min_index;
+    do {
+        old_min_index = min_index;
+        const std::vector<unsigned int>& neighbors = nodes[min_index]->get_neighbors();
+        for( unsigned int j=0; j<neighbors.size(); j++ )
+        {
+            double distance = this->compute_distance(neighbors[j], state);
+            if( distance < min_distance )
+            {
+            min_distance = distance;
+            min_index = neighbors[j];
+            }
+        }
+    }
+    while( old_min_index != min_index );
+
+    *the_distance = min_distance;
+    return nodes[min_index];
+}
+
+
+template <class distance_function_t>
+unsigned int basic_graph_nearest_neighbors_t<distance_function_t>::find_k_close( const double* state, proximity_node_t** close_nodes, double* distances, unsigned int k )
+{
+    if( nodes.size() == 0 )
+        return 0;
+
+    start_visit();
+    
+	if(k > MAX_KK)
+	{
+		// PRX_WARN_S("Trying to return "<<k<<" points when the max is "<<MAX_KK);
+		k = MAX_KK;
+	}
+
+    if( k < nodes.size() )
+    {
+        for( unsigned int i=0; i<k; i++ )
+        {
+            bool exists = true;
+            int index;
+            while( exists == true )
+            {
+                index = random_generator.uniform_int_random(0, nodes.size()-1);;
+                exists = is_visited(nodes[index]);
+            }
+            close_nodes[i] = nodes[index];
+            mark_visited(nodes[index]);
+            distances[i] = this->compute_distance(index, state);
+        }
+        sort( close_nodes, distances, 0, k-1 );
+
+        unsigned int nr_samples = sampling_function();
+
+        double min_distance = distances[0];
+        unsigned int min_index = close_nodes[0]->get_index();
+        for( unsigned int i=0; i<nr_samples; i++ )
+        {
+            int index = random_generator.uniform_int_random(0, nodes.size()-1);;
+            if( is_visited(nodes[index]) == false )
+            {
+                double distance = this->compute_distance(index, state);
+                if( distance < min_distance )
+                {
+                    min_distance = distance;
+                    min_index = index;
+                }
+            }
+        }
+        if(min_distance!=distances[0])
+        {
+            unmark_visited(close_nodes[k-1]);
+            close_nodes[ k - 1 ] = nodes[min_index];
+            mark_visited(nodes[min_index]);
+            distances[ k - 1 ] = min_distance;
+            resort( close_nodes, distances, k-1 );
+
+        }
+
+        min_index = 0;
+        do
+        {
+            const std::vector<unsigned int>& neighbors = nodes[ close_nodes[min_index]->get_index() ]->get_neighbors();
+            unsigned int lowest_replacement = k;
+            for( unsigned int j=0; j<neighbors.size(); j++ )
+            {
+                if( is_visited(nodes[ neighbors[j] ]) == false )
+                {
+                    double distance = this->compute_distance(neighbors[j], state);
+                    if( distance < distances[k-1] )
+                    {
+                        unmark_visited(close_nodes[k-1]);
+                        close_nodes[k-1] = nodes[ neighbors[j] ];
+                        mark_visited(nodes[neighbors[j]]);
+                        distances[k-1] = distance;
+                        unsigned int test = resort( close_nodes, distances, k-1 );
+                        lowest_replacement = (test<lowest_replacement?test:lowest_replacement);
+                    }
+                }
+            }
+            if(min_index < lowest_replacement)
+                min_index++;
+            else
+                min_index = lowest_replacement;
+        }
+        while( min_index < k );
+
+        return k;
+    }
+    else
+    {
+        for( unsigned int i=0; i<nodes.size(); i++ )
+        {
+            close_nodes[i] = nodes[i];
+            distances[i] = this->compute_distance(i, state);
+        }
+
+        sort( close_nodes, distances, 0, nodes.size()-1 );
+        return nodes.size();
+    }
+}
+
+template <class distance_function_t>
+unsigned int basic_graph_nearest_neighbors_t<distance_function_t>::find_delta_close_and_closest( const double* state, proximity_node_t** close_nodes, double* distances, double delta )
+{
+    if( nodes.size() == 0 )
+        return 0;
+
+    start_visit();
+
+    unsigned int nr_samples = sampling_function();
+    double min_distance = std::numeric_limits<double>::max();;
+    int min_index = -1;
+    for( unsigned int i=0; i<nr_samples; i++ )
+    {
+		int index = random_generator.uniform_int_random(0, nodes.size()-1);;
+		double distance = this->compute_distance(index, state);
+		if( distance < min_distance )
+		{
+		    min_distance = distance;
+		    min_index = index;
+		}
+    }
+   
+    int old_min_index = min_index;
+    do
+    {
+		old_min_index = min_index;
+		const std::vector<unsigned int>& neighbors = nodes[min_index]->get_neighbors();
+		for( unsigned int j=0; j<neighbors.size(); j++ )
+		{
+		    double distance = this->compute_distance(neighbors[j], state);
+		    if( distance < min_distance )
+		    {
+				min_distance = distance;
+				min_index = neighbors[j];			
+		    }
+		}
+    }
+    while( old_min_index != min_index );
+
+    unsigned int nr_points = 0;
+    close_nodes[0] = nodes[min_index];
+    mark_visited(close_nodes[0]);
+    distances[0] = min_distance;
+    nr_points++;
+    if( min_distance < delta )
+    {
+		for( unsigned int counter = 0; counter<nr_points; counter++ )
+		{
+		    const std::vector<unsigned int>& neighbors = close_nodes[counter]->get_neighbors();
+		    for( unsigned int j=0; j<neighbors.size(); j++ )
+		    {
+				if( is_visited(nodes[ neighbors[j] ]) == false )
+				{
+				    double distance = this->compute_distance(neighbors[j], state);
+				    if( distance < delta && nr_points < MAX_KK)
+				    {
+						close_nodes[ nr_points ] = nodes[ neighbors[j] ];
+						mark_visited(close_nodes[nr_points]);
+						distances[ nr_points ] = distance;
+						nr_points++;
+				    }
+				}
+		    }
+		}
+    }
+    return nr_points;
+}
+
+template <class distance_function_t>
+unsigned int basic_graph_nearest_neighbors_t<distance_function_t>::find_delta_close( const double* state, proximity_node_t** close_nodes, double* distances, double delta )
+{
+    if( nodes.size() == 0 )
+        return 0;
+
+    start_visit();
+    unsigned int nr_samples = sampling_function();
+    double min_distance = std::numeric_limits<double>::max();;
+    int min_index = -1;
+    for( unsigned int i=0; i<nr_samples; i++ )
+    {
+		int index = random_generator.uniform_int_random(0, nodes.size()-1);;
+		double distance = this->compute_distance(index, state);
+		if( distance < min_distance )
+		{
+		    min_distance = distance;
+		    min_index = index;
+		}
+    }
+   
+    int old_min_index = min_index;
+    do
+    {
+        old_min_index = min_index;
+        const std::vector<unsigned int>& neighbors = nodes[min_index]->get_neighbors();
+        for( unsigned int j=0; j<neighbors.size(); j++ )
+        {
+            double distance = this->compute_distance(neighbors[j], state);
+            if( distance < min_distance )
+            {
+                min_distance = distance;
+                min_index = neighbors[j];
+            }
+        }
+    }
+    while( old_min_index != min_index );
+
+    unsigned int nr_points = 0;
+    if( min_distance < delta )
+    {
+        close_nodes[0] = nodes[min_index];
+		mark_visited(close_nodes[0]);
+        distances[0]   = min_distance;
+        nr_points++;
+	
+        for( unsigned int counter = 0; counter<nr_points; counter++ )
+		{
+		    const std::vector<unsigned int>& neighbors = close_nodes[counter]->get_neighbors();
+		    for( unsigned int j=0; j<neighbors.size(); j++ )
+		    {
+				if( is_visited(nodes[ neighbors[j] ]) == false )
+				{
+				    double distance = this->compute_distance(neighbors[j], state);
+				    if( distance < delta && nr_points < MAX_KK)
+				    {
+						close_nodes[ nr_points ] = nodes[ neighbors[j] ];
+						mark_visited(close_nodes[nr_points]);
+						distances[ nr_points ] = distance;
+						nr_points++;
+				    }
+				}
+		    }
+		}
+    }
+    return nr_points;
+}
+
+template <class distance_function_t>
+void basic_graph_nearest_neighbors_t<distance_function_t>::start_visit()
+{
+    visit_generation++;
+    if( visit_generation == 0 )
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        visit_generation = 1;
+    }
+}
+
+template <class distance_function_t>
+unsigned int basic_graph_nearest_neighbors_t<distance_function_t>::sampling_function() const
+{
+    if( nodes.size() < 1000 )
+	    return nodes.size()/5 + 1;
+    else
+	    return 200 + nodes.size()/500;
+}
+
+template <class distance_function_t>
+int basic_graph_nearest_neighbors_t<distance_function_t>::percolation_threshold()
+{
+    int k;
+
+    if( nodes.size() > 14)
+	    k = 4.25 * log( nodes.size() );
+    else 
+	    k = nodes.size();
+    return k;
+}
+
+template <class distance_function_t>
+unsigned int basic_graph_nearest_neighbors_t<distance_function_t>::store_point(const double* point)
+{
+    assert( point_stride > 0 );
+    unsigned int slot;
+    if( free_slots.size() > 0 )
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else
+    {
+        slot = point_store.size() / point_stride;
+        point_store.resize(point_store.size() + point_stride, 0.);
+        visited.push_back(0);
+    }
+    std::copy(point, point + point_dimension, &point_store[slot * point_stride]);
+    return slot;
+}
+
+#endif
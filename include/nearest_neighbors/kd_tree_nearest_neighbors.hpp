@@ -0,0 +1,217 @@
+/**
+ * @file kd_tree_nearest_neighbors.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_KD_TREE_NEIGHBORS_HPP
+#define SPARSE_KD_TREE_NEIGHBORS_HPP
+
+#include <vector>
+#include <functional>
+
+#include "nearest_neighbors/nearest_neighbors.hpp"
+#include "utilities/aligned_allocator.hpp"
+#include "utilities/batch_distance.hpp"
+
+#define KD_TREE_BUCKET_SIZE 16
+
+/**
+ * @brief A cell of the kd-tree.
+ * @details A cell of the kd-tree. Internal cells split the space along one dimension,
+ * leaf cells keep a bucket of point slots.
+ */
+class kd_tree_cell_t
+{
+    public:
+        kd_tree_cell_t();
+        ~kd_tree_cell_t();
+
+        /**
+         * @brief Checks if the cell is a leaf.
+         * @return True if the cell keeps a bucket of points.
+         */
+        bool is_leaf() const
+        {
+            return left == nullptr;
+        }
+
+        /**
+         * @brief Splitting dimension of an internal cell.
+         */
+        unsigned int split_dimension;
+
+        /**
+         * @brief Splitting value of an internal cell. Points lower than it are on the left.
+         */
+        double split_value;
+
+        /**
+         * @brief Child cells.
+         */
+        kd_tree_cell_t* left;
+        kd_tree_cell_t* right;
+
+        /**
+         * @brief Slots of the points in a leaf cell.
+         */
+        std::vector<unsigned int> bucket;
+};
+
+/**
+ * An exact proximity structure based on a bucketed kd-tree. Points are inserted
+ * incrementally by splitting overflowing buckets and removed lazily: removed points stay in
+ * their bucket until enough of them accumulate to rebuild the tree.
+ *
+ * Distances are euclidean in the state coordinates, with wrap-around in the circular
+ * dimensions (the same metric as euclidean_distance), so the results are exact when the planner
+ * uses euclidean_distance with the same topology. Circular coordinates are expected
+ * to be kept in [-pi, pi] by the system. The function given in set_distance is not used.
+ * @brief An exact proximity structure based on a kd-tree.
+ */
+class kd_tree_nearest_neighbors_t : public nearest_neighbors_t
+{
+    public:
+        /**
+         * @brief Constructor
+         * @param is_circular_topology Flags for each dimension of the state space whether its circular or not
+         */
+        kd_tree_nearest_neighbors_t(const std::vector<bool>& is_circular_topology);
+        ~kd_tree_nearest_neighbors_t();
+
+        /**
+         * @copydoc nearest_neighbors_t::set_distance()
+         */
+        void set_distance(std::function<double(const double*, const double*)> new_distance, unsigned int state_dimension) override;
+
+        /**
+         * @copydoc nearest_neighbors_t::add_node()
+         */
+        void add_node( state_point_t* node ) override;
+
+        /**
+         * @copydoc nearest_neighbors_t::remove_node()
+         */
+        void remove_node( state_point_t* node ) override;
+
+        /**
+         * @copydoc nearest_neighbors_t::find_closest()
+         */
+        proximity_node_t* find_closest( const double* state, double* distance ) const override;
+
+        /**
+         * @copydoc nearest_neighbors_t::find_k_close()
+         */
+        unsigned int find_k_close( const double* state, proximity_node_t** close_nodes, double* distances, unsigned int k ) override;
+
+        /**
+         * @copydoc nearest_neighbors_t::find_delta_close_and_closest(const double*, proximity_node_t**, double*, double)
+         */
+        unsigned int find_delta_close_and_closest( const double* state, proximity_node_t** close_nodes, double* distances, double delta ) override;
+        using nearest_neighbors_t::find_delta_close_and_closest;
+
+        /**
+         * @copydoc nearest_neighbors_t::find_delta_close()
+         */
+        unsigned int find_delta_close( const double* state, proximity_node_t** close_nodes, double* distances, double delta ) override;
+
+    protected:
+
+        /**
+         * @brief Builds a balanced subtree over the given slots.
+         * @param slots The slots to store. The vector is reordered.
+         * @param begin The first slot to use.
+         * @param end One past the last slot to use.
+         * @return The root of the subtree.
+         */
+        kd_tree_cell_t* build( std::vector<unsigned int>& slots, unsigned int begin, unsigned int end );
+
+        /**
+         * @brief Rebuilds the tree from the live points, releasing the slots of removed points.
+         */
+        void rebuild();
+
+        /**
+         * @brief Squared distance between a query point and the current cell bounds.
+         */
+        double squared_cell_distance( const double* state ) const;
+
+        /**
+         * Visits every live point that may be closer than the current radius. The visitor
+         * receives the slot and squared distance of the point and may shrink the radius.
+         * @brief Depth-first search over the cells.
+         */
+        template <class visitor_t>
+        void search( const kd_tree_cell_t* cell, const double* state, double& squared_radius, visitor_t& visitor ) const;
+
+        /**
+         * @brief Flags for each dimension whether its circular or not.
+         */
+        std::vector<bool> circular_topology;
+
+        /**
+         * @brief Kernel computing the distances to the points of a leaf bucket.
+         */
+        batch_distance_t leaf_distance;
+
+        /**
+         * @brief Squared distances to the points of the visited leaf bucket.
+         */
+        mutable std::vector<double> leaf_distances;
+
+        /**
+         * @brief Dimensionality of the stored points.
+         */
+        unsigned int point_dimension;
+
+        /**
+         * @brief Distance between consecutive points in the point store.
+         */
+        unsigned int point_stride;
+
+        /**
+         * @brief Contiguous copy of the coordinates of all stored points, addressed by slot.
+         */
+        std::vector<double, aligned_allocator_t<double> > point_store;
+
+        /**
+         * @brief Proximity node of every slot, nullptr for removed points.
+         */
+        std::vector<proximity_node_t*> slot_nodes;
+
+        /**
+         * @brief Slots that are not referenced by the tree and can be reused.
+         */
+        std::vector<unsigned int> free_slots;
+
+        /**
+         * @brief Root cell of the tree.
+         */
+        kd_tree_cell_t* root_cell;
+
+        /**
+         * @brief Number of live points.
+         */
+        unsigned int number_of_points;
+
+        /**
+         * @brief Number of removed points still referenced by the tree.
+         */
+        unsigned int number_of_removed;
+
+        /**
+         * @brief Bounds of the cell visited by a query.
+         */
+        mutable std::vector<double> cell_low;
+        mutable std::vector<double> cell_high;
+};
+
+#endif
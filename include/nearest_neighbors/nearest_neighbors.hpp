@@ -0,0 +1,245 @@
+/**
+ * @file nearest_neighbors.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_NEAREST_NEIGHBORS_HPP
+#define SPARSE_NEAREST_NEIGHBORS_HPP
+
+#include <vector>
+#include <functional>
+
+class state_point_t;
+
+#define INIT_NODE_SIZE    1000
+#define MAX_KK          2000
+#define POINT_STORE_STRIDE_MULTIPLE 4
+
+/**
+ * @brief A node for the nearest neighbor structure.
+ * @details A node for the nearest neighbor structure.
+ * 
+ */
+class proximity_node_t
+{
+    public:
+        /**
+         * @brief Constructor
+         * @param st The node to store.
+         */
+        proximity_node_t( const state_point_t* st );
+
+        /**
+         * Gets the internal node that is represented.
+         * @brief Gets the internal node that is represented.
+         * @return The internal node.
+         */
+        const state_point_t* get_state( ) const;
+
+        /**
+         * Gets the position of the node in the data structure. Used for fast deletion.
+         * @brief Gets the position of the node in the data structure.
+         * @return The index value.
+         */
+        int get_index() const;
+        
+        /**
+         * Sets the position of the node in the data structure. Used for fast deletion.
+         * @brief Sets the position of the node in the data structure.
+         * @param indx The index value.
+         */
+        void set_index( int indx );
+
+        /**
+         * Gets the slot of the node's coordinates in the point store. Unlike the index,
+         * the slot does not change while the node is in the data structure.
+         * @brief Gets the slot of the node's coordinates in the point store.
+         * @return The slot value.
+         */
+        unsigned int get_slot() const;
+
+        /**
+         * Sets the slot of the node's coordinates in the point store.
+         * @brief Sets the slot of the node's coordinates in the point store.
+         * @param new_slot The slot value.
+         */
+        void set_slot( unsigned int new_slot );
+
+        /**
+         * Returns the stored neighbors.
+         * @brief Returns the stored neighbors.
+         * @param nr_neigh Storage for the number of neighbors returned.
+         * @return The neighbor indices.
+         */
+        const std::vector<unsigned int>& get_neighbors() const;
+
+        /**
+         * Adds a node index into this node's neighbor list.
+         * @brief Adds a node index into this node's neighbor list.
+         * @param node The index to add.
+         */
+        void add_neighbor( unsigned int node );
+
+        /**
+         * Deletes a node index from this node's neighbor list.
+         * @brief Deletes a node index from this node's neighbor list.
+         * @param node The index to delete.
+         */
+        void delete_neighbor( unsigned int node );
+
+        /**
+         * Replaces a node index from this node's neighbor list.
+         * @brief Replaces a node index from this node's neighbor list.
+         * @param prev The index to look for.
+         * @param new_index The index to replace with.
+         */
+        void replace_neighbor( unsigned prev, int new_index );
+
+    protected:
+        /**
+         * @brief The node represented.
+         */
+        const state_point_t* state;
+
+        /**
+         * @brief Index in the data structure. Serves as an identifier to other nodes.
+         */
+        int index;
+
+        /**
+         * @brief Slot in the point store of the data structure.
+         */
+        unsigned int slot;
+
+        /**
+         * @brief The neighbor container for this node.
+         */
+        std::vector<unsigned int> neighbors;
+};
+
+
+
+/**
+ * Sorts a list of proximity_node_t's. Performed using a quick sort operation. 
+ * @param close_nodes The list to sort.
+ * @param distances The distances that determine the ordering.
+ * @param low The lower index.
+ * @param high The upper index.
+ */
+void sort( proximity_node_t** close_nodes, double* distances, int low, int high );
+
+/**
+ * Performs sorting over a list of nodes. Assumes all nodes before index are sorted.
+ * @param close_nodes The list to sort.
+ * @param distances The distances that determine the ordering.
+ * @param index The index to start from.
+ */
+unsigned int resort( proximity_node_t** close_nodes, double* distances, unsigned int index );
+
+
+/**
+ * @brief Interface of the proximity structures used by the planners.
+ * @details Interface of the proximity structures used by the planners. Every stored
+ * state_point_t is attached to a proximity_node_t owned by the structure.
+ */
+class nearest_neighbors_t
+{
+    public:
+        virtual ~nearest_neighbors_t() {}
+
+        /**
+         * Set distance function for NN structure
+         * @brief Set distance function for NN structure
+         * @param new_distance distance function that returns distance between state point
+         * @param state_dimension The dimensionality of the stored points.
+         */
+        virtual void set_distance(std::function<double(const double*, const double*)> new_distance, unsigned int state_dimension) = 0;
+
+        /**
+         * Adds a node to the proximity structure
+         * @brief Adds a node to the proximity structure
+         * @param node The node to insert.
+         */
+        virtual void add_node( state_point_t* node ) = 0;
+
+        /**
+         * @brief Removes a node from the structure.
+         * @param node
+         */
+        virtual void remove_node( state_point_t* node ) = 0;
+
+        /**
+         * Returns the closest node in the data structure.
+         * @brief Returns the closest node in the data structure.
+         * @param state The query point.
+         * @param distance The resulting distance between the closest point and the query point.
+         * @return The closest point.
+         */
+        virtual proximity_node_t* find_closest( const double* state, double* distance ) const = 0;
+
+        /**
+         * Find the k closest nodes to the query point.
+         * @brief Find the k closest nodes to the query point.
+         * @param state The query state.
+         * @param close_nodes The returned close nodes.
+         * @param distances The corresponding distances to the query point.
+         * @param k The number to return.
+         * @return The number of nodes actually returned.
+         */
+        virtual unsigned int find_k_close( const double* state, proximity_node_t** close_nodes, double* distances, unsigned int k ) = 0;
+
+        /**
+         * Find all nodes within a radius and the closest node. The closest node is returned first.
+         * The output buffers have to hold MAX_KK entries.
+         * @brief Find all nodes within a radius and the closest node.
+         * @param state The query state.
+         * @param close_nodes The returned close nodes.
+         * @param distances The corresponding distances to the query point.
+         * @param delta The radius to search within.
+         * @return The number of nodes returned.
+         */
+        virtual unsigned int find_delta_close_and_closest( const double* state, proximity_node_t** close_nodes, double* distances, double delta ) = 0;
+
+        /**
+         * Find all nodes within a radius and the closest node. The closest node is returned first.
+         * Allocates the result, use the overload with output buffers in planning loops.
+         * @brief Find all nodes within a radius and the closest node.
+         * @param state The query state.
+         * @param delta The radius to search within.
+         * @return The found nodes.
+         */
+        std::vector<proximity_node_t*> find_delta_close_and_closest( const double* state, double delta )
+        {
+            std::vector<proximity_node_t*> close_nodes(MAX_KK);
+            std::vector<double> distances(MAX_KK);
+            close_nodes.resize(find_delta_close_and_closest(state, &close_nodes[0], &distances[0], delta));
+            return close_nodes;
+        }
+
+        /**
+         * Find all nodes within a radius.
+         * @brief Find all nodes within a radius.
+         * @param state The query state.
+         * @param close_nodes The returned close nodes.
+         * @param distances The corresponding distances to the query point.
+         * @param delta The radius to search within.
+         * @return The number of nodes returned.
+         */
+        virtual unsigned int find_delta_close( const double* state, proximity_node_t** close_nodes, double* distances, double delta ) = 0;
+};
+
+/**
+ * @brief Creates the proximity structure a planner should use.
+ */
+typedef std::function<nearest_neighbors_t*()> nearest_neighbors_factory_t;
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file batch_propagation.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_BATCH_PROPAGATION_HPP
+#define SPARSE_BATCH_PROPAGATION_HPP
+
+#include <algorithm>
+
+#define PROPAGATE_BATCH_LANES 8
+
+/**
+ * @brief One coordinate of the states propagated together, one value per lane.
+ */
+typedef double batch_lanes_t[PROPAGATE_BATCH_LANES];
+
+/**
+ * Propagates a batch of states in chunks of PROPAGATE_BATCH_LANES. Every chunk is transposed
+ * into structure-of-arrays form, so that the integration step of a system is written as loops
+ * over the lanes that the compiler can vectorize. Lanes whose propagation has ended keep
+ * their state, and unused lanes of the last chunk repeat its last state without steps.
+ *
+ * The step functor integrates all lanes at once:
+ *   void step(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+ * and includes the enforced state bounds. The validity functor checks one lane:
+ *   bool valid(const batch_lanes_t* state, unsigned int lane)
+ *
+ * @brief Structure-of-arrays driver of system_interface::propagate_batch().
+ *
+ * @tparam state_dimension The dimensionality of the state space.
+ * @tparam control_dimension The dimensionality of the control space.
+ * @tparam stop_at_invalid Whether a propagation ends at its first invalid state, with the last
+ * valid state as its result. Otherwise it runs all its steps, ends in its last state, and is
+ * valid if all its states are.
+ * @param initial_validity The validity of a propagation without steps.
+ */
+template <unsigned int state_dimension, unsigned int control_dimension, bool stop_at_invalid, class step_t, class valid_t>
+void propagate_lanes(
+    step_t step, valid_t valid, bool initial_validity,
+    const double* start_states, const double* controls, const int* num_steps,
+    unsigned int number_of_states, double* result_states, bool* validity, double integration_step)
+{
+    batch_lanes_t state[state_dimension];
+    batch_lanes_t next[state_dimension];
+    batch_lanes_t result[state_dimension];
+    batch_lanes_t control[control_dimension];
+    int steps[PROPAGATE_BATCH_LANES];
+    bool lane_validity[PROPAGATE_BATCH_LANES];
+
+    for(unsigned int first = 0; first < number_of_states; first += PROPAGATE_BATCH_LANES)
+    {
+        unsigned int number_of_lanes = std::min<unsigned int>(PROPAGATE_BATCH_LANES, number_of_states - first);
+        int max_steps = 0;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            unsigned int sample = first + std::min(lane, number_of_lanes - 1);
+            for(unsigned int d = 0; d < state_dimension; d++)
+            {
+                state[d][lane] = start_states[sample * state_dimension + d];
+                // A propagation that ends before its first valid state leaves the result untouched
+                if(stop_at_invalid)
+                    result[d][lane] = result_states[sample * state_dimension + d];
+            }
+            for(unsigned int c = 0; c < control_dimension; c++)
+                control[c][lane] = controls[sample * control_dimension + c];
+            steps[lane] = lane < number_of_lanes ? num_steps[sample] : 0;
+            lane_validity[lane] = initial_validity;
+            max_steps = std::max(max_steps, steps[lane]);
+        }
+
+        for(int i = 0; i < max_steps; i++)
+        {
+            step(state, control, integration_step, next);
+            bool running = false;
+            for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+            {
+                if(i >= steps[lane])
+                    continue;
+                for(unsigned int d = 0; d < state_dimension; d++)
+                    state[d][lane] = next[d][lane];
+                if(!stop_at_invalid)
+                {
+                    lane_validity[lane] = lane_validity[lane] && valid(state, lane);
+                }
+                else if(valid(state, lane))
+                {
+                    for(unsigned int d = 0; d < state_dimension; d++)
+                        result[d][lane] = state[d][lane];
+                    lane_validity[lane] = true;
+                }
+                else
+                {
+                    lane_validity[lane] = false;
+                    steps[lane] = i;
+                }
+                running = running || i + 1 < steps[lane];
+            }
+            if(!running)
+                break;
+        }
+
+        for(unsigned int lane = 0; lane < number_of_lanes; lane++)
+        {
+            for(unsigned int d = 0; d < state_dimension; d++)
+                result_states[(first + lane) * state_dimension + d] = stop_at_invalid ? result[d][lane] : state[d][lane];
+            validity[first + lane] = lane_validity[lane];
+        }
+    }
+}
+
+#endif
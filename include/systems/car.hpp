@@ -18,17 +18,15 @@
 #include "systems/system.hpp"
 
 
-class car_t : public system_t
+class car_t : public system_t, public reversible_system_interface
 {
 public:
 	car_t()
 	{
 		state_dimension = 3;
 		control_dimension = 2;
-		temp_state = new double[state_dimension];
-		deriv = new double[state_dimension];
 	}
-	virtual ~car_t(){delete temp_state;}
+	virtual ~car_t(){}
 
     /**
 	 * @copydoc system_t::propagate()
@@ -38,15 +36,32 @@ public:
         const double* control, unsigned int control_dimension,
         int num_steps, double* result_state, double integration_step);
 
+	/**
+	 * @copydoc system_interface::propagate_batch()
+	 */
+	void propagate_batch(
+	    const double* start_states, unsigned int state_dimension,
+	    const double* controls, unsigned int control_dimension,
+	    const int* num_steps, unsigned int number_of_states,
+	    double* result_states, bool* valid, double integration_step) override;
+
+	/**
+	 * @copydoc reversible_system_interface::propagate_backward()
+	 */
+	virtual bool propagate_backward(
+	    const double* end_state, unsigned int state_dimension,
+        const double* control, unsigned int control_dimension,
+	    int num_steps, double* result_state, double integration_step) override;
+
     /**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 
 	/**
 	 * @copydoc system_t::visualize_point()
@@ -68,8 +83,7 @@ public:
 	 */
 	std::vector<bool> is_circular_topology() const override;
 protected:
-	double* deriv;
-	void update_derivative(const double* control);
+	void update_derivative(const double* state, const double* control, double* derivative) const;
 
 };
 
@@ -16,6 +16,7 @@
 #define SPARSE_CAR_OBS_HPP
 
 #include "systems/enhanced_system.hpp"
+#include "utilities/obstacle_grid.hpp"
 
 class car_obs_t : public enhanced_system_t
 {
@@ -24,9 +25,8 @@ public:
 	{
 		state_dimension = 3;
 		control_dimension = 2;
-		temp_state = new double[state_dimension];
-		deriv = new double[state_dimension];
 		obs_width = width;
+		std::vector<std::vector<double>> obs_boxes;
 		for(unsigned i=0;i<_obs_list.size();i++)
         {
             // each obstacle is represented by its middle point
@@ -43,6 +43,7 @@ public:
             obs[2][0] = x + width / 2;  obs[2][1] = y + width / 2;
             obs[3][0] = x - width / 2;  obs[3][1] = y + width / 2;
             obs_list.push_back(obs);
+            obs_boxes.push_back({x - width / 2, x + width / 2, y - width / 2, y + width / 2});
 
 			// horizontal axis and vertical
             std::vector<std::vector<double>> obs_axis_i(2, std::vector<double> (2, 0));
@@ -71,18 +72,18 @@ public:
 
             obs_ori.push_back(obs_ori_i);
         }
+        obstacle_grid = obstacle_grid_t(obs_boxes, 2);
 		//std::cout << "after initialization" << std::endl;
 	}
 	virtual ~car_obs_t()
 	{
-		delete temp_state;
-		delete deriv;
 		obs_list.clear();
         obs_axis.clear();
         obs_ori.clear();
 	}
 
     /**
+	 * The propagation stops at the first collision, the result is the last valid state.
 	 * @copydoc system_t::propagate()
 	 */
 	virtual bool propagate(
@@ -90,15 +91,24 @@ public:
         const double* control, unsigned int control_dimension,
         int num_steps, double* result_state, double integration_step);
 
+	/**
+	 * @copydoc system_interface::propagate_batch()
+	 */
+	void propagate_batch(
+	    const double* start_states, unsigned int state_dimension,
+	    const double* controls, unsigned int control_dimension,
+	    const int* num_steps, unsigned int number_of_states,
+	    double* result_states, bool* valid, double integration_step) override;
+
     /**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 
 	/**
 	 * @copydoc system_t::visualize_point()
@@ -121,6 +131,11 @@ public:
 	std::vector<bool> is_circular_topology() const override;
     
 	double get_loss(double* state, const double* goal, double* weight);
+
+	/**
+	 * @copydoc enhanced_system_t::get_loss_batch()
+	 */
+	void get_loss_batch(double* states, unsigned int number_of_states, const double* goal, double* weight, double* losses) override;
     
 	/**
 	 * normalize state to [-1,1]^4
@@ -133,18 +148,26 @@ public:
 	void denormalize(double* normalized,  double* state);
 	static double distance(const double* point1, const double* point2, unsigned int);
 
-	bool overlap(std::vector<std::vector<double>>& b1corner, std::vector<std::vector<double>>& b1axis,
-	             std::vector<double>& b1orign, std::vector<double>& b1ds,
-				 std::vector<std::vector<double>>& b2corner, std::vector<std::vector<double>>& b2axis,
-				 std::vector<double>& b2orign, std::vector<double>& b2ds);
+	bool overlap(const std::vector<std::vector<double>>& b1corner, const std::vector<std::vector<double>>& b1axis,
+	             const std::vector<double>& b1orign, const std::vector<double>& b1ds,
+				 const std::vector<std::vector<double>>& b2corner, const std::vector<std::vector<double>>& b2axis,
+				 const std::vector<double>& b2orign, const std::vector<double>& b2ds) const;
 
 protected:
-	double* deriv;
-	void update_derivative(const double* control);
+	void update_derivative(const double* state, const double* control, double* derivative) const;
+
+	/**
+	 * @brief Determine if the car sweeps through an obstacle between two consecutive states, or leaves the bounds.
+	 * @return True if the motion was valid, false if not.
+	 */
+	bool valid_sweep(const double* from_state, const double* state) const;
+
     std::vector<std::vector<std::vector<double>>> obs_list;
 	double obs_width;
     std::vector<std::vector<std::vector<double>>> obs_axis;
     std::vector<std::vector<double>> obs_ori;
+    // broad phase of the collision checks, over the bounding boxes of obs_list
+    obstacle_grid_t obstacle_grid;
 };
 
 
@@ -18,19 +18,15 @@
 
 #include "systems/system.hpp"
 
-class cart_pole_t : public system_t
+class cart_pole_t : public integrated_system_t
 {
 public:
 	cart_pole_t()
 	{
 		state_dimension = 4;
 		control_dimension = 1;
-		temp_state = new double[state_dimension];
-		deriv = new double[state_dimension];
 	}
 	virtual ~cart_pole_t(){
-	    delete temp_state;
-	    delete deriv;
 	}
 
 	/**
@@ -41,15 +37,24 @@ public:
         const double* control, unsigned int control_dimension,
 	    int num_steps, double* result_state, double integration_step);
 
+	/**
+	 * @copydoc system_interface::propagate_batch()
+	 */
+	void propagate_batch(
+	    const double* start_states, unsigned int state_dimension,
+	    const double* controls, unsigned int control_dimension,
+	    const int* num_steps, unsigned int number_of_states,
+	    double* result_states, bool* valid, double integration_step) override;
+
 	/**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 	
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 
 	/**
 	 * @copydoc system_t::visualize_point(double*, svg::Dimensions)
@@ -71,9 +76,13 @@ public:
 	 */
     std::vector<bool> is_circular_topology() const override;
 
+    /**
+	 * @copydoc integrated_system_t::is_velocity()
+	 */
+    std::vector<bool> is_velocity() const override;
+
 protected:
-	double* deriv;
-	void update_derivative(const double* control);
+	void update_derivative(const double* state, const double* control, double* derivative) const override;
 };
 
 
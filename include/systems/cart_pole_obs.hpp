@@ -17,6 +17,7 @@
 
 
 #include "systems/enhanced_system.hpp"
+#include "utilities/obstacle_grid.hpp"
 
 class cart_pole_obs_t : public enhanced_system_t
 {
@@ -29,9 +30,8 @@ public:
 	{
 		state_dimension = 4;
 		control_dimension = 1;
-		temp_state = new double[state_dimension];
-		deriv = new double[state_dimension];
 		// copy the items from _obs_list to obs_list
+		std::vector<std::vector<double>> obs_boxes;
 		for(unsigned i=0;i<_obs_list.size();i++)
 		{
 			// each obstacle is represented by its middle point
@@ -46,11 +46,11 @@ public:
 			obs[4] = x + width / 2;  obs[5] = y - width / 2;
 			obs[6] = x - width / 2;  obs[7] = y - width / 2;
 			obs_list.push_back(obs);
+			obs_boxes.push_back({x - width / 2, x + width / 2, y - width / 2, y + width / 2});
 		}
+		obstacle_grid = obstacle_grid_t(obs_boxes, 2);
 	}
 	virtual ~cart_pole_obs_t(){
-	    delete temp_state;
-	    delete deriv;
 		// clear the vector
 		obs_list.clear();
 	}
@@ -63,15 +63,24 @@ public:
         const double* control, unsigned int control_dimension,
 	    int num_steps, double* result_state, double integration_step);
 
+	/**
+	 * @copydoc system_interface::propagate_batch()
+	 */
+	void propagate_batch(
+	    const double* start_states, unsigned int state_dimension,
+	    const double* controls, unsigned int control_dimension,
+	    const int* num_steps, unsigned int number_of_states,
+	    double* result_states, bool* valid, double integration_step) override;
+
 	/**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 
 	/**
 	 * @copydoc system_t::visualize_point(double*, svg::Dimensions)
@@ -97,6 +106,11 @@ public:
 	
 	double get_loss(double* state, const double* goal, double* weight);
 
+	/**
+	 * @copydoc enhanced_system_t::get_loss_batch()
+	 */
+	void get_loss_batch(double* states, unsigned int number_of_states, const double* goal, double* weight, double* losses) override;
+
 	/**
 	 * normalize state to [-1,1]^4
 	 */
@@ -112,13 +126,42 @@ public:
 
 
 protected:
-	double* deriv;
-	void update_derivative(const double* control);
+	/**
+	 * @brief Trigonometric terms of a state, shared by the derivative and the collision check of a step.
+	 */
+	struct kinematics_t
+	{
+		double sin_theta;
+		double cos_theta;
+	};
+
+	void update_derivative(const double* state, const double* control, const kinematics_t& kinematics, double* derivative) const;
+
+	/**
+	 * @brief Computes the trigonometric terms of a state.
+	 */
+	void update_kinematics(const double* state, kinematics_t& kinematics) const;
+
+	/**
+	 * @brief Determine if a state is in collision or out of bounds, given its trigonometric terms.
+	 * @return True if this state was valid, false if not.
+	 */
+	bool valid_kinematics(const double* state, const kinematics_t& kinematics) const;
+
+	/**
+	 * @brief Determine if the pole sweeps through an obstacle between two consecutive states, or the cart leaves the bounds.
+	 * @return True if the motion was valid, false if not.
+	 */
+	bool valid_sweep(const double* from_state, const kinematics_t& from_kinematics,
+	                 const double* state, const kinematics_t& kinematics) const;
+
 	// for obstacle
 	std::vector<std::vector<double>> obs_list;
+	// broad phase of the collision checks, over the bounding boxes of obs_list
+	obstacle_grid_t obstacle_grid;
 	// collision checker
 	// from http://www.jeffreythompson.org/collision-detection/line-rect.php
-	bool lineLine(double x1, double y1, double x2, double y2, double x3, double y3, double x4, double y4);
+	bool lineLine(double x1, double y1, double x2, double y2, double x3, double y3, double x4, double y4) const;
 };
 
 
@@ -78,6 +78,16 @@ public:
         return std::sqrt(result);
     };
 
+    /**
+     * @brief Return the topology the distance is computed for
+     * @details Return the topology the distance is computed for
+     *
+     * @return flags for each dimension in the state space whether its circular or not
+     */
+    const std::vector<bool>& is_circular_topology() const {
+        return _is_circular_topology;
+    }
+
 private:
     std::vector<bool> _is_circular_topology;
 };
@@ -106,4 +116,73 @@ public:
     double distance(const double* point1, const double* point2, unsigned int state_dimensions) const override;
 };
 
+
+/**
+ * @brief Euclidean distance with the dimension and topology fixed at compile time
+ * @details Euclidean distance with the dimension and topology fixed at compile time, so that the
+ * loop over the dimensions is unrolled when it is inlined into the nearest neighbor queries.
+ * Computes the same values as euclidean_distance.
+ *
+ * @tparam DIMENSION Dimensionality of the state space
+ * @tparam CIRCULAR_MASK Bit i is set if dimension i has circular topology
+ */
+template <unsigned int DIMENSION, unsigned int CIRCULAR_MASK=0>
+struct fixed_euclidean_distance_t
+{
+    double operator()(const double* point1, const double* point2) const {
+        double result = 0;
+        for (unsigned int i=0; i<DIMENSION; ++i) {
+            if (CIRCULAR_MASK & (1u << i)) {
+                double val = fabs(point1[i]-point2[i]);
+                if(val > M_PI)
+                    val = 2*M_PI-val;
+                result += val*val;
+            } else {
+                result += (point1[i]-point2[i]) * (point1[i]-point2[i]);
+            }
+        }
+        return std::sqrt(result);
+    }
+};
+
+
+/**
+ * @brief Distance of a system with a fixed state dimension
+ * @details Distance of a system with a fixed state dimension, calls the static distance of the system directly.
+ *
+ * @tparam system_t System class with a static distance function
+ * @tparam DIMENSION Dimensionality of the state space
+ */
+template <class system_t, unsigned int DIMENSION>
+struct system_distance_t
+{
+    double operator()(const double* point1, const double* point2) const {
+        return system_t::distance(point1, point2, DIMENSION);
+    }
+};
+
+
+/**
+ * @brief Functor holding a distance_t implementation by value
+ * @details Functor holding a distance_t implementation by value. The dynamic type of the held
+ * object is known, so its distance is called without virtual dispatch.
+ *
+ * @tparam distance_class_t Concrete distance_t implementation
+ */
+template <class distance_class_t>
+struct concrete_distance_t
+{
+    concrete_distance_t(const distance_class_t& a_metric, unsigned int a_state_dimension)
+        : metric(a_metric)
+        , state_dimension(a_state_dimension)
+    { };
+
+    double operator()(const double* point1, const double* point2) const {
+        return metric.distance(point1, point2, state_dimension);
+    }
+
+    distance_class_t metric;
+    unsigned int state_dimension;
+};
+
 #endif //SPARSERRT_DISTANCE_FUNCTIONS_H
@@ -19,6 +19,7 @@
 
 #include "systems/distance_functions.h"
 #include "systems/system.hpp"
+#include "utilities/batch_distance.hpp"
 
 /**
  * A minimal interface for a controllable system.
@@ -92,7 +93,7 @@ struct enhanced_system_interface : system_interface {
 class enhanced_system_t: public enhanced_system_interface
 {
 public:
-	enhanced_system_t(){}
+	enhanced_system_t() : continuous_collision_checking(false) {}
 	virtual ~enhanced_system_t(){}
 
     /**
@@ -140,6 +141,24 @@ public:
 
 	virtual double get_loss(double* state, const double* goal, double* weight) = 0;
 
+	/**
+	 * @brief Computes the loss of many states to the same goal.
+	 * @details Computes the loss of many states to the same goal. Systems whose loss is a weighted
+	 * euclidean distance override it with weighted_euclidean_loss_batch().
+	 *
+	 * @param states The states, stored one after another.
+	 * @param number_of_states The number of states.
+	 * @param goal The goal state.
+	 * @param weight The loss weight of every dimension.
+	 * @param losses Storage for the loss of every state.
+	 */
+	virtual void get_loss_batch(double* states, unsigned int number_of_states, const double* goal, double* weight, double* losses)
+	{
+		for(unsigned int i = 0; i < number_of_states; i++){
+			losses[i] = get_loss(&states[i * state_dimension], goal, weight);
+		}
+	}
+
 	/**
 	 * normalize state to [-1,1]^4
 	 */
@@ -151,15 +170,36 @@ public:
 	virtual void denormalize(double* normalized, double* state) = 0;
 
 	/**
-	 * valid_state
+	 * @brief Determine if a state is in collision or out of bounds.
+	 * @details Determine if a state is in collision or out of bounds. The query does not modify
+	 * the system, so several threads may check states of the same system at once.
+	 *
+	 * @param state The state to check.
+	 * @return True if this state was valid, false if not.
 	 */
-	virtual bool valid_state() = 0;
+	virtual bool valid_state(const double* state) const = 0;
 
+	/**
+	 * @brief Selects how propagate() checks collisions.
+	 * @details Selects how propagate() checks collisions. Discrete checks test the states of the
+	 * integration steps, continuous checks test the region swept between consecutive states, so
+	 * that coarse integration steps can not pass through obstacles. Systems without continuous
+	 * checks always check discretely.
+	 *
+	 * @param continuous True for continuous checks, false for discrete checks.
+	 */
+	void set_continuous_collision_checking(bool continuous)
+	{
+		continuous_collision_checking = continuous;
+	}
 
 	/**
-	 * @brief Intermediate storage for propagation.
+	 * @brief Whether propagate() checks collisions continuously.
 	 */
-	double* temp_state;
+	bool get_continuous_collision_checking() const
+	{
+		return continuous_collision_checking;
+	}
 
 
 protected:
@@ -167,8 +207,21 @@ protected:
 	/**
 	 * @brief Enforce bounds on the state space.
 	 * @details Enforce bounds on the state space.
+	 *
+	 * @param state The state to bound, it is updated in place.
 	 */
-	virtual void enforce_bounds() = 0;
+	virtual void enforce_bounds(double* state) const = 0;
+
+	/**
+	 * @brief Weighted euclidean loss of many states, with wrap-around in the circular dimensions.
+	 * @details Weighted euclidean loss of many states, with wrap-around in the circular dimensions.
+	 * The batch kernel is built per call, so several threads may compute losses with the same system.
+	 */
+	void weighted_euclidean_loss_batch(const double* states, unsigned int number_of_states, const double* goal, const double* weight, double* losses) const
+	{
+		batch_distance_t loss_distance(is_circular_topology(), std::vector<double>(weight, weight + state_dimension));
+		loss_distance.distances(goal, states, state_dimension, number_of_states, losses);
+	}
 
 	/**
 	 * @brief Determine if the current state is in collision or out of bounds.
@@ -186,6 +239,10 @@ protected:
 	 */
 	unsigned control_dimension;
 
+	/**
+	 * @brief Whether propagate() checks the regions swept between consecutive states.
+	 */
+	bool continuous_collision_checking;
 
 };
 
@@ -0,0 +1,172 @@
+/**
+ * @file integrator.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_INTEGRATOR_HPP
+#define SPARSE_INTEGRATOR_HPP
+
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+#define RK45_DEFAULT_TOLERANCE 1e-6
+#define RK45_MAX_SUBSTEPS 256
+
+/**
+ * A reference to a callable with the signature void(const double* state, const double* control, double* derivative).
+ * Unlike std::function, the reference is built without copying the callable, so the systems can pass a
+ * lambda to the integrator on every step. The callable has to outlive the reference.
+ * @brief Computes the time derivative of a state under a control.
+ */
+class derivative_function_t
+{
+public:
+	template <class function_t,
+	          class = typename std::enable_if<!std::is_same<function_t, derivative_function_t>::value>::type>
+	derivative_function_t(const function_t& function)
+		: function(&function)
+		, invoke([](const void* function, const double* state, const double* control, double* derivative) {
+			(*static_cast<const function_t*>(function))(state, control, derivative);
+		})
+	{
+	}
+
+	void operator()(const double* state, const double* control, double* derivative) const
+	{
+		invoke(function, state, control, derivative);
+	}
+
+private:
+	const void* function;
+	void (*invoke)(const void* function, const double* state, const double* control, double* derivative);
+};
+
+/**
+ * @brief Numerical integration scheme of a system.
+ * @details Numerical integration scheme of a system. An integrator advances a state by one
+ * integration step of propagate(), the system enforces its state bounds after every step.
+ * The intermediate stages are stored per thread, so one integrator may step several states at once.
+ */
+class integrator_t
+{
+public:
+	/**
+	 * @brief Integrator constructor
+	 * @param state_dimension Dimensionality of the state space
+	 */
+	integrator_t(unsigned int state_dimension);
+	virtual ~integrator_t() {}
+
+	/**
+	 * @brief Advances a state by one integration step.
+	 * @details Advances a state by one integration step.
+	 *
+	 * @param derivative The dynamics of the system.
+	 * @param state The state to advance, it is updated in place.
+	 * @param control The control applied during the step.
+	 * @param integration_step The duration of the step.
+	 */
+	virtual void step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const = 0;
+
+protected:
+	/**
+	 * @brief Intermediate storage of the calling thread.
+	 * @param size The number of values needed by a step.
+	 * @return Storage for at least size values, valid until the next call in the same thread.
+	 */
+	static double* scratch(unsigned int size);
+
+	unsigned int state_dimension;
+};
+
+/**
+ * @brief Explicit Euler, the integrator the systems use by default.
+ */
+class euler_integrator_t : public integrator_t
+{
+public:
+	euler_integrator_t(unsigned int state_dimension);
+
+	void step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const override;
+};
+
+/**
+ * Semi-implicit (symplectic) Euler. The velocities are advanced first, then the other coordinates
+ * are advanced with the derivative at the new velocities. It costs two derivative evaluations per
+ * step, but does not gain energy in oscillating systems like explicit Euler does.
+ * @brief Semi-implicit Euler for systems with velocity coordinates.
+ */
+class semi_implicit_euler_integrator_t : public integrator_t
+{
+public:
+	/**
+	 * @brief Integrator constructor
+	 * @param is_velocity Flags for each dimension of the state space whether it is a velocity
+	 */
+	semi_implicit_euler_integrator_t(const std::vector<bool>& is_velocity);
+
+	void step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const override;
+
+private:
+	std::vector<bool> is_velocity;
+};
+
+/**
+ * @brief The classical fourth order Runge-Kutta method.
+ */
+class rk4_integrator_t : public integrator_t
+{
+public:
+	rk4_integrator_t(unsigned int state_dimension);
+
+	void step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const override;
+
+};
+
+/**
+ * Dormand-Prince 5(4) with error control. Every integration step is first attempted at once and
+ * subdivided while the embedded error estimate exceeds the tolerance, so the result does not
+ * depend on previous propagations. The error of a coordinate is relative to its magnitude, with
+ * an absolute floor of the tolerance. After RK45_MAX_SUBSTEPS substeps the step is completed
+ * without error control.
+ * @brief Adaptive fifth order Runge-Kutta method.
+ */
+class rk45_integrator_t : public integrator_t
+{
+public:
+	/**
+	 * @brief Integrator constructor
+	 * @param state_dimension Dimensionality of the state space
+	 * @param tolerance The error allowed in every substep
+	 */
+	rk45_integrator_t(unsigned int state_dimension, double tolerance=RK45_DEFAULT_TOLERANCE);
+
+	void step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const override;
+
+	/**
+	 * @brief The number of substeps of all steps so far, to measure the cost of the tolerance.
+	 */
+	unsigned long get_number_of_substeps() const
+	{
+		return number_of_substeps.load(std::memory_order_relaxed);
+	}
+
+private:
+	double tolerance;
+	/**
+	 * A statistic that orders no other memory, the threads sharing the integrator add to it relaxed.
+	 */
+	mutable std::atomic<unsigned long> number_of_substeps;
+};
+
+#endif
@@ -17,14 +17,13 @@
 
 #include "systems/system.hpp"
 
-class pendulum_t : public system_t
+class pendulum_t : public system_t, public reversible_system_interface
 {
 public:
 	pendulum_t()
 	{
 		state_dimension = 2;
 		control_dimension = 1;
-		temp_state = new double[state_dimension];
 	}
 	virtual ~pendulum_t(){}
 
@@ -36,15 +35,23 @@ public:
         const double* control, unsigned int control_dimension,
 	    int num_steps, double* result_state, double integration_step);
 
+	/**
+	 * @copydoc reversible_system_interface::propagate_backward()
+	 */
+	virtual bool propagate_backward(
+	    const double* end_state, unsigned int state_dimension,
+        const double* control, unsigned int control_dimension,
+	    int num_steps, double* result_state, double integration_step) override;
+
 	/**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 	
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 
 	/**
 	 * @copydoc system_t::visualize_point(double*, svg::Dimensions)
@@ -61,14 +61,13 @@ public:
  * @brief A simple system implementing a 2d point. 
  * @details A simple system implementing a 2d point. It's controls include velocity and direction.
  */
-class point_t : public system_t
+class point_t : public system_t, public reversible_system_interface
 {
 public:
 	point_t(int number_of_obstacles=5)
 	{
 		state_dimension = 2;
 		control_dimension = 2;
-		temp_state = new double[state_dimension];
 
 		std::vector<Rectangle_t> available_obstacles;
 		available_obstacles.push_back(Rectangle_t(   1,  -1.5,    5,  9.5));
@@ -82,7 +81,7 @@ public:
 		}
 
 	}
-	virtual ~point_t(){ delete temp_state;}
+	virtual ~point_t(){}
 
 	/**
 	 * @copydoc system_t::propagate(double*, double*, int, int, double*, double& )
@@ -92,15 +91,31 @@ public:
         const double* control, unsigned int control_dimension,
 	    int num_steps, double* result_state, double integration_step) override;
 
+	/**
+	 * @copydoc reversible_system_interface::propagate_backward()
+	 */
+	virtual bool propagate_backward(
+	    const double* end_state, unsigned int state_dimension,
+        const double* control, unsigned int control_dimension,
+	    int num_steps, double* result_state, double integration_step) override;
+
+	/**
+	 * @copydoc reversible_system_interface::steer()
+	 */
+	virtual bool steer(
+	    const double* start_state, const double* goal_state, unsigned int state_dimension,
+	    double* control, unsigned int control_dimension,
+	    int& num_steps, double integration_step) override;
+
 	/**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds() override;
+	virtual void enforce_bounds(double* state) const override;
 	
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state() override;
+	virtual bool valid_state(const double* state) const override;
 
 	/**
 	 * @copydoc system_t::visualize_point(double*, svg::Dimensions)
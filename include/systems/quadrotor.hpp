@@ -17,31 +17,20 @@
 #include <cmath>
 #include <string>
 #include "systems/system.hpp"
+#include "utilities/obstacle_grid.hpp"
 #define frame_size 0.25
 #include <cstdio>
 
-class quadrotor_t : public system_t
+class quadrotor_t : public integrated_system_t
 {
 public:
 	quadrotor_t(){
 		state_dimension = 13;
 		control_dimension = 4;
-		temp_state = new double[state_dimension]();
-		deriv = new double[state_dimension]();
-
-		u = new double[control_dimension]();
-		qomega = new double[4]();
-		validity = true;
 	}
 	quadrotor_t(std::vector<std::vector<double>> _obs_list, double width){
 		state_dimension = 13;
 		control_dimension = 4;
-		temp_state = new double[state_dimension]();
-		deriv = new double[state_dimension]();
-
-		u = new double[control_dimension]();
-		qomega = new double[4]();
-		validity = true;
 		frame = {{frame_size, 0, 0},
 				 {0, frame_size, 0},
 				 {-frame_size, 0, 0},
@@ -53,13 +42,10 @@ public:
 											 _obs_list.at(oi).at(2) - width / 2, _obs_list.at(oi).at(2) + width / 2};// size = 6
 			this -> obs_min_max.push_back(min_max_i); // size = n_o (* 6)
 		}
+		obstacle_grid = obstacle_grid_t(obs_min_max, 3);
 	}
 
 	virtual ~quadrotor_t(){
-		delete temp_state;
-		delete deriv;
-		delete qomega;
-		delete u;
 		// obs_list.clear();
 	}
 	/**
@@ -74,16 +60,25 @@ public:
 		const double* start_state, unsigned int state_dimension,
         const double* control, unsigned int control_dimension,
 	    int num_steps, double* result_state, double integration_step);
+
+	/**
+	 * @copydoc system_interface::propagate_batch()
+	 */
+	void propagate_batch(
+	    const double* start_states, unsigned int state_dimension,
+	    const double* controls, unsigned int control_dimension,
+	    const int* num_steps, unsigned int number_of_states,
+	    double* result_states, bool* valid, double integration_step) override;
 	
 	/**
 	 * @copydoc enhanced_system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 	
 	/**
 	 * @copydoc enhanced_system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 	
 	/**
 	 * @copydoc enhanced_system_t::visualize_point(double*, svg::Dimensions)
@@ -97,7 +92,7 @@ public:
 	 * https://ompl.kavrakilab.org/SO3StateSpace_8cpp_source.html
 	 * SO3StateSpace.cpp:183
 	 */
-	void enforce_bounds_SO3(double* qstate);
+	void enforce_bounds_SO3(double* qstate) const;
 
 	/**
 	 * @copydoc enhanced_system_t::get_state_bounds()
@@ -114,6 +109,11 @@ public:
 	 */
     std::vector<bool> is_circular_topology() const override;
 
+    /**
+	 * @copydoc integrated_system_t::is_velocity()
+	 */
+    std::vector<bool> is_velocity() const override;
+
 	/**
 	 * normalize state to [-1,1]^13
 	 */
@@ -135,13 +135,11 @@ public:
 	std::vector<std::vector<double>> obs_list;
 
 protected:
-	double* deriv;
-	void update_derivative(const double* control);
-	double *u;
-    double *qomega;
-	bool validity;
+	void update_derivative(const double* state, const double* control, double* derivative) const override;
 	std::vector<std::vector<double>> frame;
 	std::vector<std::vector<double>> obs_min_max;
+	// broad phase of the collision checks, over obs_min_max
+	obstacle_grid_t obstacle_grid;
 
 
 };
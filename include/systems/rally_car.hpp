@@ -19,15 +19,13 @@
 #include "systems/system.hpp"
 #include "systems/point.hpp"
 
-class rally_car_t : public system_t
+class rally_car_t : public integrated_system_t
 {
 public:
 	rally_car_t()
 	{
 		state_dimension = 8;
 		control_dimension = 3;
-		temp_state = new double[state_dimension];
-		deriv = new double[state_dimension];
 
 		obstacles.push_back(Rectangle_t(   0,  20.5,    42,  1,true));
 		obstacles.push_back(Rectangle_t(  20.5,  -5.5,   1, 53,true));
@@ -50,12 +48,12 @@ public:
 	/**
 	 * @copydoc system_t::enforce_bounds()
 	 */
-	virtual void enforce_bounds();
+	virtual void enforce_bounds(double* state) const;
 	
 	/**
 	 * @copydoc system_t::valid_state()
 	 */
-	virtual bool valid_state();
+	virtual bool valid_state(const double* state) const;
 
 	/**
 	 * @copydoc system_t::visualize_point(double*, svg::Dimensions)
@@ -82,9 +80,13 @@ public:
 	 */
     std::vector<bool> is_circular_topology() const override;
 
+    /**
+	 * @copydoc integrated_system_t::is_velocity()
+	 */
+    std::vector<bool> is_velocity() const override;
+
 protected:
-	double* deriv;
-	void update_derivative(const double* control);
+	void update_derivative(const double* state, const double* control, double* derivative) const override;
 	std::vector<Rectangle_t> obstacles;
 
 };
@@ -0,0 +1,122 @@
+/**
+ * @file swept_collision.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_SWEPT_COLLISION_HPP
+#define SPARSE_SWEPT_COLLISION_HPP
+
+#define _USE_MATH_DEFINES
+
+#include <cmath>
+
+/**
+ * Helpers of the continuous collision checks of the obstacle systems. The motion between two
+ * consecutive states of a propagation is taken as the linear interpolation of the states. A rigid
+ * segment or box then sweeps a region inside the convex hull of its start and end positions, grown
+ * by the distance its points deviate from their chords while it turns.
+ */
+
+/**
+ * @brief The largest distance of a rotating point from the chord of its arc.
+ * @details The largest distance of a rotating point from the chord of its arc, for a rotation
+ * between two angles along the shorter direction.
+ *
+ * @param radius The distance of the point from the center of rotation.
+ * @param from_angle The angle before the rotation.
+ * @param to_angle The angle after the rotation.
+ * @return The distance of the middle of the arc from its chord.
+ */
+inline double arc_deviation(double radius, double from_angle, double to_angle)
+{
+    double angle = std::fabs(std::remainder(to_angle - from_angle, 2 * M_PI));
+    return radius * (1 - std::cos(angle / 2));
+}
+
+/**
+ * @brief The bounding box of a set of points, grown by a margin.
+ * @details The bounding box of a set of points, grown by a margin.
+ *
+ * @param points The points, as x and y coordinates stored one after another.
+ * @param number_of_points The number of points.
+ * @param margin The distance by which the box is grown.
+ * @param box Storage for the box, as {min_x, max_x, min_y, max_y}.
+ */
+inline void hull_bounding_box(const double* points, unsigned int number_of_points, double margin, double* box)
+{
+    box[0] = box[1] = points[0];
+    box[2] = box[3] = points[1];
+    for(unsigned int i = 1; i < number_of_points; i++)
+    {
+        box[0] = std::fmin(box[0], points[2 * i]);
+        box[1] = std::fmax(box[1], points[2 * i]);
+        box[2] = std::fmin(box[2], points[2 * i + 1]);
+        box[3] = std::fmax(box[3], points[2 * i + 1]);
+    }
+    box[0] -= margin;
+    box[1] += margin;
+    box[2] -= margin;
+    box[3] += margin;
+}
+
+/**
+ * @brief Determine if the convex hull of a set of points, grown by a margin, overlaps an axis aligned box.
+ * @details Determine if the convex hull of a set of points, grown by a margin, overlaps an axis aligned box.
+ * This is a separating axis test over the box axes and the normals of all pairs of points, which
+ * include the edges of the hull. The margin grows the box instead of the hull, which can only
+ * report more overlaps.
+ *
+ * @param points The points, as x and y coordinates stored one after another.
+ * @param number_of_points The number of points.
+ * @param margin The distance by which the hull is grown.
+ * @return True if the hull overlaps the box, false if not.
+ */
+inline bool hull_overlaps_box(
+    const double* points, unsigned int number_of_points, double margin,
+    double low_x, double low_y, double high_x, double high_y)
+{
+    // The box axes reject most obstacles, as a bounding box test of the hull
+    double hull_box[4];
+    hull_bounding_box(points, number_of_points, margin, hull_box);
+    if(hull_box[1] < low_x || hull_box[0] > high_x || hull_box[3] < low_y || hull_box[2] > high_y)
+        return false;
+
+    low_x -= margin;
+    low_y -= margin;
+    high_x += margin;
+    high_y += margin;
+
+    for(unsigned int i = 0; i < number_of_points; i++)
+    {
+        for(unsigned int j = i + 1; j < number_of_points; j++)
+        {
+            double normal_x = points[2 * i + 1] - points[2 * j + 1];
+            double normal_y = points[2 * j] - points[2 * i];
+
+            double hull_min = points[0] * normal_x + points[1] * normal_y, hull_max = hull_min;
+            for(unsigned int k = 1; k < number_of_points; k++)
+            {
+                double projection = points[2 * k] * normal_x + points[2 * k + 1] * normal_y;
+                hull_min = std::fmin(hull_min, projection);
+                hull_max = std::fmax(hull_max, projection);
+            }
+            // The box projects onto the normal between its extreme corners
+            double center = (low_x + high_x) / 2 * normal_x + (low_y + high_y) / 2 * normal_y;
+            double extent = (high_x - low_x) / 2 * std::fabs(normal_x) + (high_y - low_y) / 2 * std::fabs(normal_y);
+            if(hull_max < center - extent || hull_min > center + extent)
+                return false;
+        }
+    }
+    return true;
+}
+
+#endif
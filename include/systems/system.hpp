@@ -14,10 +14,12 @@
 
 #ifndef SPARSE_SYSTEM_HPP
 #define SPARSE_SYSTEM_HPP
+#include <memory>
 #include <tuple>
 #include <vector>
 
 #include "systems/distance_functions.h"
+#include "systems/integrator.hpp"
 
 
 /**
@@ -42,6 +44,36 @@ struct system_interface {
         const double* start_state, unsigned int state_dimension,
         const double* control, unsigned int control_dimension,
         int num_steps, double* result_state, double integration_step) = 0;
+
+    /**
+	 * @brief Performs many local propagations at once.
+	 * @details Performs many local propagations at once, with the same results as calling
+	 * propagate() for every state. Systems override it with structure-of-arrays
+	 * implementations that integrate several states together.
+	 *
+	 * @param start_states The states to start propagating from, stored one after another.
+	 * @param controls The control to apply for every propagation, stored one after another.
+	 * @param num_steps The number of simulation steps of every propagation.
+	 * @param number_of_states The number of propagations.
+	 * @param result_states The results of the propagations. May be the start states.
+	 * @param valid Storage for the validity of every propagation.
+	 * @param integration_step The integration step of the propagations.
+	 */
+    virtual void propagate_batch(
+        const double* start_states, unsigned int state_dimension,
+        const double* controls, unsigned int control_dimension,
+        const int* num_steps, unsigned int number_of_states,
+        double* result_states, bool* valid, double integration_step)
+    {
+        for(unsigned int i = 0; i < number_of_states; i++)
+        {
+            valid[i] = propagate(
+                &start_states[i * state_dimension], state_dimension,
+                &controls[i * control_dimension], control_dimension,
+                num_steps[i], &result_states[i * state_dimension], integration_step);
+        }
+    }
+
     /**
      * @brief Creates a point in image space corresponding to a given state.
      * @details Creates a point in image space corresponding to a given state.
@@ -67,11 +99,60 @@ struct system_interface {
 };
 
 
+/**
+ * Interface of systems whose dynamics can be integrated backward in time. Backward propagation
+ * inverts the integration steps of propagate(): propagating the result forward with the same
+ * control and number of steps leads back to the end state, up to the enforced state bounds.
+ * @brief Interface of systems that can be propagated backward in time.
+ */
+struct reversible_system_interface {
+    virtual ~reversible_system_interface() {}
+
+    /**
+	 * @brief Finds the state from which a propagation ends at a given state.
+	 * @details Finds the state from which a propagation ends at a given state, by inverting the
+	 * integration steps of propagate() from the last one to the first one.
+	 *
+	 * @param end_state The state in which the propagation ends.
+	 * @param control The control applied during the propagation.
+	 * @param num_steps The number of simulation steps of the propagation.
+	 * @param result_state The state from which the propagation starts.
+	 * @param integration_step The integration step of the propagation.
+	 * @return True if all states of the propagation are valid, false if not.
+	 */
+    virtual bool propagate_backward(
+        const double* end_state, unsigned int state_dimension,
+        const double* control, unsigned int control_dimension,
+        int num_steps, double* result_state, double integration_step) = 0;
+
+    /**
+	 * @brief Solves the two point boundary value problem between two states.
+	 * @details Solves the two point boundary value problem between two states, if the system
+	 * has an exact steering function. The solution still has to be checked with propagate().
+	 *
+	 * @param start_state The state to start from.
+	 * @param goal_state The state to reach.
+	 * @param control The control that reaches the goal state.
+	 * @param num_steps The number of simulation steps that reach the goal state.
+	 * @param integration_step The integration step of the propagation.
+	 * @return True if a solution was found, false if the system can not steer exactly.
+	 */
+    virtual bool steer(
+        const double* start_state, const double* goal_state, unsigned int state_dimension,
+        double* control, unsigned int control_dimension,
+        int& num_steps, double integration_step)
+    {
+        return false;
+    }
+};
+
+
 /**
  * @brief A base class for plannable systems.
  * @details A base class for plannable systems. This class implements core functionality
  * related to creating state and control memory, propagations, obstacles, random states
- * and controls, and visualizing points.
+ * and controls, and visualizing points. Propagations keep their intermediate states on the
+ * stack of the caller, so one system can be propagated from several threads at once.
  * 
  */
 class system_t: public system_interface
@@ -123,20 +204,25 @@ public:
      */
 	virtual std::vector<bool> is_circular_topology() const = 0;
 
+	/**
+	 * @brief Determine if a state is in collision or out of bounds.
+	 * @details Determine if a state is in collision or out of bounds. The query does not modify
+	 * the system, so several threads may check states of the same system at once.
+	 *
+	 * @param state The state to check.
+	 * @return True if this state was valid, false if not.
+	 */
+	virtual bool valid_state(const double* state) const = 0;
+
 protected:
 
 	/**
 	 * @brief Enforce bounds on the state space.
 	 * @details Enforce bounds on the state space.
+	 *
+	 * @param state The state to bound, it is updated in place.
 	 */
-	virtual void enforce_bounds() = 0;
-
-	/**
-	 * @brief Determine if the current state is in collision or out of bounds.
-	 * @details Determine if the current state is in collision or out of bounds.
-	 * @return True if this state was valid, false if not.
-	 */
-	virtual bool valid_state() = 0;
+	virtual void enforce_bounds(double* state) const = 0;
 
 	/**
 	 * @brief The dimensionality of the state space.
@@ -148,11 +234,64 @@ protected:
 	 */
 	unsigned control_dimension;
 
+};
+
+
+/**
+ * @brief A base class for systems with a selectable integrator.
+ * @details A base class for systems with a selectable integrator. propagate() integrates
+ * with explicit Euler unless another integrator is set.
+ *
+ */
+class integrated_system_t: public system_t
+{
+public:
+	/**
+	 * @brief Selects the integrator of propagate().
+	 * @details Selects the integrator of propagate(). The system takes ownership of the integrator,
+	 * nullptr restores the built-in explicit Euler.
+	 *
+	 * @param new_integrator The integrator.
+	 */
+	void set_integrator(integrator_t* new_integrator)
+	{
+		integrator.reset(new_integrator);
+	}
+
+	/**
+	 * @brief Array of flags indicating that a degree of freedom is a velocity
+	 * @details Array of flags indicating that a degree of freedom is a velocity, see semi_implicit_euler_integrator_t.
+	 *
+	 */
+	virtual std::vector<bool> is_velocity() const = 0;
+
+protected:
+
 	/**
-	 * @brief Intermediate storage for propagation.
+	 * @brief Computes the time derivative of a state.
+	 * @details Computes the time derivative of a state.
+	 *
+	 * @param state The state.
+	 * @param control The applied control.
+	 * @param derivative Storage for the derivative.
 	 */
-	double* temp_state;
+	virtual void update_derivative(const double* state, const double* control, double* derivative) const = 0;
 
+	/**
+	 * @brief Advances a state by one integration step of the selected integrator.
+	 */
+	void integrate(double* state, const double* control, double integration_step) const
+	{
+		auto derivative_function = [this](const double* state, const double* control, double* derivative) {
+			update_derivative(state, control, derivative);
+		};
+		integrator->step(derivative_function, state, control, integration_step);
+	}
+
+	/**
+	 * @brief The selected integrator, nullptr for the built-in explicit Euler.
+	 */
+	std::unique_ptr<integrator_t> integrator;
 };
 
 #endif
\ No newline at end of file
@@ -52,6 +52,11 @@ namespace trajectory_optimizers{
                     sum_of_time = new double[number_of_t];
                     sum_of_square_time = new double[number_of_t];
                     active_mask = new bool[number_of_samples];
+                    terminal_loss = new double[number_of_samples];
+                    // per time segment buffers of propagate_batch
+                    batch_controls = new double[number_of_samples * c_dim];
+                    batch_steps = new int[number_of_samples];
+                    batch_valid = new bool[number_of_samples];
                     step_size = step_size;
                     it_max = max_iteration;
                     weight = new double[s_dim];
@@ -76,6 +81,10 @@ namespace trajectory_optimizers{
                 delete[] sum_of_time;
                 delete[] sum_of_square_time;
                 delete[] active_mask;
+                delete[] terminal_loss;
+                delete[] batch_controls;
+                delete[] batch_steps;
+                delete[] batch_valid;
             };
 
             unsigned int get_control_dimension();
@@ -99,6 +108,10 @@ namespace trajectory_optimizers{
                 *controls/* ns * nt * dim_control */, *time/* ns * nt */,
                 *current_state/* dim_state */;
             bool *active_mask/* ns */;
+            double *terminal_loss/* ns */;
+            double *batch_controls/* ns * dim_control */;
+            int *batch_steps/* ns */;
+            bool *batch_valid/* ns */;
             double *mu_u/* nt * dim_control */, *std_u /* nt * dim_control */, *mu_t/* nt */, *std_t/* nt */;  
             double *mu_u0, *std_u0, mu_t0, std_t0, max_duration;
             std::vector<std::pair<double, int>> loss;
@@ -0,0 +1,65 @@
+/**
+ * @file aligned_allocator.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_ALIGNED_ALLOCATOR_HPP
+#define SPARSE_ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief Minimal STL allocator returning memory aligned to a given boundary
+ * @details Used for coordinate buffers that are streamed through by the distance
+ * computations, so that every stored point starts on a cache-line friendly address.
+ */
+template <class T, std::size_t Alignment = 64>
+class aligned_allocator_t
+{
+public:
+    typedef T value_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef aligned_allocator_t<U, Alignment> other;
+    };
+
+    aligned_allocator_t() {}
+
+    template <class U>
+    aligned_allocator_t(const aligned_allocator_t<U, Alignment>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, Alignment, n * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+        free(p);
+    }
+
+    template <class U>
+    bool operator==(const aligned_allocator_t<U, Alignment>&) const { return true; }
+
+    template <class U>
+    bool operator!=(const aligned_allocator_t<U, Alignment>&) const { return false; }
+};
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file batch_distance.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_BATCH_DISTANCE_HPP
+#define SPARSE_BATCH_DISTANCE_HPP
+
+#include <vector>
+
+#include "utilities/aligned_allocator.hpp"
+
+#define BATCH_DISTANCE_LANES 4
+
+/**
+ * Computes weighted euclidean distances from one query point to many points at once,
+ * with wrap-around in the circular dimensions (the metric of euclidean_distance).
+ * The per-dimension topology and weights are turned into padded masks once, so the kernels
+ * do not branch on the dimension type.
+ *
+ * The kernel is selected at runtime: an AVX2 implementation is used when the CPU supports it,
+ * otherwise a portable scalar loop. Circular coordinates are expected to be in [-pi, pi].
+ * @brief Batch euclidean distance kernels with runtime CPU dispatch.
+ */
+class batch_distance_t
+{
+    public:
+        batch_distance_t();
+
+        /**
+         * @brief Constructor
+         * @param is_circular_topology Flags for each dimension of the state space whether its circular or not
+         * @param weights Optional weight of every squared coordinate difference, all ones if empty.
+         */
+        batch_distance_t(const std::vector<bool>& is_circular_topology, const std::vector<double>& weights=std::vector<double>());
+
+        /**
+         * @brief Dimensionality of the points.
+         */
+        unsigned int get_dimension() const
+        {
+            return dimension;
+        }
+
+        /**
+         * Squared distances from a query to points stored contiguously.
+         * @brief Squared distances from a query to points stored contiguously.
+         * @param query The query point.
+         * @param points The first point.
+         * @param stride Distance between consecutive points, at least the dimension.
+         * @param number_of_points The number of points.
+         * @param result Storage for number_of_points squared distances.
+         */
+        void squared_distances(const double* query, const double* points, unsigned int stride,
+                               unsigned int number_of_points, double* result) const;
+
+        /**
+         * Squared distances from a query to selected points of a slot-addressed point store.
+         * @brief Squared distances from a query to points of a point store.
+         * @param query The query point.
+         * @param store The point store.
+         * @param stride Distance between consecutive slots of the store.
+         * @param slots The slots of the points.
+         * @param number_of_points The number of slots.
+         * @param result Storage for number_of_points squared distances.
+         */
+        void squared_distances(const double* query, const double* store, unsigned int stride,
+                               const unsigned int* slots, unsigned int number_of_points, double* result) const;
+
+        /**
+         * Distances from a query to points stored contiguously.
+         * @brief Distances from a query to points stored contiguously.
+         * @param query The query point.
+         * @param points The first point.
+         * @param stride Distance between consecutive points, at least the dimension.
+         * @param number_of_points The number of points.
+         * @param result Storage for number_of_points distances.
+         */
+        void distances(const double* query, const double* points, unsigned int stride,
+                       unsigned int number_of_points, double* result) const;
+
+        /**
+         * @brief Name of the kernel selected for this CPU, "avx2" or "scalar".
+         */
+        static const char* kernel_name();
+
+        /**
+         * Allows to force the scalar kernel, e.g. to compare it with the vectorized one.
+         * @brief Enables or disables the vectorized kernel.
+         * @param enabled Use the vectorized kernel if the CPU supports it.
+         */
+        static void set_simd_enabled(bool enabled);
+
+    protected:
+        /**
+         * @brief Dimensionality of the points.
+         */
+        unsigned int dimension;
+
+        /**
+         * @brief Dimension rounded up to a multiple of BATCH_DISTANCE_LANES.
+         */
+        unsigned int padded_dimension;
+
+        /**
+         * @brief All bits set in the lanes of the circular dimensions.
+         */
+        std::vector<long long, aligned_allocator_t<long long> > circular_mask;
+
+        /**
+         * @brief All bits set in the lanes of the used dimensions, zero in the padding.
+         */
+        std::vector<long long, aligned_allocator_t<long long> > load_mask;
+
+        /**
+         * @brief Weights padded with zeros.
+         */
+        std::vector<double, aligned_allocator_t<double> > weights;
+};
+
+#endif
@@ -3,10 +3,7 @@
 
 
 void check_state_validity(enhanced_system_t* model, double* state){
-    for(unsigned int si = 0; si < model -> get_state_dimension(); si++){
-        model -> temp_state[si] = state[si];
-    }
-    std::cout<<model->valid_state()<<std::endl;
+    std::cout<<model->valid_state(state)<<std::endl;
 }
 
 void print_state(enhanced_system_t* model, double* state){
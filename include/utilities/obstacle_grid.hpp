@@ -0,0 +1,192 @@
+/**
+ * @file obstacle_grid.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_OBSTACLE_GRID_HPP
+#define SPARSE_OBSTACLE_GRID_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+/**
+ * Uniform grid over the bounding boxes of the obstacles of a system. Every cell lists the
+ * obstacles whose boxes reach into it, so a collision check only runs its exact test on the
+ * obstacles around the bounding box of the robot. Cells are about the size of an obstacle, and
+ * there are at most twice as many cells per axis as the root of the number of obstacles.
+ *
+ * Boxes are stored as (min, max) pairs of every axis: {min_x, max_x, min_y, max_y[, min_z, max_z]}.
+ * The grid does not change after it is built, so several threads may query it at once.
+ *
+ * @brief Broad phase of the collision checks of the obstacle systems.
+ */
+class obstacle_grid_t
+{
+public:
+    obstacle_grid_t() : dimension(0), number_of_boxes(0) {}
+
+    /**
+     * @brief Builds the grid over a set of boxes.
+     * @details Builds the grid over a set of boxes.
+     *
+     * @param boxes The boxes, as (min, max) pairs of every axis.
+     * @param dimension The number of axes, 2 or 3.
+     */
+    obstacle_grid_t(const std::vector<std::vector<double>>& boxes, unsigned int dimension)
+        : dimension(dimension), number_of_boxes(boxes.size())
+    {
+        assert(dimension == 2 || dimension == 3);
+        for(unsigned int k = 0; k < 3; k++)
+        {
+            low[k] = 0;
+            high[k] = 0;
+            inverse_cell_size[k] = 0;
+            cells[k] = 1;
+        }
+        if(number_of_boxes == 0)
+            return;
+
+        unsigned int max_cells = (unsigned int)std::ceil(2 * std::pow(double(number_of_boxes), 1.0 / dimension));
+        for(unsigned int k = 0; k < dimension; k++)
+        {
+            low[k] = boxes[0][2 * k];
+            high[k] = boxes[0][2 * k + 1];
+            double average_size = 0;
+            for(unsigned int i = 0; i < number_of_boxes; i++)
+            {
+                low[k] = std::min(low[k], boxes[i][2 * k]);
+                high[k] = std::max(high[k], boxes[i][2 * k + 1]);
+                average_size += (boxes[i][2 * k + 1] - boxes[i][2 * k]) / number_of_boxes;
+            }
+            if(high[k] > low[k] && average_size > 0)
+            {
+                double number_of_cells = std::ceil((high[k] - low[k]) / average_size);
+                cells[k] = (unsigned int)std::max(1., std::min(double(max_cells), number_of_cells));
+                inverse_cell_size[k] = cells[k] / (high[k] - low[k]);
+            }
+        }
+
+        // Counting sort of the boxes into the cells they reach into
+        first_cells.resize(3 * number_of_boxes);
+        std::vector<unsigned int> last_cells(3 * number_of_boxes);
+        cell_start.assign(cells[0] * cells[1] * cells[2] + 1, 0);
+        for(unsigned int i = 0; i < number_of_boxes; i++)
+        {
+            for(unsigned int k = 0; k < 3; k++)
+            {
+                first_cells[3 * i + k] = k < dimension ? cell_of(k, boxes[i][2 * k]) : 0;
+                last_cells[3 * i + k] = k < dimension ? cell_of(k, boxes[i][2 * k + 1]) : 0;
+            }
+            for_each_cell(&first_cells[3 * i], &last_cells[3 * i], [&](unsigned int cell, const unsigned int*) {
+                cell_start[cell + 1]++;
+            });
+        }
+        for(unsigned int cell = 0; cell + 1 < cell_start.size(); cell++)
+            cell_start[cell + 1] += cell_start[cell];
+        cell_boxes.resize(cell_start.back());
+        std::vector<unsigned int> fill(cell_start.begin(), cell_start.end() - 1);
+        for(unsigned int i = 0; i < number_of_boxes; i++)
+        {
+            for_each_cell(&first_cells[3 * i], &last_cells[3 * i], [&](unsigned int cell, const unsigned int*) {
+                cell_boxes[fill[cell]++] = i;
+            });
+        }
+    }
+
+    /**
+     * @brief Runs an exact test on the boxes around a query box, until one of them passes.
+     * @details Runs an exact test on every box that shares a cell with the query box, until one of
+     * them passes. Every box that overlaps the query box is tested, and every box is tested at most once.
+     *
+     * @param query The query box, as (min, max) pairs of every axis.
+     * @param test The exact test, bool test(unsigned int box_index).
+     * @return True if the test passed for a box, false if not.
+     */
+    template <class test_t>
+    bool any_near(const double* query, test_t test) const
+    {
+        if(number_of_boxes == 0)
+            return false;
+        unsigned int first[3] = {0, 0, 0}, last[3] = {0, 0, 0};
+        for(unsigned int k = 0; k < dimension; k++)
+        {
+            if(query[2 * k + 1] < low[k] || query[2 * k] > high[k])
+                return false;
+            first[k] = cell_of(k, query[2 * k]);
+            last[k] = cell_of(k, query[2 * k + 1]);
+        }
+        bool found = false;
+        for_each_cell(first, last, [&](unsigned int cell, const unsigned int* position) {
+            for(unsigned int j = cell_start[cell]; j < cell_start[cell + 1] && !found; j++)
+            {
+                unsigned int i = cell_boxes[j];
+                // A box in several cells of the query is tested in the first of them
+                const unsigned int* box_first = &first_cells[3 * i];
+                if(position[0] != std::max(box_first[0], first[0]) ||
+                   position[1] != std::max(box_first[1], first[1]) ||
+                   position[2] != std::max(box_first[2], first[2]))
+                    continue;
+                found = test(i);
+            }
+        });
+        return found;
+    }
+
+protected:
+    /**
+     * @brief The cell of a coordinate along an axis, clamped to the grid.
+     */
+    unsigned int cell_of(unsigned int k, double value) const
+    {
+        double cell = (value - low[k]) * inverse_cell_size[k];
+        if(!(cell > 0))
+            return 0;
+        if(cell >= cells[k])
+            return cells[k] - 1;
+        return (unsigned int)cell;
+    }
+
+    /**
+     * @brief Calls a function with the index and position of every cell in a range.
+     */
+    template <class function_t>
+    void for_each_cell(const unsigned int* first, const unsigned int* last, function_t function) const
+    {
+        unsigned int position[3];
+        for(position[2] = first[2]; position[2] <= last[2]; position[2]++)
+            for(position[1] = first[1]; position[1] <= last[1]; position[1]++)
+                for(position[0] = first[0]; position[0] <= last[0]; position[0]++)
+                    function((position[2] * cells[1] + position[1]) * cells[0] + position[0], position);
+    }
+
+    unsigned int dimension;
+    unsigned int number_of_boxes;
+    double low[3];
+    double high[3];
+    double inverse_cell_size[3];
+    unsigned int cells[3];
+
+    /**
+     * @brief The boxes of every cell, from cell_start[cell] to cell_start[cell + 1].
+     */
+    std::vector<unsigned int> cell_start;
+    std::vector<unsigned int> cell_boxes;
+
+    /**
+     * @brief The first cell of every box along every axis.
+     */
+    std::vector<unsigned int> first_cells;
+};
+
+#endif
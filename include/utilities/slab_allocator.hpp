@@ -0,0 +1,108 @@
+/**
+ * @file slab_allocator.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_SLAB_ALLOCATOR_HPP
+#define SPARSE_SLAB_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+#define SLAB_ALLOCATOR_BLOCKS_PER_SLAB 1024
+
+/**
+ * @brief Allocates memory blocks of a fixed size from large slabs.
+ * @details Allocates memory blocks of a fixed size from large slabs. Released blocks are kept in
+ * a free list and handed out again before the slabs grow, the slabs themselves are only returned
+ * to the system when the allocator is destroyed. Blocks are aligned for any fundamental type.
+ * The allocator does not run constructors or destructors and is not thread safe.
+ */
+class slab_allocator_t
+{
+public:
+	/**
+	 * @brief Allocator constructor
+	 * @param block_size The size of every block in bytes.
+	 * @param blocks_per_slab The number of blocks allocated from the system at once.
+	 */
+	slab_allocator_t(size_t block_size, size_t blocks_per_slab=SLAB_ALLOCATOR_BLOCKS_PER_SLAB);
+	~slab_allocator_t();
+
+	slab_allocator_t(const slab_allocator_t&) = delete;
+	slab_allocator_t& operator=(const slab_allocator_t&) = delete;
+
+	/**
+	 * @brief Returns an uninitialized block.
+	 * @return The block.
+	 */
+	void* allocate();
+
+	/**
+	 * @brief Returns a block to the free list.
+	 * @param block A block returned by allocate().
+	 */
+	void deallocate(void* block);
+
+	/**
+	 * @brief Return the size of the blocks
+	 * @return size of the blocks in bytes
+	 */
+	size_t get_block_size() const
+	{
+		return block_size;
+	}
+
+	/**
+	 * @brief Return the number of blocks in use
+	 * @return number of allocated and not released blocks
+	 */
+	size_t get_number_of_blocks() const
+	{
+		return number_of_blocks;
+	}
+
+	/**
+	 * @brief Return the memory taken from the system
+	 * @return size of all slabs in bytes
+	 */
+	size_t get_reserved_size() const
+	{
+		return slabs.size() * blocks_per_slab * block_size;
+	}
+
+private:
+	size_t block_size;
+	size_t blocks_per_slab;
+
+	/**
+	 * @brief The slabs taken from the system.
+	 */
+	std::vector<char*> slabs;
+
+	/**
+	 * @brief The number of blocks of the last slab handed out so far.
+	 */
+	size_t used_in_last_slab;
+
+	/**
+	 * @brief The first released block. Every released block stores the next one.
+	 */
+	void* free_list;
+
+	/**
+	 * @brief The number of blocks in use.
+	 */
+	size_t number_of_blocks;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file thread_pool.hpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#ifndef SPARSE_THREAD_POOL_HPP
+#define SPARSE_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads executing parallel loops.
+ * @details A fixed set of worker threads executing parallel loops. The threads are started once
+ * and wait between the loops, so a loop costs two synchronizations instead of thread creations.
+ * Every task is told which thread runs it, so that tasks can use per-thread resources.
+ */
+class thread_pool_t
+{
+public:
+	/**
+	 * @brief Starts the worker threads.
+	 * @param number_of_threads The number of worker threads.
+	 */
+	thread_pool_t(unsigned int number_of_threads);
+	~thread_pool_t();
+
+	/**
+	 * @brief Return the number of worker threads
+	 * @return number of worker threads
+	 */
+	unsigned int get_number_of_threads() const
+	{
+		return threads.size();
+	}
+
+	/**
+	 * @brief Runs task(index, thread) for every index in [0, number_of_tasks) and waits for completion.
+	 * @details Runs task(index, thread) for every index in [0, number_of_tasks) and waits for completion.
+	 * The tasks are distributed dynamically, thread is the index of the worker in [0, get_number_of_threads()).
+	 *
+	 * @param number_of_tasks The number of tasks.
+	 * @param task The task to execute.
+	 */
+	void parallel_for(unsigned int number_of_tasks, const std::function<void(unsigned int, unsigned int)>& task);
+
+private:
+	/**
+	 * @brief The loop of a worker thread.
+	 * @param thread The index of the worker.
+	 */
+	void work(unsigned int thread);
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_finished;
+
+	/**
+	 * @brief The task of the current loop.
+	 */
+	const std::function<void(unsigned int, unsigned int)>* current_task;
+
+	/**
+	 * @brief The number of tasks of the current loop.
+	 */
+	unsigned int number_of_tasks;
+
+	/**
+	 * @brief The next task to execute.
+	 */
+	std::atomic<unsigned int> next_task;
+
+	/**
+	 * @brief The number of workers done with the current loop.
+	 */
+	unsigned int finished_threads;
+
+	/**
+	 * @brief Incremented for every loop, wakes up the workers.
+	 */
+	unsigned long generation;
+
+	bool stopping;
+};
+
+#endif
@@ -48,13 +48,20 @@ setup(
     packages=find_packages(),
     ext_modules=[Extension(
         'sparse_rrt._sst_module',
-        extra_compile_args=['-std=c++1y', '-O3'],
+        extra_compile_args=['-std=c++1y', '-O3', '-pthread'],
+        extra_link_args=['-pthread'],
         include_dirs=['deps/pybind11/include',
                       'include'],
         sources=[
+            'src/motion_planners/bidirectional_sst.cpp',
+            'src/motion_planners/planner_portfolio.cpp',
             'src/motion_planners/rrt.cpp',
+            'src/motion_planners/sampler.cpp',
             'src/motion_planners/sst.cpp',
+            'src/motion_planners/tree_file.cpp',
+            'src/nearest_neighbors/nearest_neighbors.cpp',
             'src/nearest_neighbors/graph_nearest_neighbors.cpp',
+            'src/nearest_neighbors/kd_tree_nearest_neighbors.cpp',
             'src/systems/car.cpp',
             'src/systems/cart_pole.cpp',
             'src/systems/pendulum.cpp',
@@ -63,9 +70,13 @@ setup(
             'src/systems/two_link_acrobot.cpp',
             'src/utilities/random.cpp',
             'src/utilities/timer.cpp',
+            'src/utilities/batch_distance.cpp',
+            'src/utilities/thread_pool.cpp',
+            'src/utilities/slab_allocator.cpp',
             'src/image_creation/svg_image.cpp',
             'src/image_creation/planner_visualization.cpp',
             'src/systems/distance_functions.cpp',
+            'src/systems/integrator.cpp',
             'src/python_wrapper.cpp'])
     ]
 )
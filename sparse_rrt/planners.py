@@ -45,6 +45,12 @@ class SST_Backend(visualize_wrapper(_sst_module.SSTBackendWrapper)):
     '''
     pass
 
+class BidirectionalSST(visualize_wrapper(_sst_module.BidirectionalSSTWrapper)):
+    '''
+    Sparse stable trees planner growing trees from the start and the goal (point, car and pendulum)
+    '''
+    pass
+
 class RRT(visualize_wrapper(_sst_module.RRTWrapper)):
     '''
     RRT planner (baseline)
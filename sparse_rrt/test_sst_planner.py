@@ -3,11 +3,36 @@ import _sst_module
 from sparse_rrt.systems import standard_cpp_systems
 import numpy as np
 import time
+import threading
+import tempfile
+import os
 
 from sparse_rrt.systems.acrobot import Acrobot, AcrobotDistance
 from sparse_rrt.systems.point import Point
 
 
+def _create_sst_planner(system, **overrides):
+    '''
+    Create an SST planner, by default for the point query from [0, 0] to [9, 9]
+    :param system: the system to plan for, provides the bounds and the distance
+    :param overrides: SSTWrapper arguments that differ from the defaults
+    :return: the planner
+    '''
+    arguments = dict(
+        state_bounds=system.get_state_bounds(),
+        control_bounds=system.get_control_bounds(),
+        distance=system.distance_computer(),
+        start_state=np.array([0., 0.]),
+        goal_state=np.array([9., 9.]),
+        goal_radius=0.5,
+        random_seed=0,
+        sst_delta_near=0.4,
+        sst_delta_drain=0.2
+    )
+    arguments.update(overrides)
+    return _sst_module.SSTWrapper(**arguments)
+
+
 def test_point_sst():
     '''
     Sanity check SST test - makes sure that SST produces exactly(!) the same results during runs.
@@ -187,6 +212,346 @@ def test_multiple_runs_same_result_sst():
         assert original_number_of_nodes == planner.get_number_of_nodes()
 
 
+def test_kd_tree_nearest_neighbors_sst():
+    '''
+    Check that SST with the exact kd-tree nearest neighbors reproduces the tree of a fixed seed
+    '''
+    system = standard_cpp_systems.Point()
+
+    planner = _create_sst_planner(system, nearest_neighbors='kd_tree')
+
+    for iteration in range(100000):
+        planner.step(system, 20, 200, 0.002)
+    assert planner.get_solution() is not None
+    assert planner.get_number_of_nodes() == 5114
+    assert np.isclose(planner.get_best_cost(), 2.778)
+
+
+
+def test_step_n_and_run_until_sst():
+    '''
+    Check that the batched step API matches single steps
+    '''
+    system = standard_cpp_systems.Point()
+
+    planner = _create_sst_planner(system)
+    planner.step_n(system, 100000, 20, 200, 0.002)
+    assert planner.get_number_of_nodes() == 4881
+    assert planner.has_solution()
+
+    planner = _create_sst_planner(system)
+    iterations = planner.run_until(system, 20, 200, 0.002, solution_found=True)
+    assert planner.has_solution()
+    assert planner.get_solution() is not None
+    assert 0 < iterations < 100000
+
+    planner = _create_sst_planner(system)
+    planner.run_until(system, 20, 200, 0.002, node_budget=1000)
+    assert planner.get_number_of_nodes() == 1000
+
+    planner = _create_sst_planner(system)
+    iterations = planner.run_until(system, 20, 200, 0.002, time_budget=0.5)
+    assert iterations > 0
+    assert planner.get_number_of_nodes() > 1
+
+
+def test_threaded_planners_sst():
+    '''
+    Check that planners stepped from several python threads produce the same trees as sequential runs
+    '''
+    seeds = [0, 1, 2, 3]
+    # systems keep propagation state, so every thread steps its own instance
+    systems = [standard_cpp_systems.Point() for _ in seeds]
+
+    expected = []
+    for seed, system in zip(seeds, systems):
+        planner = _create_sst_planner(system, random_seed=seed)
+        planner.step_n(system, 20000, 20, 200, 0.002)
+        expected.append(planner.get_number_of_nodes())
+
+    planners = [_create_sst_planner(system, random_seed=seed) for seed, system in zip(seeds, systems)]
+    threads = [threading.Thread(target=p.step_n, args=(s, 20000, 20, 200, 0.002)) for p, s in zip(planners, systems)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert [p.get_number_of_nodes() for p in planners] == expected
+
+
+def test_step_parallel_sst():
+    '''
+    Check that parallel propagation matches step() with a batch of one and does not depend on the number of threads
+    '''
+    systems = [standard_cpp_systems.Point() for _ in range(4)]
+
+    planner = _create_sst_planner(systems[0])
+    planner.step_n(systems[0], 20000, 20, 200, 0.002)
+    batched_planner = _create_sst_planner(systems[0])
+    for _ in range(20000):
+        batched_planner.step_parallel(systems[:1], 20, 200, 0.002, batch_size=1)
+    assert batched_planner.get_number_of_nodes() == planner.get_number_of_nodes()
+    assert batched_planner.get_best_cost() == planner.get_best_cost()
+
+    single_thread_planner = _create_sst_planner(systems[0])
+    four_threads_planner = _create_sst_planner(systems[0])
+    for _ in range(500):
+        single_thread_planner.step_parallel(systems[:1], 20, 200, 0.002, batch_size=40)
+        four_threads_planner.step_parallel(systems, 20, 200, 0.002, batch_size=40)
+    assert four_threads_planner.get_number_of_nodes() == single_thread_planner.get_number_of_nodes()
+    assert four_threads_planner.get_best_cost() == single_thread_planner.get_best_cost()
+    for a, b in zip(four_threads_planner.get_solution(), single_thread_planner.get_solution()):
+        assert np.array_equal(a, b)
+
+
+def test_sampling_strategies_sst():
+    '''
+    Check goal biased, informed and python samplers
+    '''
+    system = standard_cpp_systems.Point()
+
+    planner = _create_sst_planner(system)
+    assert planner.get_best_cost() == np.inf
+    # the point moves at most 10 units per second, so the time to reach a state is at least distance / 10
+    planner.set_sampling(goal_bias=0.05, cost_per_distance=0.1)
+    planner.step_n(system, 50000, 20, 200, 0.002)
+    assert planner.has_solution()
+    assert np.isclose(planner.get_best_cost(), np.sum(planner.get_solution()[2]))
+
+    planner = _create_sst_planner(system)
+    samples = []
+
+    def _sampler(best_cost):
+        samples.append(best_cost)
+        return np.random.uniform([-10, -10], [10, 10])
+
+    planner.set_sampling(sampler=_sampler)
+    planner.run_until(system, 20, 200, 0.002, node_budget=100)
+    assert len(samples) > 0
+    assert samples[0] == np.inf
+
+
+def test_multi_query_sst():
+    '''
+    Check that the tree is reused when the goal changes and that solutions can start at added starts
+    '''
+    system = standard_cpp_systems.Point()
+    planner = _create_sst_planner(system)
+    planner.run_until(system, 20, 200, 0.002, solution_found=True)
+    number_of_nodes = planner.get_number_of_nodes()
+
+    planner.set_goal(np.array([-8., 5.]), 0.5)
+    assert planner.get_number_of_nodes() <= number_of_nodes
+    planner.run_until(system, 20, 200, 0.002, solution_found=True)
+    path, _, costs = planner.get_solution()
+    assert np.linalg.norm(path[-1] - [-8., 5.]) < 0.5
+    assert np.isclose(np.sum(costs), planner.get_best_cost())
+
+    planner.add_start(np.array([-9., -9.]))
+    planner.set_goal(np.array([-9., -5.]), 0.5)
+    planner.run_until(system, 20, 200, 0.002, solution_found=True)
+    planner.step_n(system, 20000, 20, 200, 0.002)
+    path, _, _ = planner.get_solution()
+    # the closer start gives the better solution
+    assert np.allclose(path[0], [-9., -9.])
+    assert np.linalg.norm(path[-1] - [-9., -5.]) < 0.5
+
+
+def test_retained_tree_sst():
+    '''
+    Check that a retained tree keeps the nodes costlier than the solution and reaches a farther goal without planning
+    '''
+    system = standard_cpp_systems.Point()
+    planner = _create_sst_planner(system, goal_state=np.array([-3., -3.]))
+    planner.set_retain_tree(True)
+    planner.run_until(system, 20, 200, 0.002, solution_found=True)
+    first_cost = planner.get_best_cost()
+    planner.step_n(system, 20000, 20, 200, 0.002)
+    number_of_nodes = planner.get_number_of_nodes()
+
+    planner.set_goal(np.array([9., 9.]), 0.5)
+    assert planner.get_number_of_nodes() == number_of_nodes
+    assert planner.has_solution()
+    assert planner.get_best_cost() > first_cost
+    path, _, costs = planner.get_solution()
+    assert np.linalg.norm(path[-1] - [9., 9.]) < 0.5
+    assert np.isclose(np.sum(costs), planner.get_best_cost())
+
+    # pruning on request removes the nodes costlier than the solution
+    planner.prune()
+    assert planner.get_number_of_nodes() < number_of_nodes
+    assert planner.has_solution()
+
+
+def test_portfolio_sst():
+    '''
+    Check that a portfolio of seeded planners returns the planner with the best solution and that the shared
+    cost bound prunes the trees of all planners
+    '''
+    systems = [standard_cpp_systems.Point() for _ in range(4)]
+    planners = [_create_sst_planner(system, random_seed=seed) for seed, system in enumerate(systems)]
+
+    best = _sst_module.run_portfolio(planners, systems, 20, 200, 0.002, solution_found=True)
+    assert best is not None
+    assert planners[best].has_solution()
+
+    best = _sst_module.run_portfolio(planners, systems, 20, 200, 0.002, time_budget=0.5)
+    best_cost = planners[best].get_best_cost()
+    assert all(best_cost <= p.get_best_cost() for p in planners)
+
+    def costlier_nodes(planner, cost):
+        # number of nodes more expensive than the cost, that are not on the path to the own solution
+        filename = os.path.join(tempfile.mkdtemp(), 'portfolio.tree')
+        planner.save_tree(filename)
+        costlier = np.sum(_sst_module.TreeFile(filename).costs > cost)
+        return costlier - (len(planner.get_solution()[0]) if planner.has_solution() else 0)
+
+    # with the shared bound every tree is pruned with the best cost of the portfolio
+    assert all(costlier_nodes(p, best_cost) <= 0 for p in planners)
+
+    planners = [_create_sst_planner(system, random_seed=seed) for seed, system in enumerate(systems)]
+    best = _sst_module.run_portfolio(planners, systems, 20, 200, 0.002, time_budget=0.5, share_cost_bound=False)
+    best_cost = planners[best].get_best_cost()
+    assert any(costlier_nodes(p, best_cost) > 0 for p in planners)
+
+
+def test_portfolio_retarget_sst():
+    '''
+    Check that the cost bound shared during a portfolio run does not limit a later query with a costlier goal
+    '''
+    systems = [standard_cpp_systems.Point() for _ in range(4)]
+    planners = [_create_sst_planner(system, goal_state=np.array([-3., -3.]), random_seed=seed)
+                for seed, system in enumerate(systems)]
+
+    best = _sst_module.run_portfolio(planners, systems, 20, 200, 0.002, solution_found=True)
+    assert best is not None
+
+    for planner, system in zip(planners, systems):
+        planner.set_goal(np.array([9., 9.]), 0.5)
+        planner.step_n(system, 100000, 20, 200, 0.002)
+        assert planner.has_solution()
+
+
+def test_bidirectional_sst():
+    '''
+    Check that connections of the start and goal trees are feasible forward trajectories
+    '''
+    system = standard_cpp_systems.Point()
+    planner = _sst_module.BidirectionalSSTWrapper(
+        state_bounds=system.get_state_bounds(),
+        control_bounds=system.get_control_bounds(),
+        distance=system.distance_computer(),
+        start_state=np.array([0., 0.]),
+        goal_state=np.array([9., 9.]),
+        goal_radius=0.5,
+        random_seed=0,
+        sst_delta_near=0.4,
+        sst_delta_drain=0.2,
+        connection_radius=1.
+    )
+    planner.run_until(system, 20, 200, 0.002, solution_found=True)
+    path, controls, costs = planner.get_solution()
+    assert np.isclose(np.sum(costs), planner.get_best_cost())
+    assert len(path) == len(controls) + 1
+    assert np.allclose(path[0], [0., 0.])
+    assert np.linalg.norm(path[-1] - [9., 9.]) < 0.5
+
+    try:
+        planner.step(standard_cpp_systems.CartPole(), 20, 200, 0.002)
+        assert False, "the cart pole can not be propagated backward"
+    except ValueError:
+        pass
+
+    try:
+        planner.save_tree(os.path.join(tempfile.mkdtemp(), 'bidirectional.tree'))
+        assert False, "the goal tree can not be saved"
+    except RuntimeError:
+        pass
+
+
+def test_tree_serialization_sst():
+    '''
+    Check that a saved tree is restored by load_tree and can be queried through the mapped file
+    '''
+    system = standard_cpp_systems.Point()
+
+    filename = os.path.join(tempfile.mkdtemp(), 'point.tree')
+    planner = _create_sst_planner(system)
+    planner.step_n(system, 20000, 20, 200, 0.002)
+    planner.save_tree(filename)
+    path, controls, costs = planner.get_solution()
+
+    loaded = _create_sst_planner(system, start_state=np.array([5., 5.]))
+    loaded.load_tree(filename)
+    assert loaded.get_number_of_nodes() == planner.get_number_of_nodes()
+    loaded_path, loaded_controls, loaded_costs = loaded.get_solution()
+    assert np.array_equal(path, loaded_path)
+    assert np.array_equal(controls, loaded_controls)
+    assert np.array_equal(costs, loaded_costs)
+    loaded.step_n(system, 1000, 20, 200, 0.002)
+
+    tree = _sst_module.TreeFile(filename)
+    assert tree.get_number_of_nodes() == planner.get_number_of_nodes()
+    assert tree.states.shape == (tree.get_number_of_nodes(), 2)
+    assert not tree.states.flags.writeable
+    assert tree.parents[0] == -1
+    node = tree.find_cheapest_near(np.array([9., 9.]), 0.5, system.distance_computer())
+    assert np.isclose(tree.costs[node], planner.get_best_cost())
+    branch_path, _, _ = tree.get_branch(node)
+    assert np.array_equal(branch_path, path)
+
+
+def test_integrators_sst():
+    '''
+    Check that SST grows deterministic trees with the selectable integrators of the systems and that the trees
+    depend on the integrator
+    '''
+    def grow_tree(integrator):
+        system = standard_cpp_systems.CartPole()
+        system.set_integrator(integrator)
+        planner = _create_sst_planner(
+            system,
+            start_state=np.array([-20, 0, 3.14, 0]),
+            goal_state=np.array([20, 0, 3.14, 0]),
+            goal_radius=1.5,
+            sst_delta_near=2.,
+            sst_delta_drain=1.2
+        )
+        # a five times larger integration step than in test_point_sst
+        planner.step_n(system, 1000, 2, 20, 0.01)
+        filename = os.path.join(tempfile.mkdtemp(), integrator + '.tree')
+        planner.save_tree(filename)
+        return system, np.array(_sst_module.TreeFile(filename).states)
+
+    trees = []
+    for integrator in ['euler', 'semi_implicit_euler', 'rk4', 'rk45']:
+        system, states = grow_tree(integrator)
+        assert len(states) > 1
+        assert np.array_equal(states, grow_tree(integrator)[1])
+        assert all(not np.array_equal(states, other) for other in trees)
+        trees.append(states)
+
+    try:
+        system.set_integrator('midpoint')
+        assert False, "unknown integrators are rejected"
+    except ValueError:
+        pass
+
+
+def test_valid_state():
+    '''
+    Check the state validity query of the systems
+    '''
+    system = standard_cpp_systems.Point()
+    assert not system.valid_state(np.array([3., 0.]))
+    assert system.valid_state(np.array([-5., 0.]))
+
+    try:
+        system.valid_state(np.array([0., 0., 0.]))
+        assert False, "states of the wrong dimension are rejected"
+    except ValueError:
+        pass
+
+
 if __name__ == '__main__':
     st = time.time()
     test_point_sst()
@@ -195,4 +560,17 @@ if __name__ == '__main__':
     test_py_system_sst()
     test_py_system_sst_custom_distance()
     test_multiple_runs_same_result_sst()
+    test_kd_tree_nearest_neighbors_sst()
+    test_step_n_and_run_until_sst()
+    test_threaded_planners_sst()
+    test_step_parallel_sst()
+    test_sampling_strategies_sst()
+    test_multi_query_sst()
+    test_retained_tree_sst()
+    test_portfolio_sst()
+    test_portfolio_retarget_sst()
+    test_bidirectional_sst()
+    test_tree_serialization_sst()
+    test_integrators_sst()
+    test_valid_state()
     print('Passed all tests!')
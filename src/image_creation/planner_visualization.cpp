@@ -46,15 +46,15 @@ svg::Point visualize_point(projection_function projector, const double* state, s
  */
 void visualize_edge(tree_node_t* node, projection_function projector, svg::DocumentBody& doc, svg::Dimensions& dim, double tree_line_width)
 {
-	for (std::list<tree_node_t*>::const_iterator i = node->get_children().begin(); i != node->get_children().end(); ++i)
+	for (tree_node_t* child: node->get_children())
 	{
 		svg::Polyline traj_line(svg::Stroke(tree_line_width, svg::Color::Blue));
 
 		traj_line<<visualize_point(projector, node->get_point(), dim);
-		traj_line<<visualize_point(projector, (*i)->get_point(), dim);
+		traj_line<<visualize_point(projector, child->get_point(), dim);
 		doc<<traj_line;
 
-		visualize_edge(*i, projector, doc, dim, tree_line_width);
+		visualize_edge(child, projector, doc, dim, tree_line_width);
 	}
 }
 
@@ -100,9 +100,9 @@ void get_max_cost(tree_node_t* node, double& max_cost, std::vector<tree_node_t*>
 	if(node->get_cost() > max_cost) {
 	    max_cost = node->get_cost();
 	}
-	for (std::list<tree_node_t*>::const_iterator i = node->get_children().begin(); i != node->get_children().end(); ++i)
+	for (tree_node_t* child: node->get_children())
 	{
-		get_max_cost(*i, max_cost, nodes);
+		get_max_cost(child, max_cost, nodes);
 	}
 }
 
@@ -0,0 +1,206 @@
+/**
+ * @file bidirectional_sst.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <assert.h>
+#include <cmath>
+#include <deque>
+#include <stdexcept>
+
+#include "motion_planners/bidirectional_sst.hpp"
+
+backward_sst_t::backward_sst_t(
+    const double* in_start, const double* in_goal,
+    double in_radius,
+    const std::vector<std::pair<double, double> >& a_state_bounds,
+    const std::vector<std::pair<double, double> >& a_control_bounds,
+    std::function<double(const double*, const double*, unsigned int)> a_distance_function,
+    unsigned int random_seed,
+    double delta_near, double delta_drain,
+    nearest_neighbors_factory_t nearest_neighbors_factory)
+    : sst_t(in_start, in_goal, in_radius,
+            a_state_bounds, a_control_bounds, a_distance_function, random_seed,
+            delta_near, delta_drain, nearest_neighbors_factory)
+{
+}
+
+bool backward_sst_t::extend(system_interface* system, const sst_node_t* nearest, const double* sample_state,
+                            double* control, double* result_state,
+                            int min_time_steps, int max_time_steps, double integration_step, double& duration)
+{
+    reversible_system_interface* reversible = dynamic_cast<reversible_system_interface*>(system);
+    assert(reversible != NULL);
+    this->random_control(control);
+    int num_steps = this->random_generator.uniform_int_random(min_time_steps, max_time_steps);
+    duration = num_steps*integration_step;
+    return reversible->propagate_backward(
+        nearest->get_point(), this->state_dimension, control, this->control_dimension,
+        num_steps, result_state, integration_step);
+}
+
+bidirectional_sst_t::bidirectional_sst_t(
+    const double* in_start, const double* in_goal,
+    double in_radius,
+    const std::vector<std::pair<double, double> >& a_state_bounds,
+    const std::vector<std::pair<double, double> >& a_control_bounds,
+    std::function<double(const double*, const double*, unsigned int)> a_distance_function,
+    unsigned int random_seed,
+    double delta_near, double delta_drain,
+    double a_connection_radius,
+    nearest_neighbors_factory_t nearest_neighbors_factory)
+    : sst_t(in_start, in_goal, in_radius,
+            a_state_bounds, a_control_bounds, a_distance_function, random_seed,
+            delta_near, delta_drain, nearest_neighbors_factory)
+    // The goal tree has no goal region, a solution has to start exactly at the start state
+    , goal_tree(new backward_sst_t(in_goal, in_start, 0.,
+                                   a_state_bounds, a_control_bounds, a_distance_function, random_seed + 1,
+                                   delta_near, delta_drain, nearest_neighbors_factory))
+    , connection_radius(a_connection_radius)
+    , grow_goal_tree(false)
+    , connection_cost(std::numeric_limits<double>::infinity())
+    , connection_state(this->state_dimension)
+    , connection_result(this->state_dimension)
+    , connection_control(this->control_dimension)
+{
+}
+
+bidirectional_sst_t::~bidirectional_sst_t()
+{
+}
+
+void bidirectional_sst_t::step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step)
+{
+    if (grow_goal_tree) {
+        goal_tree->set_cost_bound(get_best_cost());
+        sst_node_t* goal_node = goal_tree->grow(system, min_time_steps, max_time_steps, integration_step);
+        if (goal_node != NULL) {
+            sst_node_t* start_node = find_cheapest_near(goal_node->get_point(), connection_radius);
+            if (start_node != NULL) {
+                connect(system, start_node, goal_node, integration_step);
+            }
+        }
+    } else {
+        sst_node_t* start_node = grow(system, min_time_steps, max_time_steps, integration_step);
+        if (start_node != NULL) {
+            sst_node_t* goal_node = goal_tree->find_cheapest_near(start_node->get_point(), connection_radius);
+            if (goal_node != NULL) {
+                connect(system, start_node, goal_node, integration_step);
+            }
+        }
+    }
+    grow_goal_tree = !grow_goal_tree;
+}
+
+void bidirectional_sst_t::connect(system_interface* system, const sst_node_t* start_node, const sst_node_t* goal_node,
+                                  double integration_step)
+{
+    double cost = start_node->get_cost() + goal_node->get_cost();
+    if (cost >= get_best_cost()) {
+        return;
+    }
+
+    std::vector<std::vector<double>> path;
+    std::vector<std::vector<double>> controls;
+    std::vector<double> durations;
+
+    std::deque<const sst_node_t*> start_branch;
+    const sst_node_t* v = start_node;
+    for (; v->get_parent() != NULL; v = v->get_parent()) {
+        start_branch.push_front(v);
+    }
+    path.push_back(std::vector<double>(v->get_point(), v->get_point() + this->state_dimension));
+    for (auto node: start_branch) {
+        path.push_back(std::vector<double>(node->get_point(), node->get_point() + this->state_dimension));
+        const double* control = node->get_parent_edge().get_control();
+        controls.push_back(std::vector<double>(control, control + this->control_dimension));
+        durations.push_back(node->get_parent_edge().get_duration());
+    }
+
+    double* state = &connection_state[0];
+    double* result = &connection_result[0];
+    std::copy(start_node->get_point(), start_node->get_point() + this->state_dimension, state);
+
+    // Bridge the gap between the trees if the system can steer exactly
+    reversible_system_interface* reversible = dynamic_cast<reversible_system_interface*>(system);
+    int num_steps;
+    if (reversible != NULL && reversible->steer(start_node->get_point(), goal_node->get_point(), this->state_dimension,
+                                                &connection_control[0], this->control_dimension,
+                                                num_steps, integration_step)) {
+        if (!system->propagate(state, this->state_dimension, &connection_control[0], this->control_dimension,
+                               num_steps, result, integration_step)) {
+            return;
+        }
+        cost += num_steps*integration_step;
+        if (cost >= get_best_cost()) {
+            return;
+        }
+        std::swap(state, result);
+        path.push_back(std::vector<double>(state, state + this->state_dimension));
+        controls.push_back(connection_control);
+        durations.push_back(num_steps*integration_step);
+    }
+
+    // Replay the goal branch forward, its edges were created backward from the parents
+    for (v = goal_node; v->get_parent() != NULL; v = v->get_parent()) {
+        const tree_edge_t& edge = v->get_parent_edge();
+        num_steps = (int)std::round(edge.get_duration()/integration_step);
+        if (!system->propagate(state, this->state_dimension, edge.get_control(), this->control_dimension,
+                               num_steps, result, integration_step)) {
+            return;
+        }
+        std::swap(state, result);
+        path.push_back(std::vector<double>(state, state + this->state_dimension));
+        controls.push_back(std::vector<double>(edge.get_control(), edge.get_control() + this->control_dimension));
+        durations.push_back(edge.get_duration());
+    }
+    if (this->distance(state, goal_state, this->state_dimension) >= goal_radius) {
+        return;
+    }
+
+    connection_cost = cost;
+    connection_path.swap(path);
+    connection_controls.swap(controls);
+    connection_durations.swap(durations);
+    set_cost_bound(std::min(cost_bound, connection_cost));
+}
+
+void bidirectional_sst_t::get_solution(std::vector<std::vector<double>>& solution_path, std::vector<std::vector<double>>& controls, std::vector<double>& costs)
+{
+    if (connection_cost < sst_t::get_best_cost()) {
+        solution_path = connection_path;
+        controls = connection_controls;
+        costs = connection_durations;
+        return;
+    }
+    sst_t::get_solution(solution_path, controls, costs);
+}
+
+bool bidirectional_sst_t::has_solution()
+{
+    return sst_t::has_solution() || connection_cost < std::numeric_limits<double>::infinity();
+}
+
+double bidirectional_sst_t::get_best_cost() const
+{
+    return std::min(sst_t::get_best_cost(), connection_cost);
+}
+
+void bidirectional_sst_t::export_tree(tree_data_t&) const
+{
+    throw std::runtime_error("The bidirectional SST can not be saved, a tree file holds a single tree");
+}
+
+void bidirectional_sst_t::import_tree(const tree_file_t&)
+{
+    throw std::runtime_error("The bidirectional SST can not be loaded, a tree file holds a single tree");
+}
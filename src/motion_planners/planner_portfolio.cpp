@@ -0,0 +1,93 @@
+/**
+ * @file planner_portfolio.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <assert.h>
+#include <limits>
+#include <thread>
+
+#include "motion_planners/planner_portfolio.hpp"
+#include "utilities/timer.hpp"
+
+planner_portfolio_t::planner_portfolio_t(const std::vector<planner_t*>& a_planners, const std::vector<system_interface*>& a_systems)
+    : planners(a_planners)
+    , systems(a_systems)
+    , cancelled(false)
+    , best_cost(std::numeric_limits<double>::infinity())
+{
+    assert(planners.size() > 0);
+    assert(planners.size() == systems.size());
+}
+
+int planner_portfolio_t::run(int min_time_steps, int max_time_steps, double integration_step,
+                             double time_budget, bool stop_at_solution, bool share_cost_bound)
+{
+    assert(time_budget < std::numeric_limits<double>::infinity() || stop_at_solution);
+    cancelled.store(false);
+    best_cost.store(std::numeric_limits<double>::infinity());
+    number_of_iterations.assign(planners.size(), 0);
+    for (auto planner: planners) {
+        offer_cost(planner->get_best_cost());
+    }
+
+    sys_timer_t timer;
+    timer.reset();
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < planners.size(); i++) {
+        threads.emplace_back([&, i]() {
+            planner_t* planner = planners[i];
+            // measure() updates the timer, every thread measures with its own copy
+            sys_timer_t thread_timer = timer;
+            while (!cancelled.load(std::memory_order_relaxed) && thread_timer.measure() < time_budget) {
+                if (share_cost_bound) {
+                    planner->set_cost_bound(best_cost.load(std::memory_order_relaxed));
+                }
+                planner->step(systems[i], min_time_steps, max_time_steps, integration_step);
+                number_of_iterations[i]++;
+                if (planner->has_solution()) {
+                    offer_cost(planner->get_best_cost());
+                    if (stop_at_solution) {
+                        cancel();
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    // The trees are pruned with the final best cost, whatever bound each thread saw last.
+    // The shared bound belongs to this run, later steps of the planners are not bounded by it
+    if (share_cost_bound) {
+        for (auto planner: planners) {
+            planner->set_cost_bound(best_cost.load(std::memory_order_relaxed));
+            planner->set_cost_bound(std::numeric_limits<double>::infinity());
+        }
+    }
+
+    int best_planner = -1;
+    for (unsigned int i = 0; i < planners.size(); i++) {
+        if (planners[i]->has_solution() &&
+            (best_planner < 0 || planners[i]->get_best_cost() < planners[best_planner]->get_best_cost())) {
+            best_planner = i;
+        }
+    }
+    return best_planner;
+}
+
+void planner_portfolio_t::offer_cost(double cost)
+{
+    double current = best_cost.load();
+    while (cost < current && !best_cost.compare_exchange_weak(current, cost)) {
+    }
+}
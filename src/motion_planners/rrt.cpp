@@ -17,9 +17,10 @@
 
 #include <iostream>
 #include <deque>
+#include <stdexcept>
 
 
-rrt_node_t::rrt_node_t(double* point, unsigned int state_dimension, rrt_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost)
+rrt_node_t::rrt_node_t(const double* point, unsigned int state_dimension, rrt_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost)
 	    : tree_node_t(point, state_dimension, std::move(a_parent_edge), a_cost)
 	    , parent(a_parent)
 {
@@ -32,56 +33,43 @@ rrt_node_t::~rrt_node_t() {
 
 void rrt_t::get_solution(std::vector<std::vector<double>>& solution_path, std::vector<std::vector<double>>& controls, std::vector<double>& costs)
 {
-    std::vector<proximity_node_t*> close_nodes = metric.find_delta_close_and_closest(goal_state, goal_radius);
-
-    double length = std::numeric_limits<double>::max();;
-    for(unsigned i=0;i<close_nodes.size();i++)
+    if(best_goal == NULL)
+        return;
+    const rrt_node_t* path_node = best_goal;
+    std::deque<const rrt_node_t*> path;
+    while(path_node->get_parent()!=NULL)
     {
-        rrt_node_t* v = (rrt_node_t*)(close_nodes[i]->get_state());
-        double temp = v->get_cost() ;
-        if( temp < length)
-        {
-            length = temp;
-            nearest = v;
-        }
+        path.push_front(path_node);
+        path_node = path_node->get_parent();
     }
-    //now nearest should be the closest node to the goal state
-    if(this->distance(goal_state,nearest->get_point(), this->state_dimension) < goal_radius)
-    {
-        std::deque<const rrt_node_t*> path;
-        while(nearest->get_parent()!=NULL)
-        {
-            path.push_front(nearest);
-            nearest = nearest->get_parent();
-        }
 
-        std::vector<double> root_state;
+    std::vector<double> root_state;
+    for (unsigned c=0; c<this->state_dimension; c++) {
+        root_state.push_back(root->get_point()[c]);
+    }
+    solution_path.push_back(root_state);
+
+    for(unsigned i=0;i<path.size();i++)
+    {
+        std::vector<double> current_state;
         for (unsigned c=0; c<this->state_dimension; c++) {
-            root_state.push_back(root->get_point()[c]);
+            current_state.push_back(path[i]->get_point()[c]);
         }
-        solution_path.push_back(root_state);
-
-        for(unsigned i=0;i<path.size();i++)
-        {
-            std::vector<double> current_state;
-            for (unsigned c=0; c<this->state_dimension; c++) {
-                current_state.push_back(path[i]->get_point()[c]);
-            }
-            solution_path.push_back(current_state);
-
-            std::vector<double> current_control;
-            for (unsigned c=0; c<this->control_dimension; c++) {
-                current_control.push_back(path[i]->get_parent_edge().get_control()[c]);
-            }
-            controls.push_back(current_control);
-            costs.push_back(path[i]->get_parent_edge().get_duration());
+        solution_path.push_back(current_state);
+
+        std::vector<double> current_control;
+        for (unsigned c=0; c<this->control_dimension; c++) {
+            current_control.push_back(path[i]->get_parent_edge().get_control()[c]);
         }
+        controls.push_back(current_control);
+        costs.push_back(path[i]->get_parent_edge().get_duration());
     }
 }
+
 void rrt_t::step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step)
 {
-    double* sample_state = new double[this->state_dimension];
-    double* sample_control = new double[this->control_dimension];
+    double* sample_state = this->scratch_state;
+    double* sample_control = this->scratch_control;
 
     this->random_state(sample_state);
     this->random_control(sample_control);
@@ -91,7 +79,8 @@ void rrt_t::step(system_interface* system, int min_time_steps, int max_time_step
     double duration = num_steps*integration_step;
     if(system->propagate(
         nearest->get_point(), this->state_dimension, sample_control, this->control_dimension,
-        num_steps, sample_state, integration_step))
+        num_steps, sample_state, integration_step) &&
+       nearest->get_cost() + duration <= cost_bound)
     {
         //create a new tree node
         rrt_node_t* new_node = static_cast<rrt_node_t*>(nearest->add_child(new rrt_node_t(
@@ -99,16 +88,68 @@ void rrt_t::step(system_interface* system, int min_time_steps, int max_time_step
             tree_edge_t(sample_control, this->control_dimension, duration),
             nearest->get_cost() + duration)
         ));
-        metric.add_node(new_node);
+        metric->add_node(new_node);
         number_of_nodes++;
+        if((best_goal == NULL || new_node->get_cost() < best_goal->get_cost()) &&
+           this->distance(new_node->get_point(), goal_state, this->state_dimension) < goal_radius)
+            best_goal = new_node;
     }
-    delete sample_state;
-    delete sample_control;
 }
 
 rrt_node_t* rrt_t::nearest_vertex(const double* state) const
 {
     double distance;
-    return (rrt_node_t*)(metric.find_closest(state, &distance)->get_state());
+    return (rrt_node_t*)(metric->find_closest(state, &distance)->get_state());
 }
 
+
+void rrt_t::export_tree(tree_data_t& data) const
+{
+    std::vector<const tree_node_t*> nodes;
+    this->export_nodes(std::vector<tree_node_t*>(1, this->root), data, nodes);
+}
+
+void rrt_t::import_tree(const tree_file_t& file)
+{
+    file.check_tree(this->state_dimension, this->control_dimension);
+    for (unsigned int i = 1; i < file.get_number_of_nodes(); i++) {
+        if (file.get_parents()[i] < 0) {
+            throw std::runtime_error("RRT can not import a tree with several roots");
+        }
+    }
+
+    std::vector<tree_node_t*> stack(1, this->root);
+    while (!stack.empty()) {
+        tree_node_t* v = stack.back();
+        stack.pop_back();
+        metric->remove_node(v);
+        for (tree_node_t* child: v->get_children()) {
+            stack.push_back(child);
+        }
+    }
+    delete this->root;
+    best_goal = nullptr;
+    number_of_nodes = 0;
+
+    std::vector<rrt_node_t*> nodes(file.get_number_of_nodes());
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        const double* point = file.get_states() + (size_t)i * this->state_dimension;
+        if (i == 0) {
+            nodes[i] = new rrt_node_t(point, this->state_dimension, NULL, tree_edge_t(NULL, 0, -1.), 0.);
+        } else {
+            rrt_node_t* parent = nodes[file.get_parents()[i]];
+            nodes[i] = static_cast<rrt_node_t*>(parent->add_child(new rrt_node_t(
+                point, this->state_dimension, parent,
+                tree_edge_t(file.get_controls() + (size_t)i * this->control_dimension, this->control_dimension, file.get_durations()[i]),
+                file.get_costs()[i])
+            ));
+            if ((best_goal == NULL || nodes[i]->get_cost() < best_goal->get_cost()) &&
+                this->distance(point, goal_state, this->state_dimension) < goal_radius)
+                best_goal = nodes[i];
+        }
+        metric->add_node(nodes[i]);
+        number_of_nodes++;
+    }
+    this->root = nodes[0];
+    std::copy(root->get_point(), root->get_point() + this->state_dimension, start_state);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file sampler.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "motion_planners/sampler.hpp"
+
+uniform_sampler_t::uniform_sampler_t(const std::vector<std::pair<double, double> >& a_state_bounds)
+    : state_bounds(a_state_bounds)
+{
+}
+
+void uniform_sampler_t::sample(RandomGenerator& random_generator, double best_cost, double* state)
+{
+    for (unsigned int i = 0; i < this->state_bounds.size(); ++i) {
+        state[i] = random_generator.uniform_random(this->state_bounds[i].first, this->state_bounds[i].second);
+    }
+}
+
+goal_biased_sampler_t::goal_biased_sampler_t(sampler_t* a_base_sampler, const double* a_goal_state,
+                                             unsigned int a_state_dimension, double a_goal_bias)
+    : base_sampler(a_base_sampler)
+    , goal_state(a_goal_state)
+    , state_dimension(a_state_dimension)
+    , goal_bias(a_goal_bias)
+{
+}
+
+void goal_biased_sampler_t::sample(RandomGenerator& random_generator, double best_cost, double* state)
+{
+    if (random_generator.uniform_random(0, 1) < this->goal_bias) {
+        std::copy(this->goal_state, this->goal_state + this->state_dimension, state);
+    } else {
+        this->base_sampler->sample(random_generator, best_cost, state);
+    }
+}
+
+informed_sampler_t::informed_sampler_t(sampler_t* a_base_sampler, std::function<double(const double*)> a_cost_lower_bound,
+                                       unsigned int a_max_attempts)
+    : base_sampler(a_base_sampler)
+    , cost_lower_bound(a_cost_lower_bound)
+    , max_attempts(a_max_attempts)
+    , number_of_rejections(0)
+{
+}
+
+void informed_sampler_t::sample(RandomGenerator& random_generator, double best_cost, double* state)
+{
+    this->base_sampler->sample(random_generator, best_cost, state);
+    if (std::isinf(best_cost)) {
+        return;
+    }
+    for (unsigned int attempt = 1; attempt < this->max_attempts && this->cost_lower_bound(state) > best_cost; attempt++) {
+        this->number_of_rejections++;
+        this->base_sampler->sample(random_generator, best_cost, state);
+    }
+}
+
+function_sampler_t::function_sampler_t(std::function<void(double, double*)> a_sample_function)
+    : sample_function(a_sample_function)
+{
+}
+
+void function_sampler_t::sample(RandomGenerator& random_generator, double best_cost, double* state)
+{
+    this->sample_function(best_cost, state);
+}
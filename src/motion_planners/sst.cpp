@@ -17,12 +17,18 @@
 
 #include <iostream>
 #include <deque>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
 
 
-sst_node_t::sst_node_t(const double* point, unsigned int state_dimension, sst_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost)
-    : tree_node_t(point, state_dimension, std::move(a_parent_edge), a_cost)
+sst_node_t::sst_node_t(const double* point, unsigned int state_dimension, sst_node_t* a_parent, tree_edge_t&& a_parent_edge, double a_cost,
+                       double* storage)
+    : tree_node_t(point, state_dimension, std::move(a_parent_edge), a_cost, storage)
     , parent(a_parent)
+    , subtree_cost_bound(std::numeric_limits<double>::infinity())
     , active(true)
+    , on_solution_path(false)
     , witness(NULL)
 {
 
@@ -32,12 +38,72 @@ sst_node_t::~sst_node_t() {
 
 }
 
+namespace
+{
+    sst_node_t* first_costlier_sibling(tree_node_t* node, double cost_threshold)
+    {
+        while (node != NULL && static_cast<sst_node_t*>(node)->get_subtree_cost_bound() <= cost_threshold) {
+            node = node->get_next_sibling();
+        }
+        return static_cast<sst_node_t*>(node);
+    }
+
+    sst_node_t* deepest_costlier_descendant(sst_node_t* node, double cost_threshold)
+    {
+        sst_node_t* child = first_costlier_sibling(node->get_first_child(), cost_threshold);
+        while (child != NULL) {
+            node = child;
+            child = first_costlier_sibling(node->get_first_child(), cost_threshold);
+        }
+        return node;
+    }
+}
+
+void init_subtree_cost_bound(sst_node_t* node, bool has_solution)
+{
+    double bound = has_solution ? node->get_cost() : std::numeric_limits<double>::infinity();
+    node->set_subtree_cost_bound(bound);
+    for (sst_node_t* ancestor = node->get_parent();
+         ancestor != NULL && ancestor->get_subtree_cost_bound() < bound;
+         ancestor = ancestor->get_parent()) {
+        ancestor->set_subtree_cost_bound(bound);
+    }
+}
+
+void update_solution_path(sst_node_t* previous_goal, sst_node_t* new_goal)
+{
+    for (sst_node_t* v = previous_goal; v != NULL && v->get_parent() != NULL; v = v->get_parent()) {
+        v->set_on_solution_path(false);
+    }
+    for (sst_node_t* v = new_goal; v != NULL && v->get_parent() != NULL; v = v->get_parent()) {
+        v->set_on_solution_path(true);
+    }
+}
+
+void visit_costlier_nodes(sst_node_t* start, double cost_threshold, const std::function<void(sst_node_t*)>& visit)
+{
+    sst_node_t* node = deepest_costlier_descendant(start, cost_threshold);
+    while (true) {
+        // The links are read before the visit because the visitor may remove the node
+        bool is_start = node == start;
+        sst_node_t* parent = node->get_parent();
+        sst_node_t* next = is_start ? NULL : first_costlier_sibling(node->get_next_sibling(), cost_threshold);
+        node->set_subtree_cost_bound(cost_threshold);
+        visit(node);
+        if (is_start) {
+            return;
+        }
+        node = next != NULL ? deepest_costlier_descendant(next, cost_threshold) : parent;
+    }
+}
+
 
 sample_node_t::sample_node_t(
     sst_node_t* const representative,
-    const double* a_point, unsigned int state_dimension)
-    : state_point_t(a_point, state_dimension)
+    const double* a_point, unsigned int state_dimension, double* storage)
+    : state_point_t(a_point, state_dimension, storage)
     , rep(representative)
+    , goal_distance(std::numeric_limits<double>::infinity())
 {
 
 }
@@ -54,12 +120,20 @@ sst_t::sst_t(
     const std::vector<std::pair<double, double> >& a_control_bounds,
     std::function<double(const double*, const double*, unsigned int)> a_distance_function,
     unsigned int random_seed,
-    double delta_near, double delta_drain)
+    double delta_near, double delta_drain,
+    nearest_neighbors_factory_t nearest_neighbors_factory)
     : planner_t(in_start, in_goal, in_radius,
                 a_state_bounds, a_control_bounds, a_distance_function, random_seed)
+    , metric(create_nearest_neighbors(nearest_neighbors_factory))
     , best_goal(nullptr)
+    , node_arena(this->state_dimension, this->control_dimension)
+    , witness_arena(this->state_dimension, 0)
+    , samples(create_nearest_neighbors(nearest_neighbors_factory))
     , sst_delta_near(delta_near)
     , sst_delta_drain(delta_drain)
+    , defer_node_deletion(false)
+    , metric_distance(true)
+    , retain_tree(false)
 {
     //initialize the metrics
     unsigned int state_dimensions = this->get_state_dimension();
@@ -67,26 +141,57 @@ sst_t::sst_t(
         [state_dimensions, a_distance_function](const double* s0, const double* s1) {
             return a_distance_function(s0, s1, state_dimensions);
         };
-    metric.set_distance(raw_distance);
+    metric->set_distance(raw_distance, state_dimensions);
 
-    root = new sst_node_t(in_start, a_state_bounds.size(), nullptr, tree_edge_t(nullptr, 0, -1.), 0.);
-    metric.add_node(root);
+    root = create_node(in_start, nullptr, nullptr, -1., 0.);
+    roots.push_back(static_cast<sst_node_t*>(root));
+    metric->add_node(root);
     number_of_nodes++;
 
-    samples.set_distance(raw_distance);
+    samples->set_distance(raw_distance, state_dimensions);
 
-    sample_node_t* first_witness_sample = new sample_node_t(static_cast<sst_node_t*>(root), start_state, this->state_dimension);
-    samples.add_node(first_witness_sample);
+    sample_node_t* first_witness_sample = create_witness(static_cast<sst_node_t*>(root), start_state);
+    samples->add_node(first_witness_sample);
     witness_nodes.push_back(first_witness_sample);
 }
 
 sst_t::~sst_t() {
-    delete root;
+    for (auto tree_root: this->roots) {
+        node_arena.destroy_tree(tree_root);
+    }
     for (auto w: this->witness_nodes) {
-        delete w;
+        witness_arena.destroy(w);
     }
 }
 
+sst_node_t* sst_t::create_node(const double* point, sst_node_t* parent, const double* control, double duration, double cost)
+{
+    void* block = node_arena.allocate();
+    unsigned int edge_control_dimension = parent ? this->control_dimension : 0;
+    return new (block) sst_node_t(
+        point, this->state_dimension, parent,
+        tree_edge_t(control, edge_control_dimension, duration, node_arena.get_control_storage(block)),
+        cost, node_arena.get_point_storage(block));
+}
+
+sample_node_t* sst_t::create_witness(sst_node_t* representative, const double* point)
+{
+    void* block = witness_arena.allocate();
+    sample_node_t* witness = new (block) sample_node_t(
+        representative, point, this->state_dimension, witness_arena.get_point_storage(block));
+    witness->set_goal_distance(this->distance(point, goal_state, this->state_dimension));
+    return witness;
+}
+
+
+double sst_t::get_start_distance(const double* state) const
+{
+    double start_distance = std::numeric_limits<double>::infinity();
+    for (auto tree_root: roots) {
+        start_distance = std::min(start_distance, this->distance(tree_root->get_point(), state, this->state_dimension));
+    }
+    return start_distance;
+}
 
 void sst_t::get_solution(std::vector<std::vector<double>>& solution_path, std::vector<std::vector<double>>& controls, std::vector<double>& costs)
 {
@@ -104,7 +209,7 @@ void sst_t::get_solution(std::vector<std::vector<double>>& solution_path, std::v
 
     std::vector<double> root_state;
     for (unsigned c=0; c<this->state_dimension; c++) {
-        root_state.push_back(root->get_point()[c]);
+        root_state.push_back(nearest_path_node->get_point()[c]);
     }
     solution_path.push_back(root_state);
 
@@ -126,6 +231,11 @@ void sst_t::get_solution(std::vector<std::vector<double>>& solution_path, std::v
 }
 
 void sst_t::step(system_interface* system, int min_time_steps, int max_time_steps, double integration_step)
+{
+    grow(system, min_time_steps, max_time_steps, integration_step);
+}
+
+sst_node_t* sst_t::grow(system_interface* system, int min_time_steps, int max_time_steps, double integration_step)
 {
     /*
      * Generate a random sample
@@ -134,31 +244,90 @@ void sst_t::step(system_interface* system, int min_time_steps, int max_time_step
      * Propagate for random time with constant random control from the closest node
      * If resulting state is valid, add a resulting state into the tree and perform sst-specific graph manipulations
      */
-    double* sample_state = new double[this->state_dimension];
-    double* sample_control = new double[this->control_dimension];
-	this->random_state(sample_state);
-	this->random_control(sample_control);
+    double* sample_state = this->scratch_state;
+    double* sample_control = this->scratch_control;
+    draw_sample(sample_state);
     sst_node_t* nearest = nearest_vertex(sample_state);
-	int num_steps = this->random_generator.uniform_int_random(min_time_steps, max_time_steps);
-    double duration = num_steps*integration_step;
-	if(system->propagate(
-	    nearest->get_point(), this->state_dimension, sample_control, this->control_dimension,
-	    num_steps, sample_state, integration_step))
+    double duration;
+	if(extend(system, nearest, sample_state, sample_control, sample_state,
+	          min_time_steps, max_time_steps, integration_step, duration))
 	{
-		add_to_tree(sample_state, sample_control, nearest, duration);
+		return add_to_tree(sample_state, sample_control, nearest, duration);
 	}
-    delete sample_state;
-    delete sample_control;
+	return NULL;
+}
+
+void sst_t::draw_sample(double* sample_state)
+{
+    this->random_state(sample_state);
+}
+
+bool sst_t::extend(system_interface* system, const sst_node_t* nearest, const double* sample_state,
+                   double* control, double* result_state,
+                   int min_time_steps, int max_time_steps, double integration_step, double& duration)
+{
+	this->random_control(control);
+	int num_steps = this->random_generator.uniform_int_random(min_time_steps, max_time_steps);
+    duration = num_steps*integration_step;
+	return system->propagate(
+	    nearest->get_point(), this->state_dimension, control, this->control_dimension,
+	    num_steps, result_state, integration_step);
+}
+
+void sst_t::step_parallel(const std::vector<system_interface*>& systems, int min_time_steps, int max_time_steps,
+                          double integration_step, unsigned int batch_size)
+{
+    assert(systems.size() > 0);
+    if (!thread_pool || thread_pool->get_number_of_threads() != systems.size()) {
+        thread_pool.reset(new thread_pool_t(systems.size()));
+    }
+    batch_states.resize(batch_size * this->state_dimension);
+    batch_controls.resize(batch_size * this->control_dimension);
+    batch_results.resize(batch_size * this->state_dimension);
+    batch_steps.resize(batch_size);
+    batch_nearest.resize(batch_size);
+    batch_valid.resize(batch_size);
+
+    // Sample in the same order as step() does
+    for (unsigned int i = 0; i < batch_size; i++) {
+        double* sample_state = &batch_states[i * this->state_dimension];
+        draw_sample(sample_state);
+        this->random_control(&batch_controls[i * this->control_dimension]);
+        batch_nearest[i] = nearest_vertex(sample_state);
+        batch_steps[i] = this->random_generator.uniform_int_random(min_time_steps, max_time_steps);
+    }
+
+    thread_pool->parallel_for(batch_size, [&](unsigned int i, unsigned int thread) {
+        batch_valid[i] = systems[thread]->propagate(
+            batch_nearest[i]->get_point(), this->state_dimension,
+            &batch_controls[i * this->control_dimension], this->control_dimension,
+            batch_steps[i], &batch_results[i * this->state_dimension], integration_step);
+    });
+
+    // Nodes pruned by earlier samples stay allocated until the batch is done
+    defer_node_deletion = true;
+    for (unsigned int i = 0; i < batch_size; i++) {
+        if (batch_valid[i] && batch_nearest[i]->is_active()) {
+            add_to_tree(&batch_results[i * this->state_dimension], &batch_controls[i * this->control_dimension],
+                        batch_nearest[i], batch_steps[i] * integration_step);
+        }
+    }
+    defer_node_deletion = false;
+    for (auto node: removed_nodes) {
+        node_arena.destroy(node);
+    }
+    removed_nodes.clear();
 }
 
 sst_node_t* sst_t::nearest_vertex(const double* sample_state)
 {
 	//performs the best near query
-    std::vector<proximity_node_t*> close_nodes = metric.find_delta_close_and_closest(sample_state, this->sst_delta_near);
+    unsigned int number_of_close_nodes = metric->find_delta_close_and_closest(
+        sample_state, &close_nodes[0], &close_distances[0], this->sst_delta_near);
 
     double length = std::numeric_limits<double>::max();;
     sst_node_t* nearest = nullptr;
-    for(unsigned i=0;i<close_nodes.size();i++)
+    for(unsigned i=0;i<number_of_close_nodes;i++)
     {
         tree_node_t* v = (tree_node_t*)(close_nodes[i]->get_state());
         double temp = v->get_cost() ;
@@ -172,37 +341,40 @@ sst_node_t* sst_t::nearest_vertex(const double* sample_state)
     return nearest;
 }
 
-void sst_t::add_to_tree(const double* sample_state, const double* sample_control, sst_node_t* nearest, double duration)
+sst_node_t* sst_t::add_to_tree(const double* sample_state, const double* sample_control, sst_node_t* nearest, double duration)
 {
 	//check to see if a sample exists within the vicinity of the new node
-    sample_node_t* witness_sample = find_witness(sample_state);
+    double witness_distance;
+    sample_node_t* witness_sample = find_witness(sample_state, witness_distance);
 
     sst_node_t* representative = witness_sample->get_representative();
 	if(representative==NULL || representative->get_cost() > nearest->get_cost() + duration)
 	{
-		if(best_goal==NULL || nearest->get_cost() + duration <= best_goal->get_cost())
+		if((best_goal==NULL || retain_tree || nearest->get_cost() + duration <= best_goal->get_cost()) &&
+		   nearest->get_cost() + duration <= cost_bound)
 		{
 			//create a new tree node
 			//set parent's child
 			sst_node_t* new_node = static_cast<sst_node_t*>(nearest->add_child(
-			    new sst_node_t(
-                    sample_state, this->state_dimension,
-                    nearest,
-                    tree_edge_t(sample_control, this->control_dimension, duration),
-                    nearest->get_cost() + duration)
+			    create_node(sample_state, nearest, sample_control, duration, nearest->get_cost() + duration)
             ));
 			number_of_nodes++;
+			init_subtree_cost_bound(new_node, best_goal != NULL);
 
-	        if(best_goal==NULL && this->distance(new_node->get_point(), goal_state, this->state_dimension)<goal_radius)
+	        if(best_goal==NULL && is_in_goal_region(new_node, witness_sample, witness_distance))
 	        {
+	        	update_solution_path(best_goal, new_node);
 	        	best_goal = new_node;
-	        	branch_and_bound((sst_node_t*)root);
+	        	if (!retain_tree)
+	        		prune();
 	        }
 	        else if(best_goal!=NULL && best_goal->get_cost() > new_node->get_cost() &&
-	                this->distance(new_node->get_point(), goal_state, this->state_dimension)<goal_radius)
+	                is_in_goal_region(new_node, witness_sample, witness_distance))
 	        {
+	        	update_solution_path(best_goal, new_node);
 	        	best_goal = new_node;
-	        	branch_and_bound((sst_node_t*)root);
+	        	if (!retain_tree)
+	        		prune();
 	        }
 
             // Acquire representative again - it can be different
@@ -212,7 +384,7 @@ void sst_t::add_to_tree(const double* sample_state, const double* sample_control
 				//optimization for sparsity
 				if(representative->is_active())
 				{
-					metric.remove_node(representative);
+					metric->remove_node(representative);
 					representative->make_inactive();
 				}
 
@@ -227,43 +399,254 @@ void sst_t::add_to_tree(const double* sample_state, const double* sample_control
 			}
 			witness_sample->set_representative(new_node);
 			new_node->set_witness(witness_sample);
-			metric.add_node(new_node);
+			metric->add_node(new_node);
+			return new_node;
 		}
-	}	
+	}
+	return NULL;
+}
 
+sst_node_t* sst_t::find_cheapest_near(const double* state, double radius)
+{
+    unsigned int number_of_close_nodes = metric->find_delta_close_and_closest(
+        state, &close_nodes[0], &close_distances[0], radius);
+
+    sst_node_t* cheapest = NULL;
+    for(unsigned i=0;i<number_of_close_nodes;i++)
+    {
+        sst_node_t* v = (sst_node_t*)(close_nodes[i]->get_state());
+        // The closest node is returned even if it is outside of the radius
+        if(close_distances[i] < radius && (cheapest == NULL || v->get_cost() < cheapest->get_cost()))
+            cheapest = v;
+    }
+    return cheapest;
+}
+
+void sst_t::set_goal(const double* in_goal, double in_radius)
+{
+    std::copy(in_goal, in_goal + this->state_dimension, goal_state);
+    goal_radius = in_radius;
+    // A bound of the previous query does not hold for the new goal
+    cost_bound = std::numeric_limits<double>::infinity();
+    for (auto w: witness_nodes) {
+        w->set_goal_distance(this->distance(w->get_point(), goal_state, this->state_dimension));
+    }
+    search_best_goal();
 }
 
-sample_node_t* sst_t::find_witness(const double* sample_state)
+void sst_t::search_best_goal()
 {
-	double distance;
-    sample_node_t* witness_sample = (sample_node_t*)samples.find_closest(sample_state, &distance)->get_state();
-	if(distance > this->sst_delta_drain)
+    sst_node_t* new_goal = NULL;
+    std::vector<sst_node_t*> stack(roots.begin(), roots.end());
+    while (!stack.empty()) {
+        sst_node_t* v = stack.back();
+        stack.pop_back();
+        if (v->get_parent() != NULL && (new_goal == NULL || v->get_cost() < new_goal->get_cost()) &&
+            this->distance(v->get_point(), goal_state, this->state_dimension) < goal_radius) {
+            new_goal = v;
+        }
+        for (tree_node_t* child: v->get_children()) {
+            stack.push_back(static_cast<sst_node_t*>(child));
+        }
+    }
+
+    update_solution_path(best_goal, new_goal);
+    best_goal = new_goal;
+    if (!retain_tree) {
+        prune();
+    }
+}
+
+void sst_t::prune()
+{
+    if (best_goal == NULL) {
+        return;
+    }
+    for (auto tree_root: roots)
+        branch_and_bound(tree_root, best_goal->get_cost());
+}
+
+void sst_t::set_cost_bound(double bound)
+{
+    bool tighter = bound < cost_bound;
+    planner_t::set_cost_bound(bound);
+    if (!tighter || retain_tree || bound >= get_best_cost()) {
+        return;
+    }
+    for (auto tree_root: roots)
+        branch_and_bound(tree_root, bound);
+    // The kept solution path may be costlier than the bound, its subtree cost bounds are raised back
+    if (best_goal != NULL)
+        init_subtree_cost_bound(best_goal, true);
+}
+
+void sst_t::add_start(const double* in_start)
+{
+    sst_node_t* new_root = create_node(in_start, nullptr, nullptr, -1., 0.);
+    roots.push_back(new_root);
+    number_of_nodes++;
+    init_subtree_cost_bound(new_root, best_goal != NULL);
+
+    double witness_distance;
+    sample_node_t* witness_sample = find_witness(in_start, witness_distance);
+    sst_node_t* representative = witness_sample->get_representative();
+    if (representative == NULL || representative->get_cost() > 0) {
+        if (representative != NULL) {
+            if (representative->is_active()) {
+                metric->remove_node(representative);
+                representative->make_inactive();
+            }
+            sst_node_t* iter = representative;
+            while (is_leaf(iter) && !iter->is_active() && !is_best_goal(iter)) {
+                sst_node_t* next = iter->get_parent();
+                remove_leaf(iter);
+                iter = next;
+            }
+        }
+        witness_sample->set_representative(new_root);
+    }
+    // A start close to another start keeps its tree, both roots stay active
+    new_root->set_witness(witness_sample);
+    metric->add_node(new_root);
+}
+
+void sst_t::export_tree(tree_data_t& data) const
+{
+    std::vector<const tree_node_t*> nodes;
+    this->export_nodes(std::vector<tree_node_t*>(roots.begin(), roots.end()), data, nodes);
+
+    std::unordered_map<const tree_node_t*, int32_t> node_indices;
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        node_indices[nodes[i]] = i;
+    }
+    std::unordered_map<const sample_node_t*, int32_t> witness_indices;
+    for (unsigned int i = 0; i < witness_nodes.size(); i++) {
+        const sample_node_t* w = witness_nodes[i];
+        witness_indices[w] = i;
+        data.witness_states.insert(data.witness_states.end(), w->get_point(), w->get_point() + this->state_dimension);
+        auto representative = node_indices.find(w->get_representative());
+        data.representatives.push_back(representative != node_indices.end() ? representative->second : -1);
+    }
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        const sst_node_t* node = static_cast<const sst_node_t*>(nodes[i]);
+        if (!node->is_active()) {
+            data.flags[i] &= ~TREE_FILE_NODE_ACTIVE;
+        }
+        auto witness = witness_indices.find(node->get_witness());
+        if (witness != witness_indices.end()) {
+            data.node_witnesses[i] = witness->second;
+        }
+    }
+}
+
+void sst_t::import_tree(const tree_file_t& file)
+{
+    file.check_tree(this->state_dimension, this->control_dimension);
+    if (file.get_number_of_witnesses() == 0) {
+        throw std::runtime_error("SST can only import trees with witnesses");
+    }
+
+    update_solution_path(best_goal, NULL);
+    best_goal = NULL;
+    cost_bound = std::numeric_limits<double>::infinity();
+    std::vector<sst_node_t*> stack(roots.begin(), roots.end());
+    while (!stack.empty()) {
+        sst_node_t* v = stack.back();
+        stack.pop_back();
+        if (v->is_active()) {
+            metric->remove_node(v);
+        }
+        for (tree_node_t* child: v->get_children()) {
+            stack.push_back(static_cast<sst_node_t*>(child));
+        }
+    }
+    for (auto tree_root: roots) {
+        node_arena.destroy_tree(tree_root);
+    }
+    for (auto w: witness_nodes) {
+        samples->remove_node(w);
+        witness_arena.destroy(w);
+    }
+    roots.clear();
+    witness_nodes.clear();
+    number_of_nodes = 0;
+
+    std::vector<sst_node_t*> nodes(file.get_number_of_nodes());
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        const double* point = file.get_states() + (size_t)i * this->state_dimension;
+        int32_t parent_index = file.get_parents()[i];
+        sst_node_t* parent = parent_index < 0 ? NULL : nodes[parent_index];
+        const double* control = parent ? file.get_controls() + (size_t)i * this->control_dimension : nullptr;
+        nodes[i] = create_node(point, parent, control, file.get_durations()[i], file.get_costs()[i]);
+        if (parent) {
+            parent->add_child(nodes[i]);
+        } else {
+            roots.push_back(nodes[i]);
+        }
+        number_of_nodes++;
+        init_subtree_cost_bound(nodes[i], false);
+        if (file.get_flags()[i] & TREE_FILE_NODE_ACTIVE) {
+            metric->add_node(nodes[i]);
+        } else {
+            nodes[i]->make_inactive();
+        }
+    }
+    root = roots[0];
+    std::copy(root->get_point(), root->get_point() + this->state_dimension, start_state);
+
+    for (unsigned int i = 0; i < file.get_number_of_witnesses(); i++) {
+        int32_t representative = file.get_representatives()[i];
+        sample_node_t* w = create_witness(representative < 0 ? NULL : nodes[representative],
+                                          file.get_witness_states() + (size_t)i * this->state_dimension);
+        samples->add_node(w);
+        witness_nodes.push_back(w);
+    }
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        if (file.get_node_witnesses()[i] >= 0) {
+            nodes[i]->set_witness(witness_nodes[file.get_node_witnesses()[i]]);
+        }
+    }
+    search_best_goal();
+}
+
+sample_node_t* sst_t::find_witness(const double* sample_state, double& witness_distance)
+{
+    sample_node_t* witness_sample = (sample_node_t*)samples->find_closest(sample_state, &witness_distance)->get_state();
+	if(witness_distance > this->sst_delta_drain)
 	{
 		//create a new sample
-		witness_sample = new sample_node_t(NULL, sample_state, this->state_dimension);
-		samples.add_node(witness_sample);
+		witness_sample = create_witness(NULL, sample_state);
+		samples->add_node(witness_sample);
 		witness_nodes.push_back(witness_sample);
+		witness_distance = 0;
 	}
     return witness_sample;
 }
 
-void sst_t::branch_and_bound(sst_node_t* node)
+bool sst_t::is_in_goal_region(const sst_node_t* node, const sample_node_t* witness, double witness_distance) const
 {
-    // Copy children becuase apparently, they are going to be modified
-    std::list<tree_node_t*> children = node->get_children();
-    for (std::list<tree_node_t*>::const_iterator iter = children.begin(); iter != children.end(); ++iter)
-    {
-    	branch_and_bound((sst_node_t*)(*iter));
-    }
-    if(is_leaf(node) && node->get_cost() > best_goal->get_cost())
-    {
-    	if(node->is_active())
-    	{
-	    	node->get_witness()->set_representative(NULL);
-	    	metric.remove_node(node);
-	    }
-    	remove_leaf(node);
-    }
+    if(!metric_distance)
+        return this->distance(node->get_point(), goal_state, this->state_dimension) < goal_radius;
+    if(witness->get_goal_distance() - witness_distance >= goal_radius)
+        return false;
+    if(witness_distance == 0)
+        return witness->get_goal_distance() < goal_radius;
+    return this->distance(node->get_point(), goal_state, this->state_dimension) < goal_radius;
+}
+
+void sst_t::branch_and_bound(sst_node_t* node, double cost_threshold)
+{
+    visit_costlier_nodes(node, cost_threshold, [this, cost_threshold](sst_node_t* v) {
+        if(is_leaf(v) && v->get_cost() > cost_threshold && !is_best_goal(v))
+        {
+            if(v->is_active())
+            {
+                v->get_witness()->set_representative(NULL);
+                metric->remove_node(v);
+            }
+            remove_leaf(v);
+        }
+    });
 }
 
 bool sst_t::is_leaf(tree_node_t* node)
@@ -278,24 +661,16 @@ void sst_t::remove_leaf(sst_node_t* node)
 		node->get_parent_edge();
 		node->get_parent()->remove_child(node);
 		number_of_nodes--;
-		delete node;
+		node->make_inactive();
+		if(defer_node_deletion)
+			removed_nodes.push_back(node);
+		else
+			node_arena.destroy(node);
 	}
 }
 
 bool sst_t::is_best_goal(tree_node_t* v)
 {
-	if(best_goal==NULL)
-		return false;
-    sst_node_t* new_v = best_goal;
-
-    while(new_v->get_parent()!=NULL)
-    {
-        if(new_v == v)
-            return true;
-
-        new_v = new_v->get_parent();
-    }
-    return false;
-
+    return static_cast<sst_node_t*>(v)->is_on_solution_path();
 }
 
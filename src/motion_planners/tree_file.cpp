@@ -0,0 +1,220 @@
+/**
+ * @file tree_file.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <assert.h>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "motion_planners/tree_file.hpp"
+
+namespace
+{
+    uint64_t align_offset(uint64_t offset)
+    {
+        return (offset + TREE_FILE_ALIGNMENT - 1) / TREE_FILE_ALIGNMENT * TREE_FILE_ALIGNMENT;
+    }
+
+    template <class value_t>
+    uint64_t place_array(uint64_t& offset, size_t size)
+    {
+        uint64_t start = align_offset(offset);
+        offset = start + size * sizeof(value_t);
+        return start;
+    }
+
+    template <class value_t>
+    void write_array(std::ofstream& stream, uint64_t offset, const std::vector<value_t>& values)
+    {
+        static const char padding[TREE_FILE_ALIGNMENT] = {0};
+        stream.write(padding, offset - (uint64_t)stream.tellp());
+        stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(value_t));
+    }
+
+    // The number of items is a product of 32 bit header fields, the byte size may not fit in 64 bits,
+    // so the space left in the file is divided by the item size instead
+    void check_array(size_t mapping_size, uint64_t offset, uint64_t count, size_t item_size)
+    {
+        if (offset % TREE_FILE_ALIGNMENT != 0 || offset > mapping_size || count > (mapping_size - offset) / item_size) {
+            throw std::runtime_error("Tree file is truncated or corrupted");
+        }
+    }
+}
+
+tree_file_t::tree_file_t(const std::string& filename)
+    : mapping(MAP_FAILED)
+    , mapping_size(0)
+    , header(NULL)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can not open tree file " + filename);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && (size_t)file_stat.st_size >= sizeof(tree_file_header_t)) {
+        mapping_size = file_stat.st_size;
+        mapping = mmap(NULL, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Can not map tree file " + filename);
+    }
+
+    header = static_cast<const tree_file_header_t*>(mapping);
+    try {
+        if (std::memcmp(header->magic, TREE_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != TREE_FILE_VERSION) {
+            throw std::runtime_error("Not a tree file or unsupported version: " + filename);
+        }
+        uint64_t nodes = header->number_of_nodes;
+        uint64_t witnesses = header->number_of_witnesses;
+        check_array(mapping_size, header->states_offset, nodes * header->state_dimension, sizeof(double));
+        check_array(mapping_size, header->controls_offset, nodes * header->control_dimension, sizeof(double));
+        check_array(mapping_size, header->durations_offset, nodes, sizeof(double));
+        check_array(mapping_size, header->costs_offset, nodes, sizeof(double));
+        check_array(mapping_size, header->parents_offset, nodes, sizeof(int32_t));
+        check_array(mapping_size, header->node_witnesses_offset, nodes, sizeof(int32_t));
+        check_array(mapping_size, header->flags_offset, nodes, sizeof(uint8_t));
+        check_array(mapping_size, header->witness_states_offset, witnesses * header->state_dimension, sizeof(double));
+        check_array(mapping_size, header->representatives_offset, witnesses, sizeof(int32_t));
+    } catch (...) {
+        munmap(mapping, mapping_size);
+        throw;
+    }
+}
+
+tree_file_t::~tree_file_t()
+{
+    munmap(mapping, mapping_size);
+}
+
+void tree_file_t::write(const std::string& filename, const tree_data_t& data)
+{
+    size_t nodes = data.costs.size();
+    size_t witnesses = data.representatives.size();
+    assert(data.states.size() == nodes * data.state_dimension);
+    assert(data.controls.size() == nodes * data.control_dimension);
+    assert(data.durations.size() == nodes && data.parents.size() == nodes);
+    assert(data.node_witnesses.size() == nodes && data.flags.size() == nodes);
+    assert(data.witness_states.size() == witnesses * data.state_dimension);
+
+    tree_file_header_t header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TREE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TREE_FILE_VERSION;
+    header.state_dimension = data.state_dimension;
+    header.control_dimension = data.control_dimension;
+    header.number_of_nodes = nodes;
+    header.number_of_witnesses = witnesses;
+
+    uint64_t offset = sizeof(header);
+    header.states_offset = place_array<double>(offset, data.states.size());
+    header.controls_offset = place_array<double>(offset, data.controls.size());
+    header.durations_offset = place_array<double>(offset, data.durations.size());
+    header.costs_offset = place_array<double>(offset, data.costs.size());
+    header.parents_offset = place_array<int32_t>(offset, data.parents.size());
+    header.node_witnesses_offset = place_array<int32_t>(offset, data.node_witnesses.size());
+    header.flags_offset = place_array<uint8_t>(offset, data.flags.size());
+    header.witness_states_offset = place_array<double>(offset, data.witness_states.size());
+    header.representatives_offset = place_array<int32_t>(offset, data.representatives.size());
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("Can not write tree file " + filename);
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_array(stream, header.states_offset, data.states);
+    write_array(stream, header.controls_offset, data.controls);
+    write_array(stream, header.durations_offset, data.durations);
+    write_array(stream, header.costs_offset, data.costs);
+    write_array(stream, header.parents_offset, data.parents);
+    write_array(stream, header.node_witnesses_offset, data.node_witnesses);
+    write_array(stream, header.flags_offset, data.flags);
+    write_array(stream, header.witness_states_offset, data.witness_states);
+    write_array(stream, header.representatives_offset, data.representatives);
+    if (!stream) {
+        throw std::runtime_error("Can not write tree file " + filename);
+    }
+}
+
+void tree_file_t::check_tree(unsigned int state_dimension, unsigned int control_dimension) const
+{
+    if (get_state_dimension() != state_dimension || get_control_dimension() != control_dimension) {
+        throw std::runtime_error("Tree file dimensions do not match the planner");
+    }
+    int nodes = get_number_of_nodes();
+    int witnesses = get_number_of_witnesses();
+    if (nodes == 0 || get_parents()[0] != -1) {
+        throw std::runtime_error("Tree file has no root");
+    }
+    for (int i = 0; i < nodes; i++) {
+        if (get_parents()[i] < -1 || get_parents()[i] >= i ||
+            get_node_witnesses()[i] < -1 || get_node_witnesses()[i] >= witnesses) {
+            throw std::runtime_error("Tree file is truncated or corrupted");
+        }
+    }
+    for (int i = 0; i < witnesses; i++) {
+        if (get_representatives()[i] < -1 || get_representatives()[i] >= nodes) {
+            throw std::runtime_error("Tree file is truncated or corrupted");
+        }
+    }
+}
+
+int tree_file_t::find_cheapest_near(const double* state, double radius,
+                                    const std::function<double(const double*, const double*, unsigned int)>& distance) const
+{
+    const double* states = get_states();
+    const double* costs = get_costs();
+    int cheapest = -1;
+    for (unsigned int i = 0; i < get_number_of_nodes(); i++) {
+        if ((cheapest < 0 || costs[i] < costs[cheapest]) &&
+            distance(states + (size_t)i * get_state_dimension(), state, get_state_dimension()) < radius) {
+            cheapest = i;
+        }
+    }
+    return cheapest;
+}
+
+void tree_file_t::get_branch(int node, std::vector<std::vector<double>>& solution_path,
+                             std::vector<std::vector<double>>& controls, std::vector<double>& costs) const
+{
+    if (node < 0 || (unsigned int)node >= get_number_of_nodes()) {
+        throw std::runtime_error("Node index out of range");
+    }
+    unsigned int state_dimension = get_state_dimension();
+    unsigned int control_dimension = get_control_dimension();
+    std::deque<int> branch;
+    for (int v = node; v >= 0; v = get_parents()[v]) {
+        // Parents precede their children, so a later parent means a corrupted file
+        if (get_parents()[v] >= v) {
+            throw std::runtime_error("Tree file is truncated or corrupted");
+        }
+        branch.push_front(v);
+    }
+    for (size_t i = 0; i < branch.size(); i++) {
+        const double* state = get_states() + (size_t)branch[i] * state_dimension;
+        solution_path.push_back(std::vector<double>(state, state + state_dimension));
+        if (i > 0) {
+            const double* control = get_controls() + (size_t)branch[i] * control_dimension;
+            controls.push_back(std::vector<double>(control, control + control_dimension));
+            costs.push_back(get_durations()[branch[i]]);
+        }
+    }
+}
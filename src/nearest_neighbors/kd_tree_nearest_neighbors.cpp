@@ -0,0 +1,413 @@
+/**
+ * @file kd_tree_nearest_neighbors.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <assert.h>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+#include "nearest_neighbors/kd_tree_nearest_neighbors.hpp"
+#include "motion_planners/tree_node.hpp"
+
+kd_tree_cell_t::kd_tree_cell_t()
+    : split_dimension(0)
+    , split_value(0.)
+    , left(nullptr)
+    , right(nullptr)
+{
+}
+
+kd_tree_cell_t::~kd_tree_cell_t()
+{
+    delete left;
+    delete right;
+}
+
+
+kd_tree_nearest_neighbors_t::kd_tree_nearest_neighbors_t(const std::vector<bool>& is_circular_topology)
+    : circular_topology(is_circular_topology)
+    , point_dimension(0)
+    , point_stride(0)
+    , root_cell(nullptr)
+    , number_of_points(0)
+    , number_of_removed(0)
+{
+}
+
+kd_tree_nearest_neighbors_t::~kd_tree_nearest_neighbors_t()
+{
+    delete root_cell;
+    for (auto n: slot_nodes) {
+        delete n;
+    }
+}
+
+void kd_tree_nearest_neighbors_t::set_distance(std::function<double(const double*, const double*)>, unsigned int state_dimension)
+{
+    // The distance is computed from the circular topology, the function of the planner is not used
+    assert( number_of_points == 0 );
+    assert( circular_topology.size() == state_dimension );
+    point_dimension = state_dimension;
+    point_stride = ((state_dimension + POINT_STORE_STRIDE_MULTIPLE - 1) / POINT_STORE_STRIDE_MULTIPLE) * POINT_STORE_STRIDE_MULTIPLE;
+    point_store.reserve(INIT_NODE_SIZE * point_stride);
+    cell_low.resize(state_dimension);
+    cell_high.resize(state_dimension);
+    leaf_distance = batch_distance_t(circular_topology);
+    leaf_distances.reserve(KD_TREE_BUCKET_SIZE + 1);
+}
+
+void kd_tree_nearest_neighbors_t::add_node( state_point_t* state )
+{
+    assert( point_stride > 0 );
+    unsigned int slot;
+    if( free_slots.size() > 0 )
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else
+    {
+        slot = slot_nodes.size();
+        slot_nodes.push_back(nullptr);
+        point_store.resize(point_store.size() + point_stride, 0.);
+    }
+    const double* point = state->get_point();
+    std::copy(point, point + point_dimension, &point_store[slot * point_stride]);
+
+    proximity_node_t* node = new proximity_node_t(state);
+    node->set_index(slot);
+    node->set_slot(slot);
+    state->set_proximity_node(node);
+    slot_nodes[slot] = node;
+    number_of_points++;
+
+    if( root_cell == nullptr )
+        root_cell = new kd_tree_cell_t();
+
+    kd_tree_cell_t* cell = root_cell;
+    while( !cell->is_leaf() )
+    {
+        if( point[cell->split_dimension] < cell->split_value )
+            cell = cell->left;
+        else
+            cell = cell->right;
+    }
+    cell->bucket.push_back(slot);
+
+    if( cell->bucket.size() > KD_TREE_BUCKET_SIZE )
+    {
+        // Drop the removed points before splitting the overflowing bucket
+        std::vector<unsigned int> slots;
+        slots.reserve(cell->bucket.size());
+        for( unsigned int s: cell->bucket )
+        {
+            if( slot_nodes[s] != nullptr )
+                slots.push_back(s);
+            else
+            {
+                free_slots.push_back(s);
+                number_of_removed--;
+            }
+        }
+        kd_tree_cell_t* subtree = build(slots, 0, slots.size());
+        if( subtree->is_leaf() )
+        {
+            cell->bucket.swap(subtree->bucket);
+        }
+        else
+        {
+            cell->bucket.clear();
+            cell->split_dimension = subtree->split_dimension;
+            cell->split_value = subtree->split_value;
+            cell->left = subtree->left;
+            cell->right = subtree->right;
+            subtree->left = nullptr;
+            subtree->right = nullptr;
+        }
+        delete subtree;
+    }
+}
+
+void kd_tree_nearest_neighbors_t::remove_node( state_point_t* state )
+{
+    const proximity_node_t* node = state->get_proximity_node();
+    state->set_proximity_node(nullptr);
+
+    slot_nodes[node->get_slot()] = nullptr;
+    delete node;
+    number_of_points--;
+    number_of_removed++;
+
+    if( number_of_removed > KD_TREE_BUCKET_SIZE && number_of_removed > number_of_points )
+        rebuild();
+}
+
+kd_tree_cell_t* kd_tree_nearest_neighbors_t::build( std::vector<unsigned int>& slots, unsigned int begin, unsigned int end )
+{
+    kd_tree_cell_t* cell = new kd_tree_cell_t();
+    if( end - begin > KD_TREE_BUCKET_SIZE )
+    {
+        double max_spread = 0;
+        for( unsigned int d=0; d<point_dimension; d++ )
+        {
+            double low = std::numeric_limits<double>::max();
+            double high = -std::numeric_limits<double>::max();
+            for( unsigned int i=begin; i<end; i++ )
+            {
+                double value = point_store[slots[i] * point_stride + d];
+                low = std::min(low, value);
+                high = std::max(high, value);
+            }
+            if( high - low > max_spread )
+            {
+                max_spread = high - low;
+                cell->split_dimension = d;
+            }
+        }
+
+        if( max_spread > 0 )
+        {
+            unsigned int d = cell->split_dimension;
+            unsigned int middle = (begin + end) / 2;
+            std::nth_element(slots.begin() + begin, slots.begin() + middle, slots.begin() + end,
+                [this, d](unsigned int a, unsigned int b) {
+                    return point_store[a * point_stride + d] < point_store[b * point_stride + d];
+                });
+            cell->split_value = point_store[slots[middle] * point_stride + d];
+            cell->left = build(slots, begin, middle);
+            cell->right = build(slots, middle, end);
+            return cell;
+        }
+    }
+    cell->bucket.assign(slots.begin() + begin, slots.begin() + end);
+    return cell;
+}
+
+void kd_tree_nearest_neighbors_t::rebuild()
+{
+    std::vector<unsigned int> slots;
+    slots.reserve(number_of_points);
+    free_slots.clear();
+    for( unsigned int s=0; s<slot_nodes.size(); s++ )
+    {
+        if( slot_nodes[s] != nullptr )
+            slots.push_back(s);
+        else
+            free_slots.push_back(s);
+    }
+    delete root_cell;
+    root_cell = slots.size() > 0 ? build(slots, 0, slots.size()) : nullptr;
+    number_of_removed = 0;
+}
+
+double kd_tree_nearest_neighbors_t::squared_cell_distance( const double* state ) const
+{
+    double result = 0;
+    for( unsigned int i=0; i<point_dimension; i++ )
+    {
+        double low = cell_low[i];
+        double high = cell_high[i];
+        if( state[i] >= low && state[i] <= high )
+            continue;
+        double val;
+        if( !circular_topology[i] )
+        {
+            val = state[i] < low ? low - state[i] : state[i] - high;
+        }
+        else
+        {
+            // An unbounded arc may wrap around to the query
+            if( std::isinf(low) || std::isinf(high) || high - low >= 2*M_PI )
+                continue;
+            double to_low = fabs(state[i] - low);
+            if( to_low > M_PI )
+                to_low = 2*M_PI - to_low;
+            double to_high = fabs(state[i] - high);
+            if( to_high > M_PI )
+                to_high = 2*M_PI - to_high;
+            val = std::min(to_low, to_high);
+        }
+        result += val*val;
+    }
+    return result;
+}
+
+template <class visitor_t>
+void kd_tree_nearest_neighbors_t::search( const kd_tree_cell_t* cell, const double* state, double& squared_radius, visitor_t& visitor ) const
+{
+    if( cell->is_leaf() )
+    {
+        const std::vector<unsigned int>& bucket = cell->bucket;
+        leaf_distances.resize(bucket.size());
+        leaf_distance.squared_distances(state, point_store.data(), point_stride, bucket.data(), bucket.size(), leaf_distances.data());
+        for( unsigned int i=0; i<bucket.size(); i++ )
+        {
+            if( slot_nodes[bucket[i]] == nullptr )
+                continue;
+            if( leaf_distances[i] < squared_radius )
+                visitor(bucket[i], leaf_distances[i], squared_radius);
+        }
+        return;
+    }
+
+    unsigned int d = cell->split_dimension;
+    double low = cell_low[d];
+    double high = cell_high[d];
+
+    cell_high[d] = cell->split_value;
+    double left_distance = squared_cell_distance(state);
+    cell_high[d] = high;
+    cell_low[d] = cell->split_value;
+    double right_distance = squared_cell_distance(state);
+    cell_low[d] = low;
+
+    bool left_first = left_distance <= right_distance;
+    const kd_tree_cell_t* first = left_first ? cell->left : cell->right;
+    const kd_tree_cell_t* second = left_first ? cell->right : cell->left;
+    double first_distance = left_first ? left_distance : right_distance;
+    double second_distance = left_first ? right_distance : left_distance;
+
+    if( first_distance < squared_radius )
+    {
+        if( left_first )
+            cell_high[d] = cell->split_value;
+        else
+            cell_low[d] = cell->split_value;
+        search(first, state, squared_radius, visitor);
+        cell_low[d] = low;
+        cell_high[d] = high;
+    }
+    if( second_distance < squared_radius )
+    {
+        if( left_first )
+            cell_low[d] = cell->split_value;
+        else
+            cell_high[d] = cell->split_value;
+        search(second, state, squared_radius, visitor);
+        cell_low[d] = low;
+        cell_high[d] = high;
+    }
+}
+
+proximity_node_t* kd_tree_nearest_neighbors_t::find_closest( const double* state, double* the_distance ) const
+{
+    if( number_of_points == 0 )
+        return NULL;
+
+    std::fill(cell_low.begin(), cell_low.end(), -std::numeric_limits<double>::infinity());
+    std::fill(cell_high.begin(), cell_high.end(), std::numeric_limits<double>::infinity());
+
+    int min_slot = -1;
+    double squared_radius = std::numeric_limits<double>::infinity();
+    auto visitor = [&min_slot](unsigned int slot, double distance, double& radius) {
+        min_slot = slot;
+        radius = distance;
+    };
+    search(root_cell, state, squared_radius, visitor);
+
+    assert( min_slot >= 0 );
+    *the_distance = std::sqrt(squared_radius);
+    return slot_nodes[min_slot];
+}
+
+unsigned int kd_tree_nearest_neighbors_t::find_k_close( const double* state, proximity_node_t** close_nodes, double* distances, unsigned int k )
+{
+    if( number_of_points == 0 || k == 0 )
+        return 0;
+    if( k > MAX_KK )
+        k = MAX_KK;
+
+    std::fill(cell_low.begin(), cell_low.end(), -std::numeric_limits<double>::infinity());
+    std::fill(cell_high.begin(), cell_high.end(), std::numeric_limits<double>::infinity());
+
+    unsigned int nr_points = 0;
+    double squared_radius = std::numeric_limits<double>::infinity();
+    auto visitor = [this, close_nodes, distances, k, &nr_points](unsigned int slot, double distance, double& radius) {
+        if( nr_points < k )
+        {
+            close_nodes[nr_points] = slot_nodes[slot];
+            distances[nr_points] = distance;
+            resort(close_nodes, distances, nr_points);
+            nr_points++;
+        }
+        else
+        {
+            close_nodes[k-1] = slot_nodes[slot];
+            distances[k-1] = distance;
+            resort(close_nodes, distances, k-1);
+        }
+        if( nr_points == k )
+            radius = distances[k-1];
+    };
+    search(root_cell, state, squared_radius, visitor);
+
+    for( unsigned int i=0; i<nr_points; i++ )
+        distances[i] = std::sqrt(distances[i]);
+    return nr_points;
+}
+
+unsigned int kd_tree_nearest_neighbors_t::find_delta_close_and_closest( const double* state, proximity_node_t** close_nodes, double* distances, double delta )
+{
+    double min_distance;
+    proximity_node_t* closest = find_closest(state, &min_distance);
+    if( closest == NULL )
+        return 0;
+
+    unsigned int nr_points = 0;
+    close_nodes[0] = closest;
+    distances[0] = min_distance;
+    nr_points++;
+    if( min_distance < delta )
+    {
+        std::fill(cell_low.begin(), cell_low.end(), -std::numeric_limits<double>::infinity());
+        std::fill(cell_high.begin(), cell_high.end(), std::numeric_limits<double>::infinity());
+
+        double squared_radius = delta*delta;
+        auto visitor = [this, closest, close_nodes, distances, &nr_points](unsigned int slot, double distance, double&) {
+            if( slot_nodes[slot] != closest && nr_points < MAX_KK )
+            {
+                close_nodes[nr_points] = slot_nodes[slot];
+                distances[nr_points] = std::sqrt(distance);
+                nr_points++;
+            }
+        };
+        search(root_cell, state, squared_radius, visitor);
+    }
+    return nr_points;
+}
+
+unsigned int kd_tree_nearest_neighbors_t::find_delta_close( const double* state, proximity_node_t** close_nodes, double* distances, double delta )
+{
+    if( number_of_points == 0 )
+        return 0;
+
+    std::fill(cell_low.begin(), cell_low.end(), -std::numeric_limits<double>::infinity());
+    std::fill(cell_high.begin(), cell_high.end(), std::numeric_limits<double>::infinity());
+
+    unsigned int nr_points = 0;
+    double squared_radius = delta*delta;
+    auto visitor = [this, close_nodes, distances, &nr_points](unsigned int slot, double distance, double&) {
+        if( nr_points < MAX_KK )
+        {
+            close_nodes[nr_points] = slot_nodes[slot];
+            distances[nr_points] = std::sqrt(distance);
+            nr_points++;
+        }
+    };
+    search(root_cell, state, squared_radius, visitor);
+
+    if( nr_points > 0 )
+        sort(close_nodes, distances, 0, nr_points-1);
+    return nr_points;
+}
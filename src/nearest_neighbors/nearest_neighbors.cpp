@@ -0,0 +1,144 @@
+/**
+ * @file nearest_neighbors.cpp
+ * 
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ * 
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ * 
+ */
+
+#include <assert.h>
+
+#include "nearest_neighbors/nearest_neighbors.hpp"
+
+proximity_node_t::proximity_node_t( const state_point_t* st )
+    : state(st)
+{
+}
+
+
+const state_point_t* proximity_node_t::get_state( ) const
+{
+    return state;
+}
+
+int proximity_node_t::get_index() const
+{
+    return index;
+}
+
+void proximity_node_t::set_index( int indx )
+{
+    index = indx;
+}
+
+unsigned int proximity_node_t::get_slot() const
+{
+    return slot;
+}
+
+void proximity_node_t::set_slot( unsigned int new_slot )
+{
+    slot = new_slot;
+}
+
+const std::vector<unsigned int>& proximity_node_t::get_neighbors() const
+{
+    return neighbors;
+}
+
+void proximity_node_t::add_neighbor( unsigned int nd )
+{
+    neighbors.push_back(nd);
+}
+
+void proximity_node_t::delete_neighbor( unsigned int nd )
+{
+    unsigned int index;
+    for( index=0; index<neighbors.size(); index++ )
+    {
+        if( neighbors[index] == nd )
+            break;
+    }
+    assert( index < neighbors.size() );
+
+    for( unsigned int i=index; i<neighbors.size()-1; i++ ) {
+        neighbors[i] = neighbors[i+1];
+    }
+	neighbors.pop_back();
+}
+
+void proximity_node_t::replace_neighbor( unsigned prev, int new_index )
+{
+    unsigned int index;
+    for( index=0; index<neighbors.size(); index++ )
+    {
+        if( neighbors[index] == prev )
+            break;
+    }
+    assert( index < neighbors.size() );
+
+    neighbors[index] = new_index;
+}
+
+
+////////////////////////////////////////
+////// SORTING
+///////////////////////////////////////
+
+void sort( proximity_node_t** close_nodes, double* distances, int low, int high )
+{ 
+    if( low < high )
+    {
+        int left, right;
+        double pivot_distance = distances[low];
+        proximity_node_t* pivot_node = close_nodes[low];
+        left = low;
+        right = high;
+        while( left < right )
+        {
+            while( left <= high && distances[left] <= pivot_distance )
+            left++;
+            while( distances[right] > pivot_distance )
+            right--;
+            if( left < right )
+            {
+            double temp = distances[left];
+            distances[left] = distances[right];
+            distances[right] = temp;
+
+            proximity_node_t* temp_node = close_nodes[left];
+            close_nodes[left] = close_nodes[right];
+            close_nodes[right] = temp_node;
+            }
+        }
+        distances[low] = distances[right];
+        distances[right] = pivot_distance;
+
+        close_nodes[low] = close_nodes[right];
+        close_nodes[right] = pivot_node;
+
+        sort( close_nodes, distances, low, right-1 );
+        sort( close_nodes, distances, right+1, high );
+    }
+}
+
+unsigned int resort( proximity_node_t** close_nodes, double* distances, unsigned int index )
+{
+    while( index > 0 && distances[ index ] < distances[ index-1 ] )
+    {
+        double temp = distances[index];
+        distances[index] = distances[index-1];
+        distances[index-1] = temp;
+        proximity_node_t* temp_node = close_nodes[index];
+        close_nodes[index] = close_nodes[index-1];
+        close_nodes[index-1] = temp_node;
+        index--;
+    }
+    return index;
+}
@@ -31,6 +31,10 @@
 #include "motion_planners/sst.hpp"
 #include "motion_planners/rrt.hpp"
 #include "motion_planners/sst_backend.hpp"
+#include "motion_planners/bidirectional_sst.hpp"
+#include "motion_planners/planner_portfolio.hpp"
+#include "nearest_neighbors/graph_nearest_neighbors.hpp"
+#include "nearest_neighbors/kd_tree_nearest_neighbors.hpp"
 
 #include "image_creation/planner_visualization.hpp"
 #include "systems/distance_functions.h"
@@ -100,10 +104,160 @@ euclidean_distance create_euclidean_distance(
     return euclidean_distance(is_circular_topology_v);
 }
 
+/**
+ * @brief Create a factory of the nearest neighbor structure selected by name
+ * @details Create a factory of the nearest neighbor structure selected by name
+ *
+ * @param nearest_neighbors Name of the structure ("graph" or "kd_tree")
+ * @param distance_computer Distance used by the planner, "kd_tree" requires euclidean_distance.
+ * The graph is specialized for the distances implemented in C++.
+ *
+ * @return factory to pass to the planner constructor
+ */
+nearest_neighbors_factory_t create_nearest_neighbors_factory(
+    const std::string& nearest_neighbors,
+    const distance_t* distance_computer)
+{
+    if (nearest_neighbors == "graph") {
+        // Distances implemented in C++ are inlined into the graph queries,
+        // other distances (e.g. defined in Python) go through the type-erased planner distance
+        if (const euclidean_distance* euclidean = dynamic_cast<const euclidean_distance*>(distance_computer)) {
+            // The topologies of the point, car and cart-pole systems get a fixed dimension,
+            // other euclidean distances loop over their dimensions at runtime
+            const std::vector<bool> topology = euclidean->is_circular_topology();
+            if (topology == std::vector<bool>{false, false}) {
+                return specialized_graph_nearest_neighbors_factory(fixed_euclidean_distance_t<2>());
+            }
+            if (topology == std::vector<bool>{false, false, true}) {
+                return specialized_graph_nearest_neighbors_factory(fixed_euclidean_distance_t<3, 0x4>());
+            }
+            if (topology == std::vector<bool>{false, false, true, false}) {
+                return specialized_graph_nearest_neighbors_factory(fixed_euclidean_distance_t<4, 0x4>());
+            }
+            return specialized_graph_nearest_neighbors_factory(
+                concrete_distance_t<euclidean_distance>(*euclidean, topology.size()));
+        }
+        if (dynamic_cast<const two_link_acrobot_distance*>(distance_computer)) {
+            return specialized_graph_nearest_neighbors_factory(system_distance_t<two_link_acrobot_t, 4>());
+        }
+        if (dynamic_cast<const quadrotor_distance*>(distance_computer)) {
+            return specialized_graph_nearest_neighbors_factory(system_distance_t<quadrotor_t, 13>());
+        }
+        return nearest_neighbors_factory_t();
+    }
+    if (nearest_neighbors == "kd_tree") {
+        const euclidean_distance* euclidean = dynamic_cast<const euclidean_distance*>(distance_computer);
+        if (euclidean == nullptr) {
+            throw std::domain_error("kd_tree nearest neighbors require euclidean distance");
+        }
+        std::vector<bool> is_circular_topology = euclidean->is_circular_topology();
+        return [is_circular_topology]() -> nearest_neighbors_t* {
+            return new kd_tree_nearest_neighbors_t(is_circular_topology);
+        };
+    }
+    throw std::domain_error("Unknown nearest neighbors structure: " + nearest_neighbors);
+}
+
+/**
+ * @brief Select the integrator of a system by name
+ * @details Select the integrator of a system by name
+ *
+ * @param system The system
+ * @param integrator Name of the integrator ("euler", "semi_implicit_euler", "rk4" or "rk45")
+ * @param tolerance The error allowed in every substep of "rk45"
+ */
+void set_system_integrator(integrated_system_t& system, const std::string& integrator, double tolerance)
+{
+    unsigned int state_dimension = system.get_state_dimension();
+    if (integrator == "euler") {
+        // the built-in explicit Euler is faster than the generic one
+        system.set_integrator(nullptr);
+    } else if (integrator == "semi_implicit_euler") {
+        system.set_integrator(new semi_implicit_euler_integrator_t(system.is_velocity()));
+    } else if (integrator == "rk4") {
+        system.set_integrator(new rk4_integrator_t(state_dimension));
+    } else if (integrator == "rk45") {
+        if (tolerance <= 0) {
+            throw std::domain_error("The tolerance of rk45 has to be positive");
+        }
+        system.set_integrator(new rk45_integrator_t(state_dimension, tolerance));
+    } else {
+        throw std::domain_error("Unknown integrator: " + integrator);
+    }
+}
+
+/**
+ * @brief Checks if a state of a system is valid
+ * @details Checks if a state of a system is in collision or out of bounds, see system_t::valid_state()
+ *
+ * @param system The system
+ * @param state_array The state to check
+ * @return True if the state is valid
+ */
+bool system_valid_state(system_t& system, const py::safe_array<double>& state_array)
+{
+    if (state_array.shape()[0] != system.get_state_dimension()) {
+        throw std::domain_error("State has to have the state dimension of the system");
+    }
+    auto state = state_array.unchecked<1>();
+    return system.valid_state(&state(0));
+}
+
+
+/**
+ * @brief Checks if a system is implemented in python
+ * @details Checks if a system is a py_system_interface trampoline that needs the GIL to be propagated
+ *
+ * @param system The system to check
+ * @return True for python systems
+ */
+bool is_python_system(const system_interface& system);
+
+
+/**
+ * @brief Converts a trajectory to python
+ * @details Converts a trajectory in the format of planner_t::get_solution() to a tuple of numpy arrays
+ *
+ * @return (states, controls, durations) or None if the trajectory has no edges
+ */
+py::object trajectory_to_python(const std::vector<std::vector<double>>& solution_path,
+                                const std::vector<std::vector<double>>& controls,
+                                const std::vector<double>& costs)
+{
+    if (controls.size() == 0) {
+        return py::none();
+    }
+
+    py::safe_array<double> controls_array({controls.size(), controls[0].size()});
+    py::safe_array<double> costs_array({costs.size()});
+    auto controls_ref = controls_array.mutable_unchecked<2>();
+    auto costs_ref = costs_array.mutable_unchecked<1>();
+    for (unsigned int i = 0; i < controls.size(); ++i) {
+        for (unsigned int j = 0; j < controls[0].size(); ++j) {
+            controls_ref(i, j) = controls[i][j];
+        }
+        costs_ref(i) = costs[i];
+    }
+
+    py::safe_array<double> state_array({solution_path.size(), solution_path[0].size()});
+    auto state_ref = state_array.mutable_unchecked<2>();
+    for (unsigned int i = 0; i < solution_path.size(); ++i) {
+        for (unsigned int j = 0; j < solution_path[0].size(); ++j) {
+            state_ref(i, j) = solution_path[i][j];
+        }
+    }
+    return py::cast(std::tuple<py::safe_array<double>, py::safe_array<double>, py::safe_array<double>>
+        (state_array, controls_array, costs_array));
+}
+
 
 /**
  * @brief Python wrapper for planner_t class
- * @details Python wrapper for planner_t class that handles numpy arguments and passes them to cpp functions
+ * @details Python wrapper for planner_t class that handles numpy arguments and passes them to cpp functions.
+ * Planning entry points release the GIL when neither the system nor the distance is implemented in python,
+ * so that planners driven from different python threads run in parallel.
+ * A single planner must not be stepped from several threads at once, and planners stepped at the same time
+ * must not share a system, since systems keep scratch state for their propagations.
  *
  */
 class PlannerWrapper
@@ -114,7 +268,51 @@ public:
 	 * @copydoc planner_t::step()
 	 */
     void step(system_interface& system, int min_time_steps, int max_time_steps, double integration_step) {
-        planner->step(&system, min_time_steps, max_time_steps, integration_step);
+        check_system(system);
+        if (releases_gil(system)) {
+            py::gil_scoped_release release;
+            planner->step(&system, min_time_steps, max_time_steps, integration_step);
+        } else {
+            planner->step(&system, min_time_steps, max_time_steps, integration_step);
+        }
+    }
+
+    /**
+	 * @copydoc planner_t::step_n()
+	 */
+    void step_n(system_interface& system, unsigned int number_of_iterations, int min_time_steps, int max_time_steps, double integration_step) {
+        check_system(system);
+        if (releases_gil(system)) {
+            py::gil_scoped_release release;
+            planner->step_n(&system, number_of_iterations, min_time_steps, max_time_steps, integration_step);
+        } else {
+            planner->step_n(&system, number_of_iterations, min_time_steps, max_time_steps, integration_step);
+        }
+    }
+
+    /**
+	 * @copydoc planner_t::run_until()
+	 */
+    unsigned int run_until(system_interface& system, int min_time_steps, int max_time_steps, double integration_step,
+                           double time_budget, unsigned int node_budget, bool solution_found) {
+        if (time_budget == std::numeric_limits<double>::infinity() && node_budget == 0 && !solution_found) {
+            throw std::domain_error("run_until requires a time budget, a node budget or solution_found");
+        }
+        check_system(system);
+        if (releases_gil(system)) {
+            py::gil_scoped_release release;
+            return planner->run_until(&system, min_time_steps, max_time_steps, integration_step,
+                                      time_budget, node_budget, solution_found);
+        }
+        return planner->run_until(&system, min_time_steps, max_time_steps, integration_step,
+                                  time_budget, node_budget, solution_found);
+    }
+
+    /**
+	 * @copydoc planner_t::has_solution()
+	 */
+    bool has_solution() {
+        return planner->has_solution();
     }
 
     /**
@@ -196,31 +394,21 @@ public:
         std::vector<std::vector<double>> controls;
         std::vector<double> costs;
         planner->get_solution(solution_path, controls, costs);
+        return trajectory_to_python(solution_path, controls, costs);
+    }
 
-        if (controls.size() == 0) {
-            return py::none();
-        }
-
-        py::safe_array<double> controls_array({controls.size(), controls[0].size()});
-        py::safe_array<double> costs_array({costs.size()});
-        auto controls_ref = controls_array.mutable_unchecked<2>();
-        auto costs_ref = costs_array.mutable_unchecked<1>();
-        for (unsigned int i = 0; i < controls.size(); ++i) {
-            for (unsigned int j = 0; j < controls[0].size(); ++j) {
-                controls_ref(i, j) = controls[i][j];
-            }
-            costs_ref(i) = costs[i];
-        }
+    /**
+	 * @copydoc planner_t::save_tree()
+	 */
+    void save_tree(const std::string& filename) {
+        planner->save_tree(filename);
+    }
 
-        py::safe_array<double> state_array({solution_path.size(), solution_path[0].size()});
-        auto state_ref = state_array.mutable_unchecked<2>();
-        for (unsigned int i = 0; i < solution_path.size(); ++i) {
-            for (unsigned int j = 0; j < solution_path[0].size(); ++j) {
-                state_ref(i, j) = solution_path[i][j];
-            }
-        }
-        return py::cast(std::tuple<py::safe_array<double>, py::safe_array<double>, py::safe_array<double>>
-            (state_array, controls_array, costs_array));
+    /**
+	 * @copydoc planner_t::load_tree()
+	 */
+    void load_tree(const std::string& filename) {
+        planner->load_tree(filename);
     }
 
     /**
@@ -230,17 +418,171 @@ public:
         return this->planner->get_number_of_nodes();
     }
 
+    /**
+	 * @copydoc planner_t::get_best_cost()
+	 */
+    double get_best_cost() {
+        return this->planner->get_best_cost();
+    }
+
+    /**
+     * @brief Configure the state sampling of the planner
+     * @details Configure the state sampling of the planner, see planner_t::set_sampling()
+     *
+     * @param goal_bias The probability of sampling the goal state
+     * @param cost_per_distance Lower bound of the cost of moving a unit of distance, 0 disables informed sampling
+     * @param sampler Optional python callable that receives the best cost and returns a state, e.g. a learned sampler
+     */
+    void set_sampling(double goal_bias, double cost_per_distance, py::object sampler) {
+        sampler_t* base_sampler = nullptr;
+        python_sampler = !sampler.is_none();
+        if (python_sampler) {
+            unsigned int state_dimension = planner->get_state_dimension();
+            base_sampler = new function_sampler_t([sampler, state_dimension](double best_cost, double* state) {
+                py::gil_scoped_acquire acquire;
+                py::safe_array<double> sample = sampler(best_cost);
+                if (sample.size() != state_dimension) {
+                    throw std::domain_error("The sampler returned a state of a wrong dimension");
+                }
+                auto sample_ref = sample.unchecked<1>();
+                for (unsigned int i = 0; i < state_dimension; ++i) {
+                    state[i] = sample_ref(i);
+                }
+            });
+        }
+        planner->set_sampling(goal_bias, cost_per_distance, base_sampler);
+    }
+
     py::object nearest_vertex(const py::safe_array<double> &sample_state_array){};
 
+    friend py::object run_portfolio(const std::vector<PlannerWrapper*>& planners, const std::vector<system_interface*>& systems,
+                                    int min_time_steps, int max_time_steps, double integration_step,
+                                    double time_budget, bool solution_found, bool share_cost_bound);
+
 protected:
+    PlannerWrapper()
+        : native_distance(false)
+        , python_sampler(false)
+        , reversible_system(false)
+    {
+    }
+
+    /**
+     * @brief Checks if the planner can plan for the given system
+     * @param system The system to plan for
+     */
+    void check_system(const system_interface& system) const {
+        if (reversible_system && dynamic_cast<const reversible_system_interface*>(&system) == nullptr) {
+            throw std::domain_error("The planner requires a system that can be propagated backward (point, car or pendulum)");
+        }
+    }
+
+    /**
+     * @brief Checks if planning with the given system can run without the GIL
+     * @param system The system to plan for
+     * @return True if neither the system, the distance nor the sampler calls into python
+     */
+    bool releases_gil(const system_interface& system) const {
+        return native_distance && !python_sampler && !is_python_system(system);
+    }
+
 	/**
 	 * @brief Created planner object
 	 */
     std::unique_ptr<planner_t> planner;
+
+	/**
+	 * @brief Whether the distance of the planner is implemented in C++
+	 */
+    bool native_distance;
+
+	/**
+	 * @brief Whether the states are sampled by a python callable
+	 */
+    bool python_sampler;
+
+	/**
+	 * @brief Whether the planner requires a system that implements reversible_system_interface
+	 */
+    bool reversible_system;
 };
 
 
 
+/**
+ * @brief Python wrapper for tree_file_t
+ * @details Python wrapper for tree_file_t. The arrays are read-only numpy views of the mapped file
+ * that keep the file mapped while they are alive.
+ *
+ */
+class __attribute__ ((visibility ("hidden"))) TreeFileWrapper{
+public:
+
+	/**
+	 * @copydoc tree_file_t::tree_file_t()
+	 */
+    TreeFileWrapper(const std::string& filename)
+        : file(new tree_file_t(filename))
+    {
+    }
+
+	/**
+	 * @brief Creates a read-only numpy view of an array of the file
+	 * @param self The python object of the wrapper, kept alive by the view
+	 * @param data The array of the file
+	 * @param rows Number of rows of the array
+	 * @param columns Number of columns of the array, 0 for a one-dimensional array
+	 * @return numpy view of the array
+	 */
+    template <class value_t>
+    static py::array view(py::object self, const value_t* data, size_t rows, size_t columns) {
+        std::vector<size_t> shape(1, rows);
+        std::vector<size_t> strides(1, columns > 0 ? columns * sizeof(value_t) : sizeof(value_t));
+        if (columns > 0) {
+            shape.push_back(columns);
+            strides.push_back(sizeof(value_t));
+        }
+        py::array_t<value_t> array(shape, strides, data, self);
+        array.attr("setflags")("write"_a=false);
+        return array;
+    }
+
+	/**
+	 * @copydoc tree_file_t::find_cheapest_near()
+	 */
+    py::object find_cheapest_near(const py::safe_array<double>& state_array, double radius, py::object distance_computer_py) {
+        if (state_array.shape()[0] != file->get_state_dimension()) {
+            throw std::domain_error("State has to have the state dimension of the tree");
+        }
+        distance_t* distance_computer = distance_computer_py.cast<distance_t*>();
+        auto state = state_array.unchecked<1>();
+        int node = file->find_cheapest_near(&state(0), radius,
+            [distance_computer] (const double* p0, const double* p1, unsigned int dims) {
+                return distance_computer->distance(p0, p1, dims);
+            });
+        if (node < 0) {
+            return py::none();
+        }
+        return py::cast(node);
+    }
+
+	/**
+	 * @copydoc tree_file_t::get_branch()
+	 */
+    py::object get_branch(int node) {
+        std::vector<std::vector<double>> solution_path;
+        std::vector<std::vector<double>> controls;
+        std::vector<double> costs;
+        file->get_branch(node, solution_path, controls, costs);
+        return trajectory_to_python(solution_path, controls, costs);
+    }
+
+	/**
+	 * @brief The mapped file
+	 */
+    std::unique_ptr<tree_file_t> file;
+};
+
 /**
  * @brief Python wrapper for SST planner
  * @details Python wrapper for SST planner that handles numpy arguments and passes them to cpp functions
@@ -262,6 +604,7 @@ public:
 	 * @param random_seed The seed for the random generator
 	 * @param sst_delta_near Near distance threshold for SST
 	 * @param sst_delta_drain Drain distance threshold for SST
+	 * @param nearest_neighbors Name of the nearest neighbor structure ("graph" or "kd_tree")
 	 */
     SSTWrapper(
             const py::safe_array<double> &state_bounds_array,
@@ -272,7 +615,8 @@ public:
             double goal_radius,
             unsigned int random_seed,
             double sst_delta_near,
-            double sst_delta_drain
+            double sst_delta_drain,
+            const std::string& nearest_neighbors
     )
         : _distance_computer_py(distance_computer_py)  // capture distance computer to avoid segfaults because we use a raw pointer from it
     {
@@ -285,6 +629,7 @@ public:
         }
 
         distance_t* distance_computer = distance_computer_py.cast<distance_t*>();
+        native_distance = dynamic_cast<py_distance_interface*>(distance_computer) == nullptr;
 
         auto state_bounds = state_bounds_array.unchecked<2>();
         auto control_bounds = control_bounds_array.unchecked<2>();
@@ -314,9 +659,167 @@ public:
                         state_bounds_v, control_bounds_v,
                         distance_f,
                         random_seed,
-                        sst_delta_near, sst_delta_drain)
+                        sst_delta_near, sst_delta_drain,
+                        create_nearest_neighbors_factory(nearest_neighbors, distance_computer))
         );
+        // Distances defined in python are not known to satisfy the triangle inequality
+        static_cast<sst_t*>(planner.get())->set_metric_distance(native_distance);
+    }
+
+	/**
+	 * @copydoc sst_t::set_goal()
+	 */
+    void set_goal(const py::safe_array<double> &goal_state_array, double goal_radius) {
+        if (goal_state_array.shape()[0] != planner->get_state_dimension()) {
+            throw std::domain_error("State bounds and goal state arrays have to be equal size");
+        }
+        auto goal_state = goal_state_array.unchecked<1>();
+        static_cast<sst_t*>(planner.get())->set_goal(&goal_state(0), goal_radius);
     }
+
+	/**
+	 * @copydoc sst_t::add_start()
+	 */
+    void add_start(const py::safe_array<double> &start_state_array) {
+        if (start_state_array.shape()[0] != planner->get_state_dimension()) {
+            throw std::domain_error("State bounds and start state arrays have to be equal size");
+        }
+        auto start_state = start_state_array.unchecked<1>();
+        static_cast<sst_t*>(planner.get())->add_start(&start_state(0));
+    }
+
+	/**
+	 * @copydoc sst_t::set_retain_tree()
+	 */
+    void set_retain_tree(bool value) {
+        static_cast<sst_t*>(planner.get())->set_retain_tree(value);
+    }
+
+	/**
+	 * @copydoc sst_t::prune()
+	 */
+    void prune() {
+        static_cast<sst_t*>(planner.get())->prune();
+    }
+
+	/**
+	 * The GIL is released while planning, so the systems and the distance have to be implemented in C++.
+	 * @copydoc sst_t::step_parallel()
+	 */
+    void step_parallel(const std::vector<system_interface*>& systems, int min_time_steps, int max_time_steps,
+                       double integration_step, unsigned int batch_size) {
+        if (systems.empty()) {
+            throw std::domain_error("step_parallel requires at least one system");
+        }
+        for (unsigned int i = 0; i < systems.size(); i++) {
+            if (!releases_gil(*systems[i])) {
+                throw std::domain_error("step_parallel requires systems and distances implemented in C++");
+            }
+            for (unsigned int j = 0; j < i; j++) {
+                if (systems[j] == systems[i]) {
+                    throw std::domain_error("step_parallel requires distinct systems");
+                }
+            }
+        }
+        py::gil_scoped_release release;
+        static_cast<sst_t*>(planner.get())->step_parallel(systems, min_time_steps, max_time_steps,
+                                                          integration_step, batch_size);
+    }
+
+private:
+
+	/**
+	 * @brief Captured distance computer python object to prevent its premature death
+	 */
+    py::object  _distance_computer_py;
+};
+
+/**
+ * @brief Python wrapper for bidirectional SST planner
+ * @details Python wrapper for bidirectional SST planner that handles numpy arguments and passes them to cpp functions
+ *
+ */
+class __attribute__ ((visibility ("hidden"))) BidirectionalSSTWrapper : public PlannerWrapper{
+public:
+
+	/**
+	 * @brief Python wrapper of bidirectional SST planner Constructor
+	 * @details Python wrapper of bidirectional SST planner Constructor
+	 *
+	 * @param state_bounds_array numpy array (N x 2) with boundaries of the state space (min and max)
+	 * @param control_bounds_array numpy array (N x 2) with boundaries of the control space (min and max)
+	 * @param distance_computer_py Python wrapper of distance_t implementation
+	 * @param start_state_array The start state (numpy array)
+	 * @param goal_state_array The goal state  (numpy array)
+	 * @param goal_radius The radial size of the goal region centered at in_goal.
+	 * @param random_seed The seed for the random generator
+	 * @param sst_delta_near Near distance threshold for SST
+	 * @param sst_delta_drain Drain distance threshold for SST
+	 * @param connection_radius Distance between nodes of the two trees that triggers a connection attempt
+	 * @param nearest_neighbors Name of the nearest neighbor structure ("graph" or "kd_tree")
+	 */
+    BidirectionalSSTWrapper(
+            const py::safe_array<double> &state_bounds_array,
+            const py::safe_array<double> &control_bounds_array,
+            py::object distance_computer_py,
+            const py::safe_array<double> &start_state_array,
+            const py::safe_array<double> &goal_state_array,
+            double goal_radius,
+            unsigned int random_seed,
+            double sst_delta_near,
+            double sst_delta_drain,
+            double connection_radius,
+            const std::string& nearest_neighbors
+    )
+        : _distance_computer_py(distance_computer_py)  // capture distance computer to avoid segfaults because we use a raw pointer from it
+    {
+        if (state_bounds_array.shape()[0] != start_state_array.shape()[0]) {
+            throw std::domain_error("State bounds and start state arrays have to be equal size");
+        }
+
+        if (state_bounds_array.shape()[0] != goal_state_array.shape()[0]) {
+            throw std::domain_error("State bounds and goal state arrays have to be equal size");
+        }
+
+        distance_t* distance_computer = distance_computer_py.cast<distance_t*>();
+        native_distance = dynamic_cast<py_distance_interface*>(distance_computer) == nullptr;
+        reversible_system = true;
+
+        auto state_bounds = state_bounds_array.unchecked<2>();
+        auto control_bounds = control_bounds_array.unchecked<2>();
+        auto start_state = start_state_array.unchecked<1>();
+        auto goal_state = goal_state_array.unchecked<1>();
+
+        typedef std::pair<double, double> bounds_t;
+        std::vector<bounds_t> state_bounds_v;
+
+        for (unsigned int i = 0; i < state_bounds_array.shape()[0]; i++) {
+            state_bounds_v.push_back(bounds_t(state_bounds(i, 0), state_bounds(i, 1)));
+        }
+
+        std::vector<bounds_t> control_bounds_v;
+        for (unsigned int i = 0; i < control_bounds_array.shape()[0]; i++) {
+            control_bounds_v.push_back(bounds_t(control_bounds(i, 0), control_bounds(i, 1)));
+        }
+
+        std::function<double(const double*, const double*, unsigned int)>  distance_f =
+            [distance_computer] (const double* p0, const double* p1, unsigned int dims) {
+                return distance_computer->distance(p0, p1, dims);
+            };
+
+        planner.reset(
+                new bidirectional_sst_t(
+                        &start_state(0), &goal_state(0), goal_radius,
+                        state_bounds_v, control_bounds_v,
+                        distance_f,
+                        random_seed,
+                        sst_delta_near, sst_delta_drain,
+                        connection_radius,
+                        create_nearest_neighbors_factory(nearest_neighbors, distance_computer))
+        );
+        static_cast<sst_t*>(planner.get())->set_metric_distance(native_distance);
+    }
+
 private:
 
 	/**
@@ -342,6 +845,7 @@ public:
 	 * @param random_seed The seed for the random generator
 	 * @param sst_delta_near Near distance threshold for SST
 	 * @param sst_delta_drain Drain distance threshold for SST
+	 * @param nearest_neighbors Name of the nearest neighbor structure ("graph" or "kd_tree")
 	 */
     SSTBackendWrapper(
             const py::safe_array<double> &state_bounds_array,
@@ -352,7 +856,8 @@ public:
             double goal_radius,
             unsigned int random_seed,
             double sst_delta_near,
-            double sst_delta_drain
+            double sst_delta_drain,
+            const std::string& nearest_neighbors
     )
         : _distance_computer_py(distance_computer_py)  // capture distance computer to avoid segfaults because we use a raw pointer from it
     {
@@ -394,8 +899,10 @@ public:
                     state_bounds_v, control_bounds_v,
                     distance_f,
                     random_seed,
-                    sst_delta_near, sst_delta_drain)
+                    sst_delta_near, sst_delta_drain,
+                    create_nearest_neighbors_factory(nearest_neighbors, distance_computer))
         );
+        planner->set_metric_distance(dynamic_cast<py_distance_interface*>(distance_computer) == nullptr);
     }
 
     /**
@@ -448,6 +955,7 @@ public:
 	 * @param goal_state_array The goal state  (numpy array)
 	 * @param goal_radius The radial size of the goal region centered at in_goal.
 	 * @param random_seed The seed for the random generator
+	 * @param nearest_neighbors Name of the nearest neighbor structure ("graph" or "kd_tree")
 	 */
     RRTWrapper(
             const py::safe_array<double> &state_bounds_array,
@@ -456,7 +964,8 @@ public:
             const py::safe_array<double> &start_state_array,
             const py::safe_array<double> &goal_state_array,
             double goal_radius,
-            unsigned int random_seed
+            unsigned int random_seed,
+            const std::string& nearest_neighbors
     ) : _distance_computer_py(distance_computer_py)
     {
         if (state_bounds_array.shape()[0] != start_state_array.shape()[0]) {
@@ -484,6 +993,7 @@ public:
         }
 
         distance_t* distance_computer = distance_computer_py.cast<distance_t*>();
+        native_distance = dynamic_cast<py_distance_interface*>(distance_computer) == nullptr;
         std::function<double(const double*, const double*, unsigned int)>  distance_f =
             [distance_computer] (const double* p0, const double* p1, unsigned int dims) {
                 return distance_computer->distance(p0, p1, dims);
@@ -494,7 +1004,8 @@ public:
                         &start_state(0), &goal_state(0), goal_radius,
                         state_bounds_v, control_bounds_v,
                         distance_f,
-                        random_seed)
+                        random_seed,
+                        create_nearest_neighbors_factory(nearest_neighbors, distance_computer))
         );
     }
 private:
@@ -579,6 +1090,10 @@ public:
     }
 };
 
+bool is_python_system(const system_interface& system) {
+    return dynamic_cast<const py_system_interface*>(&system) != nullptr;
+}
+
 /**
  * @brief CartPole with Obstacle system Wrapper
  * @details python interface using C++ implementation
@@ -638,14 +1153,13 @@ public:
                                     num_steps, result_state, integration_step);
     }
 
-    void enforce_bounds()
+    void enforce_bounds(double* state) const override
     {
-    //    system_obs->enforce_bounds();
     }
 
-    bool valid_state()
+    bool valid_state(const double* state) const override
     {
-    //    return system_obs->valid_state();
+        return system_obs->valid_state(state);
     }
 
     std::tuple<double, double> visualize_point(const double* state, unsigned int state_dimension) const override
@@ -678,6 +1192,61 @@ public:
  * @details pybind module for all planners, systems and interfaces
  *
  */
+/**
+ * @brief Runs planners for the same query in parallel threads
+ * @details Runs planners for the same query in parallel threads and returns the planner with the best solution,
+ * see planner_portfolio_t. The GIL is released while planning, so the planners, systems and distances
+ * have to be implemented in C++.
+ *
+ * @param planners The planners, usually created with different random seeds
+ * @param systems One distinct system instance per planner
+ * @param min_time_steps Minimum number of control steps for the system
+ * @param max_time_steps Maximum number of control steps for the system
+ * @param integration_step Integration step in seconds to integrate the system
+ * @param time_budget Planning time in seconds, infinity for no limit
+ * @param solution_found Whether to cancel all planners as soon as one finds a solution
+ * @param share_cost_bound Whether the planners prune with the best cost found by any planner
+ *
+ * @return index of the planner with the best solution, None if no solution was found
+ */
+py::object run_portfolio(const std::vector<PlannerWrapper*>& planners, const std::vector<system_interface*>& systems,
+                         int min_time_steps, int max_time_steps, double integration_step,
+                         double time_budget, bool solution_found, bool share_cost_bound)
+{
+    if (planners.empty() || planners.size() != systems.size()) {
+        throw std::domain_error("run_portfolio requires one system per planner");
+    }
+    if (time_budget == std::numeric_limits<double>::infinity() && !solution_found) {
+        throw std::domain_error("run_portfolio requires a time budget or solution_found");
+    }
+    std::vector<planner_t*> portfolio_planners;
+    for (unsigned int i = 0; i < planners.size(); i++) {
+        if (!planners[i]->releases_gil(*systems[i])) {
+            throw std::domain_error("run_portfolio requires planners, systems and distances implemented in C++");
+        }
+        planners[i]->check_system(*systems[i]);
+        for (unsigned int j = 0; j < i; j++) {
+            if (planners[j] == planners[i] || systems[j] == systems[i]) {
+                throw std::domain_error("run_portfolio requires distinct planners and systems");
+            }
+        }
+        portfolio_planners.push_back(planners[i]->planner.get());
+    }
+
+    planner_portfolio_t portfolio(portfolio_planners, systems);
+    int best_planner;
+    {
+        py::gil_scoped_release release;
+        best_planner = portfolio.run(min_time_steps, max_time_steps, integration_step,
+                                     time_budget, solution_found, share_cost_bound);
+    }
+    if (best_planner < 0) {
+        return py::none();
+    }
+    return py::cast(best_planner);
+}
+
+
 PYBIND11_MODULE(_sst_module, m) {
    m.doc() = "Python wrapper for SST planners";
 
@@ -704,17 +1273,26 @@ PYBIND11_MODULE(_sst_module, m) {
         .def("get_state_bounds", &system_t::get_state_bounds)
         .def("get_control_bounds", &system_t::get_control_bounds)
         .def("is_circular_topology", &system_t::is_circular_topology)
+        .def("valid_state", &system_valid_state, "state"_a)
+   ;
+   py::class_<integrated_system_t> integrated_system(m, "IntegratedSystem", system);
+   integrated_system
+        .def("set_integrator", &set_system_integrator,
+            "integrator"_a,
+            "tolerance"_a=RK45_DEFAULT_TOLERANCE
+        )
+        .def("is_velocity", &integrated_system_t::is_velocity)
    ;
    py::class_<car_t>(m, "Car", system).def(py::init<>());
-   py::class_<cart_pole_t>(m, "CartPole", system).def(py::init<>());
+   py::class_<cart_pole_t>(m, "CartPole", integrated_system).def(py::init<>());
    py::class_<pendulum_t>(m, "Pendulum", system).def(py::init<>());
    py::class_<point_t>(m, "Point", system)
        .def(py::init<int>(),
             "number_of_obstacles"_a=5
        );
-   py::class_<rally_car_t>(m, "RallyCar", system).def(py::init<>());
-   py::class_<two_link_acrobot_t>(m, "TwoLinkAcrobot", system).def(py::init<>());
-   py::class_<quadrotor_t>(m, "Quadrotor", system).def(py::init<>());
+   py::class_<rally_car_t>(m, "RallyCar", integrated_system).def(py::init<>());
+   py::class_<two_link_acrobot_t>(m, "TwoLinkAcrobot", integrated_system).def(py::init<>());
+   py::class_<quadrotor_t>(m, "Quadrotor", integrated_system).def(py::init<>());
    /**
     * Universal system interface for obs based envs
     */
@@ -731,6 +1309,23 @@ PYBIND11_MODULE(_sst_module, m) {
    py::class_<PlannerWrapper> planner(m, "PlannerWrapper");
    planner
         .def("step", &PlannerWrapper::step)
+        .def("step_n", &PlannerWrapper::step_n,
+            "system"_a,
+            "number_of_iterations"_a,
+            "min_time_steps"_a,
+            "max_time_steps"_a,
+            "integration_step"_a
+            )
+        .def("run_until", &PlannerWrapper::run_until,
+            "system"_a,
+            "min_time_steps"_a,
+            "max_time_steps"_a,
+            "integration_step"_a,
+            "time_budget"_a=std::numeric_limits<double>::infinity(),
+            "node_budget"_a=0,
+            "solution_found"_a=false
+            )
+        .def("has_solution", &PlannerWrapper::has_solution)
         .def("visualize_tree", &PlannerWrapper::visualize_tree_wrapper,
             "system"_a,
             "image_width"_a=500,
@@ -748,8 +1343,79 @@ PYBIND11_MODULE(_sst_module, m) {
             )
         .def("get_solution", &PlannerWrapper::get_solution)
         .def("get_number_of_nodes", &PlannerWrapper::get_number_of_nodes)
+        .def("get_best_cost", &PlannerWrapper::get_best_cost)
+        .def("set_sampling", &PlannerWrapper::set_sampling,
+            "goal_bias"_a=0.,
+            "cost_per_distance"_a=0.,
+            "sampler"_a=py::none()
+            )
+        .def("save_tree", &PlannerWrapper::save_tree,
+            "filename"_a
+            )
+        .def("load_tree", &PlannerWrapper::load_tree,
+            "filename"_a
+            )
+   ;
+
+   py::class_<TreeFileWrapper>(m, "TreeFile")
+        .def(py::init<const std::string&>(),
+            "filename"_a
+        )
+        .def("get_number_of_nodes", [](const TreeFileWrapper& self) { return self.file->get_number_of_nodes(); })
+        .def("get_number_of_witnesses", [](const TreeFileWrapper& self) { return self.file->get_number_of_witnesses(); })
+        .def_property_readonly("states", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_states(), file.get_number_of_nodes(), file.get_state_dimension());
+        })
+        .def_property_readonly("controls", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_controls(), file.get_number_of_nodes(), file.get_control_dimension());
+        })
+        .def_property_readonly("durations", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_durations(), file.get_number_of_nodes(), 0);
+        })
+        .def_property_readonly("costs", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_costs(), file.get_number_of_nodes(), 0);
+        })
+        .def_property_readonly("parents", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_parents(), file.get_number_of_nodes(), 0);
+        })
+        .def_property_readonly("flags", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_flags(), file.get_number_of_nodes(), 0);
+        })
+        .def_property_readonly("witness_states", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_witness_states(), file.get_number_of_witnesses(), file.get_state_dimension());
+        })
+        .def_property_readonly("representatives", [](py::object self) {
+            const tree_file_t& file = *self.cast<TreeFileWrapper&>().file;
+            return TreeFileWrapper::view(self, file.get_representatives(), file.get_number_of_witnesses(), 0);
+        })
+        .def("find_cheapest_near", &TreeFileWrapper::find_cheapest_near,
+            "state"_a,
+            "radius"_a,
+            "distance"_a
+        )
+        .def("get_branch", &TreeFileWrapper::get_branch,
+            "node"_a
+        )
    ;
 
+   m.def("run_portfolio", &run_portfolio,
+        "planners"_a,
+        "systems"_a,
+        "min_time_steps"_a,
+        "max_time_steps"_a,
+        "integration_step"_a,
+        "time_budget"_a=std::numeric_limits<double>::infinity(),
+        "solution_found"_a=false,
+        "share_cost_bound"_a=true
+        );
+
    py::class_<RRTWrapper>(m, "RRTWrapper", planner)
         .def(py::init<const py::safe_array<double>&,
                       const py::safe_array<double>&,
@@ -757,14 +1423,16 @@ PYBIND11_MODULE(_sst_module, m) {
                       const py::safe_array<double>&,
                       const py::safe_array<double>&,
                       double,
-                      unsigned int>(),
+                      unsigned int,
+                      const std::string&>(),
             "state_bounds"_a,
             "control_bounds"_a,
             "distance"_a,
             "start_state"_a,
             "goal_state"_a,
             "goal_radius"_a,
-            "random_seed"_a
+            "random_seed"_a,
+            "nearest_neighbors"_a="graph"
         )
     ;
 
@@ -777,7 +1445,50 @@ PYBIND11_MODULE(_sst_module, m) {
                       double,
                       unsigned int,
                       double,
-                      double>(),
+                      double,
+                      const std::string&>(),
+            "state_bounds"_a,
+            "control_bounds"_a,
+            "distance"_a,
+            "start_state"_a,
+            "goal_state"_a,
+            "goal_radius"_a,
+            "random_seed"_a,
+            "sst_delta_near"_a,
+            "sst_delta_drain"_a,
+            "nearest_neighbors"_a="graph"
+        )
+        .def("set_goal", &SSTWrapper::set_goal,
+            "goal_state"_a,
+            "goal_radius"_a
+        )
+        .def("add_start", &SSTWrapper::add_start,
+            "start_state"_a
+        )
+        .def("set_retain_tree", &SSTWrapper::set_retain_tree,
+            "value"_a
+        )
+        .def("prune", &SSTWrapper::prune)
+        .def("step_parallel", &SSTWrapper::step_parallel,
+            "systems"_a,
+            "min_time_steps"_a,
+            "max_time_steps"_a,
+            "integration_step"_a,
+            "batch_size"_a
+        )
+   ;
+   py::class_<BidirectionalSSTWrapper>(m, "BidirectionalSSTWrapper", planner)
+        .def(py::init<const py::safe_array<double>&,
+                      const py::safe_array<double>&,
+                      py::object,
+                      const py::safe_array<double>&,
+                      const py::safe_array<double>&,
+                      double,
+                      unsigned int,
+                      double,
+                      double,
+                      double,
+                      const std::string&>(),
             "state_bounds"_a,
             "control_bounds"_a,
             "distance"_a,
@@ -786,7 +1497,9 @@ PYBIND11_MODULE(_sst_module, m) {
             "goal_radius"_a,
             "random_seed"_a,
             "sst_delta_near"_a,
-            "sst_delta_drain"_a
+            "sst_delta_drain"_a,
+            "connection_radius"_a,
+            "nearest_neighbors"_a="graph"
         )
    ;
     py::class_<SSTBackendWrapper>(m, "SSTBackendWrapper", planner)
@@ -798,7 +1511,8 @@ PYBIND11_MODULE(_sst_module, m) {
                     double,
                     unsigned int,
                     double,
-                    double>(),
+                    double,
+                    const std::string&>(),
         "state_bounds"_a,
         "control_bounds"_a,
         "distance"_a,
@@ -807,7 +1521,8 @@ PYBIND11_MODULE(_sst_module, m) {
         "goal_radius"_a,
         "random_seed"_a,
         "sst_delta_near"_a,
-        "sst_delta_drain"_a
+        "sst_delta_drain"_a,
+        "nearest_neighbors"_a="graph"
     )
     .def("nearest_vertex", &SSTBackendWrapper::nearest_vertex,
         "sample_state_array"_a
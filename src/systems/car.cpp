@@ -13,6 +13,7 @@
  */
 
 #include "systems/car.hpp"
+#include "systems/batch_propagation.hpp"
 #include "utilities/random.hpp"
 
 #define WIDTH 2.0
@@ -29,23 +30,91 @@
 
 #include <cmath>
 
+namespace
+{
+    /**
+     * @brief One integration step of car_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The trigonometric functions are evaluated per lane, the rest of the step is vectorized
+        batch_lanes_t sin_theta, cos_theta;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            sin_theta[lane] = sin(state[STATE_THETA][lane]);
+            cos_theta[lane] = cos(state[STATE_THETA][lane]);
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double theta = state[STATE_THETA][lane] + integration_step*control[1][lane];
+            next[STATE_X][lane] = state[STATE_X][lane] + integration_step*(cos_theta[lane] * control[0][lane]);
+            next[STATE_Y][lane] = state[STATE_Y][lane] + integration_step*(-sin_theta[lane] * control[0][lane]);
+            next[STATE_THETA][lane] = theta < -M_PI ? theta + 2*M_PI : (theta > M_PI ? theta - 2*M_PI : theta);
+        }
+    }
+}
+
 
 bool car_t::propagate(
     const double* start_state, unsigned int state_dimension,
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+	double temp_state[3];
+	double deriv[3];
 	temp_state[0] = start_state[0]; temp_state[1] = start_state[1];temp_state[2] = start_state[2];
 
 	bool validity = true;
 	for(int i=0;i<num_steps;i++)
 	{
-        update_derivative(control);
+        update_derivative(temp_state, control, deriv);
         temp_state[0] += integration_step*deriv[0];
         temp_state[1] += integration_step*deriv[1];
         temp_state[2] += integration_step*deriv[2];
-		enforce_bounds();
-		validity = validity && valid_state();
+		enforce_bounds(temp_state);
+		validity = validity && valid_state(temp_state);
+	}
+	result_state[0] = temp_state[0];
+	result_state[1] = temp_state[1];
+	result_state[2] = temp_state[2];
+	return validity;
+}
+
+void car_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step)
+{
+	propagate_lanes<3, 2, false>(
+		integrate_lanes,
+		[](const batch_lanes_t* state, unsigned int lane) {
+			return !(state[STATE_X][lane] < MIN_X || state[STATE_X][lane] > MAX_X ||
+			         state[STATE_Y][lane] < MIN_Y || state[STATE_Y][lane] > MAX_Y);
+		},
+		true, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+bool car_t::propagate_backward(
+    const double* end_state, unsigned int state_dimension,
+    const double* control, unsigned int control_dimension,
+    int num_steps, double* result_state, double integration_step)
+{
+	double temp_state[3];
+	double deriv[3];
+	temp_state[0] = end_state[0]; temp_state[1] = end_state[1];temp_state[2] = end_state[2];
+
+	bool validity = true;
+	for(int i=0;i<num_steps;i++)
+	{
+        // The derivative of a forward step depends only on the heading it starts with
+        temp_state[2] -= integration_step*control[1];
+        enforce_bounds(temp_state);
+        update_derivative(temp_state, control, deriv);
+        temp_state[0] -= integration_step*deriv[0];
+        temp_state[1] -= integration_step*deriv[1];
+		enforce_bounds(temp_state);
+		validity = validity && valid_state(temp_state);
 	}
 	result_state[0] = temp_state[0];
 	result_state[1] = temp_state[1];
@@ -53,37 +122,37 @@ bool car_t::propagate(
 	return validity;
 }
 
-void car_t::update_derivative(const double* control)
+void car_t::update_derivative(const double* state, const double* control, double* derivative) const
 {
     // angle: clockwise
-    deriv[0] = cos(temp_state[2]) * control[0];
-    deriv[1] = -sin(temp_state[2]) * control[0];
-    deriv[2] = control[1];
+    derivative[0] = cos(state[2]) * control[0];
+    derivative[1] = -sin(state[2]) * control[0];
+    derivative[2] = control[1];
 }
 
 
-void car_t::enforce_bounds()
+void car_t::enforce_bounds(double* state) const
 {
     /*
-	if(temp_state[0]<-10)
-		temp_state[0]=-10;
-	else if(temp_state[0]>10)
-		temp_state[0]=10;
-
-	if(temp_state[1]<-10)
-		temp_state[1]=-10;
-	else if(temp_state[1]>10)
-		temp_state[1]=10;
+	if(state[0]<-10)
+		state[0]=-10;
+	else if(state[0]>10)
+		state[0]=10;
+
+	if(state[1]<-10)
+		state[1]=-10;
+	else if(state[1]>10)
+		state[1]=10;
     */
-	if(temp_state[2]<-M_PI)
-		temp_state[2]+=2*M_PI;
-	else if(temp_state[2]>M_PI)
-		temp_state[2]-=2*M_PI;
+	if(state[2]<-M_PI)
+		state[2]+=2*M_PI;
+	else if(state[2]>M_PI)
+		state[2]-=2*M_PI;
 }
 
-bool car_t::valid_state()
+bool car_t::valid_state(const double* state) const
 {
-    if (temp_state[0] < MIN_X || temp_state[0] > MAX_X || temp_state[1] < MIN_Y || temp_state[1] > MAX_Y)
+    if (state[0] < MIN_X || state[0] > MAX_X || state[1] < MIN_Y || state[1] > MAX_Y)
     {
         return false;
     }
@@ -13,6 +13,8 @@
  */
 
 #include "systems/car_obs.hpp"
+#include "systems/batch_propagation.hpp"
+#include "systems/swept_collision.hpp"
 #include "utilities/random.hpp"
 
 #define WIDTH 2.0
@@ -29,62 +31,126 @@
 
 #include <cmath>
 
+namespace
+{
+    /**
+     * @brief One integration step of car_obs_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The trigonometric functions are evaluated per lane, the rest of the step is vectorized
+        batch_lanes_t sin_theta, cos_theta;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            sin_theta[lane] = sin(state[STATE_THETA][lane]);
+            cos_theta[lane] = cos(state[STATE_THETA][lane]);
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double theta = state[STATE_THETA][lane] + integration_step*control[1][lane];
+            next[STATE_X][lane] = state[STATE_X][lane] + integration_step*(cos_theta[lane] * control[0][lane]);
+            next[STATE_Y][lane] = state[STATE_Y][lane] + integration_step*(-sin_theta[lane] * control[0][lane]);
+            next[STATE_THETA][lane] = theta < -M_PI ? theta + 2*M_PI : (theta > M_PI ? theta - 2*M_PI : theta);
+        }
+    }
+}
+
 
 bool car_obs_t::propagate(
     const double* start_state, unsigned int state_dimension,
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+	double temp_state[3];
+	double deriv[3];
 	temp_state[0] = start_state[0]; temp_state[1] = start_state[1];temp_state[2] = start_state[2];
 
+	double previous_state[3];
 	bool validity = true;
 	for(int i=0;i<num_steps;i++)
 	{
-        update_derivative(control);
+        update_derivative(temp_state, control, deriv);
+        if (continuous_collision_checking)
+        {
+            previous_state[0] = temp_state[0]; previous_state[1] = temp_state[1]; previous_state[2] = temp_state[2];
+        }
         temp_state[0] += integration_step*deriv[0];
         temp_state[1] += integration_step*deriv[1];
         temp_state[2] += integration_step*deriv[2];
-		enforce_bounds();
-		validity = validity && valid_state();
+		enforce_bounds(temp_state);
+		if (continuous_collision_checking ? valid_sweep(previous_state, temp_state) : valid_state(temp_state))
+		{
+			result_state[0] = temp_state[0];
+			result_state[1] = temp_state[1];
+			result_state[2] = temp_state[2];
+		}
+		else
+		{
+			// Found the earliest collision, the propagation ends in the last valid state
+			validity = false;
+			break;
+		}
 	}
-	result_state[0] = temp_state[0];
-	result_state[1] = temp_state[1];
-	result_state[2] = temp_state[2];
     //std::cout << "after propagation" << std::endl;
 	return validity;
 }
 
-void car_obs_t::update_derivative(const double* control)
+void car_obs_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step)
+{
+	if (continuous_collision_checking)
+	{
+		// The swept regions need the previous state of a propagation, which the lanes do not keep
+		enhanced_system_interface::propagate_batch(start_states, state_dimension, controls, control_dimension,
+		                                           num_steps, number_of_states, result_states, valid, integration_step);
+		return;
+	}
+	// Collisions are checked per lane on a copy of the lane state
+	propagate_lanes<3, 2, true>(
+		integrate_lanes,
+		[this](const batch_lanes_t* state, unsigned int lane) {
+			double lane_state[3];
+			for(unsigned int d = 0; d < 3; d++)
+				lane_state[d] = state[d][lane];
+			return valid_state(lane_state);
+		},
+		true, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+void car_obs_t::update_derivative(const double* state, const double* control, double* derivative) const
 {
-    deriv[0] = cos(temp_state[2]) * control[0];
-    deriv[1] = -sin(temp_state[2]) * control[0];
-    deriv[2] = control[1];
+    derivative[0] = cos(state[2]) * control[0];
+    derivative[1] = -sin(state[2]) * control[0];
+    derivative[2] = control[1];
 }
 
 
-void car_obs_t::enforce_bounds()
+void car_obs_t::enforce_bounds(double* state) const
 {
     /*
-	if(temp_state[0]<-10)
-		temp_state[0]=-10;
-	else if(temp_state[0]>10)
-		temp_state[0]=10;
-
-	if(temp_state[1]<-10)
-		temp_state[1]=-10;
-	else if(temp_state[1]>10)
-		temp_state[1]=10;
+	if(state[0]<-10)
+		state[0]=-10;
+	else if(state[0]>10)
+		state[0]=10;
+
+	if(state[1]<-10)
+		state[1]=-10;
+	else if(state[1]>10)
+		state[1]=10;
     */
-	if(temp_state[2]<-M_PI)
-		temp_state[2]+=2*M_PI;
-	else if(temp_state[2]>M_PI)
-		temp_state[2]-=2*M_PI;
+	if(state[2]<-M_PI)
+		state[2]+=2*M_PI;
+	else if(state[2]>M_PI)
+		state[2]-=2*M_PI;
 }
 
-bool car_obs_t::overlap(std::vector<std::vector<double>>& b1corner, std::vector<std::vector<double>>& b1axis,
-                        std::vector<double>& b1orign, std::vector<double>& b1ds,
-                        std::vector<std::vector<double>>& b2corner, std::vector<std::vector<double>>& b2axis,
-                        std::vector<double>& b2orign, std::vector<double>& b2ds)
+bool car_obs_t::overlap(const std::vector<std::vector<double>>& b1corner, const std::vector<std::vector<double>>& b1axis,
+                        const std::vector<double>& b1orign, const std::vector<double>& b1ds,
+                        const std::vector<std::vector<double>>& b2corner, const std::vector<std::vector<double>>& b2axis,
+                        const std::vector<double>& b2orign, const std::vector<double>& b2ds) const
 {
     for (unsigned a = 0; a < 2; a++)
     {
@@ -112,9 +178,9 @@ bool car_obs_t::overlap(std::vector<std::vector<double>>& b1corner, std::vector<
 
 }
 
-bool car_obs_t::valid_state()
+bool car_obs_t::valid_state(const double* state) const
 {
-    if (temp_state[0] < MIN_X || temp_state[0] > MAX_X || temp_state[1] < MIN_Y || temp_state[1] > MAX_Y)
+    if (state[0] < MIN_X || state[0] > MAX_X || state[1] < MIN_Y || state[1] > MAX_Y)
     {
         return false;
     }
@@ -127,18 +193,18 @@ bool car_obs_t::valid_state()
     std::vector<double> X1(2,0);
     std::vector<double> Y1(2,0);
 
-    X1[0]=cos(temp_state[STATE_THETA])*(WIDTH/2.0);
-    X1[1]=-sin(temp_state[STATE_THETA])*(WIDTH/2.0);
-    Y1[0]=sin(temp_state[STATE_THETA])*(LENGTH/2.0);
-    Y1[1]=cos(temp_state[STATE_THETA])*(LENGTH/2.0);
+    X1[0]=cos(state[STATE_THETA])*(WIDTH/2.0);
+    X1[1]=-sin(state[STATE_THETA])*(WIDTH/2.0);
+    Y1[0]=sin(state[STATE_THETA])*(LENGTH/2.0);
+    Y1[1]=cos(state[STATE_THETA])*(LENGTH/2.0);
 
     for (unsigned j = 0; j < 2; j++)
     {
         // order: (left-bottom, right-bottom, right-upper, left-upper)
-        robot_corner[0][j]=temp_state[j]-X1[j]-Y1[j];
-        robot_corner[1][j]=temp_state[j]+X1[j]-Y1[j];
-        robot_corner[2][j]=temp_state[j]+X1[j]+Y1[j];
-        robot_corner[3][j]=temp_state[j]-X1[j]+Y1[j];
+        robot_corner[0][j]=state[j]-X1[j]-Y1[j];
+        robot_corner[1][j]=state[j]+X1[j]-Y1[j];
+        robot_corner[2][j]=state[j]+X1[j]+Y1[j];
+        robot_corner[3][j]=state[j]-X1[j]+Y1[j];
         //axis: horizontal and vertical
         robot_axis[0][j] = robot_corner[1][j] - robot_corner[0][j];
         robot_axis[1][j] = robot_corner[3][j] - robot_corner[0][j];
@@ -161,25 +227,63 @@ bool car_obs_t::valid_state()
     static std::vector<double> car_size{WIDTH, LENGTH};
     static std::vector<double> obs_size{this->obs_width, this->obs_width};
 
-    for (unsigned i=0; i<obs_list.size(); i++)
+    // only the obstacles around the bounding box of the car can overlap it
+    double robot_box[4] = {robot_corner[0][0], robot_corner[0][0], robot_corner[0][1], robot_corner[0][1]};
+    for (unsigned c = 1; c < 4; c++)
     {
+        robot_box[0] = std::min(robot_box[0], robot_corner[c][0]);
+        robot_box[1] = std::max(robot_box[1], robot_corner[c][0]);
+        robot_box[2] = std::min(robot_box[2], robot_corner[c][1]);
+        robot_box[3] = std::max(robot_box[3], robot_corner[c][1]);
+    }
+    // invalid state if the car overlaps an obstacle
+    return !obstacle_grid.any_near(robot_box, [&](unsigned int i) {
         bool collision = true;
         // do checking in both direction (b1 -> b2, b2 -> b1). It is only collision if both direcions are collision
         collision = overlap(robot_corner,robot_axis,robot_ori,car_size,\
                             obs_list[i],obs_axis[i],obs_ori[i],obs_size);
         collision = collision&overlap(obs_list[i],obs_axis[i],obs_ori[i],obs_size,\
                                       robot_corner,robot_axis,robot_ori,car_size);
-        if (collision)
+        return collision;
+    });
+}
+
+bool car_obs_t::valid_sweep(const double* from_state, const double* state) const
+{
+    // the car moves along a line, so the motion is within bounds if its end is
+    if (state[0] < MIN_X || state[0] > MAX_X || state[1] < MIN_Y || state[1] > MAX_Y)
+    {
+        return false;
+    }
+
+    // the corners of the car in both states
+    double corners[16];
+    const double* states[2] = {from_state, state};
+    for (unsigned s = 0; s < 2; s++)
+    {
+        double X1[2], Y1[2];
+        X1[0]=cos(states[s][STATE_THETA])*(WIDTH/2.0);
+        X1[1]=-sin(states[s][STATE_THETA])*(WIDTH/2.0);
+        Y1[0]=sin(states[s][STATE_THETA])*(LENGTH/2.0);
+        Y1[1]=cos(states[s][STATE_THETA])*(LENGTH/2.0);
+        for (unsigned j = 0; j < 2; j++)
         {
-            return false;  // invalid state
+            // order: (left-bottom, right-bottom, right-upper, left-upper)
+            corners[8*s+j]=states[s][j]-X1[j]-Y1[j];
+            corners[8*s+2+j]=states[s][j]+X1[j]-Y1[j];
+            corners[8*s+4+j]=states[s][j]+X1[j]+Y1[j];
+            corners[8*s+6+j]=states[s][j]-X1[j]+Y1[j];
         }
     }
-    //std::cout << "after valid" << std::endl;
-
-    return true;
-
-
-
+    // the corners turn around the center of the car
+    double margin = arc_deviation(sqrt(WIDTH*WIDTH + LENGTH*LENGTH) / 2.0, from_state[STATE_THETA], state[STATE_THETA]);
+
+    double sweep_box[4];
+    hull_bounding_box(corners, 8, margin, sweep_box);
+    return !obstacle_grid.any_near(sweep_box, [&](unsigned int i) {
+        // the left-bottom and right-upper corners of the obstacle
+        return hull_overlaps_box(corners, 8, margin, obs_list[i][0][0], obs_list[i][0][1], obs_list[i][2][0], obs_list[i][2][1]);
+    });
 }
 
 std::tuple<double, double> car_obs_t::visualize_point(const double* state, unsigned int state_dimension) const
@@ -247,4 +351,8 @@ double car_obs_t::get_loss(double* state, const double* goal, double* weight){
     if(val > M_PI)
             val = 2*M_PI-val;
     return std::sqrt(val * val * weight[STATE_THETA] + pow(state[STATE_X]-goal[STATE_X], 2.0) * weight[STATE_X]+ pow(state[STATE_Y]-goal[STATE_Y], 2.0)* weight[STATE_Y]);
+}
+
+void car_obs_t::get_loss_batch(double* states, unsigned int number_of_states, const double* goal, double* weight, double* losses){
+    weighted_euclidean_loss_batch(states, number_of_states, goal, weight, losses);
 }
\ No newline at end of file
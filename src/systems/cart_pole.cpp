@@ -14,6 +14,7 @@
 
 
 #include "systems/cart_pole.hpp"
+#include "systems/batch_propagation.hpp"
 #include "utilities/random.hpp"
 
 
@@ -43,11 +44,53 @@
 #define MAX_W 2
 
 
+namespace
+{
+    /**
+     * @brief One integration step of cart_pole_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The trigonometric functions are evaluated per lane, the rest of the step is vectorized
+        batch_lanes_t sin_theta, cos_theta;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            sin_theta[lane] = sin(state[STATE_THETA][lane]);
+            cos_theta[lane] = cos(state[STATE_THETA][lane]);
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double _v = state[STATE_V][lane];
+            double _w = state[STATE_W][lane];
+            double _a = control[CONTROL_A][lane];
+            double _sin = sin_theta[lane];
+            double _cos = cos_theta[lane];
+            double mass_term = (M + m)*(I + m * L * L) - m * m * L * L * _cos * _cos;
+            mass_term = (1.0 / mass_term);
+            double dv = ((I + m * L * L)*(_a + m * L * _w * _w * _sin) + m * m * L * L * _cos * _sin * g) * mass_term;
+            double dw = ((-m * L * _cos)*(_a + m * L * _w * _w * _sin)+(M + m)*(-m * g * L * _sin)) * mass_term;
+
+            double x = state[STATE_X][lane] + integration_step*_v;
+            double v = state[STATE_V][lane] + integration_step*dv;
+            double theta = state[STATE_THETA][lane] + integration_step*_w;
+            double w = state[STATE_W][lane] + integration_step*dw;
+
+            next[STATE_X][lane] = x < MIN_X ? MIN_X : (x > MAX_X ? MAX_X : x);
+            next[STATE_V][lane] = v < MIN_V ? MIN_V : (v > MAX_V ? MAX_V : v);
+            next[STATE_THETA][lane] = theta < -M_PI ? theta + 2*M_PI : (theta > M_PI ? theta - 2*M_PI : theta);
+            next[STATE_W][lane] = w < MIN_W ? MIN_W : (w > MAX_W ? MAX_W : w);
+        }
+    }
+}
+
+
 bool cart_pole_t::propagate(
     const double* start_state, unsigned int state_dimension,
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+        double temp_state[4];
+        double deriv[4];
         temp_state[0] = start_state[0]; 
         temp_state[1] = start_state[1];
         temp_state[2] = start_state[2];
@@ -55,13 +98,20 @@ bool cart_pole_t::propagate(
         bool validity = true;
         for(int i=0;i<num_steps;i++)
         {
-                update_derivative(control);
-                temp_state[0] += integration_step*deriv[0];
-                temp_state[1] += integration_step*deriv[1];
-                temp_state[2] += integration_step*deriv[2];
-                temp_state[3] += integration_step*deriv[3];
-                enforce_bounds();
-                validity = validity && valid_state();
+                if(integrator)
+                {
+                        integrate(temp_state, control, integration_step);
+                }
+                else
+                {
+                        update_derivative(temp_state, control, deriv);
+                        temp_state[0] += integration_step*deriv[0];
+                        temp_state[1] += integration_step*deriv[1];
+                        temp_state[2] += integration_step*deriv[2];
+                        temp_state[3] += integration_step*deriv[3];
+                }
+                enforce_bounds(temp_state);
+                validity = validity && valid_state(temp_state);
         }
         result_state[0] = temp_state[0];
         result_state[1] = temp_state[1];
@@ -70,31 +120,50 @@ bool cart_pole_t::propagate(
         return validity;
 }
 
-void cart_pole_t::enforce_bounds()
+void cart_pole_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step)
 {
-        if(temp_state[0]<MIN_X)
-                temp_state[0]=MIN_X;
-        else if(temp_state[0]>MAX_X)
-                temp_state[0]=MAX_X;
-
-        if(temp_state[1]<MIN_V)
-                temp_state[1]=MIN_V;
-        else if(temp_state[1]>MAX_V)
-                temp_state[1]=MAX_V;
-
-        if(temp_state[2]<-M_PI)
-                temp_state[2]+=2*M_PI;
-        else if(temp_state[2]>M_PI)
-                temp_state[2]-=2*M_PI;
-
-        if(temp_state[3]<MIN_W)
-                temp_state[3]=MIN_W;
-        else if(temp_state[3]>MAX_W)
-                temp_state[3]=MAX_W;
+        if(integrator)
+        {
+                // Other integrators than explicit Euler are not vectorized
+                system_interface::propagate_batch(start_states, state_dimension, controls, control_dimension,
+                                                  num_steps, number_of_states, result_states, valid, integration_step);
+                return;
+        }
+        propagate_lanes<4, 1, false>(
+            integrate_lanes,
+            [](const batch_lanes_t*, unsigned int) { return true; },
+            true, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+void cart_pole_t::enforce_bounds(double* state) const
+{
+        if(state[0]<MIN_X)
+                state[0]=MIN_X;
+        else if(state[0]>MAX_X)
+                state[0]=MAX_X;
+
+        if(state[1]<MIN_V)
+                state[1]=MIN_V;
+        else if(state[1]>MAX_V)
+                state[1]=MAX_V;
+
+        if(state[2]<-M_PI)
+                state[2]+=2*M_PI;
+        else if(state[2]>M_PI)
+                state[2]-=2*M_PI;
+
+        if(state[3]<MIN_W)
+                state[3]=MIN_W;
+        else if(state[3]>MAX_W)
+                state[3]=MAX_W;
 }
 
 
-bool cart_pole_t::valid_state()
+bool cart_pole_t::valid_state(const double* state) const
 {
     return true;
 }
@@ -109,19 +178,19 @@ std::tuple<double, double> cart_pole_t::visualize_point(const double* state, uns
     return std::make_tuple(x, y);
 }
 
-void cart_pole_t::update_derivative(const double* control)
+void cart_pole_t::update_derivative(const double* state, const double* control, double* derivative) const
 {
-    double _v = temp_state[STATE_V];
-    double _w = temp_state[STATE_W];
-    double _theta = temp_state[STATE_THETA];
+    double _v = state[STATE_V];
+    double _w = state[STATE_W];
+    double _theta = state[STATE_THETA];
     double _a = control[CONTROL_A];
     double mass_term = (M + m)*(I + m * L * L) - m * m * L * L * cos(_theta) * cos(_theta);
 
-    deriv[STATE_X] = _v;
-    deriv[STATE_THETA] = _w;
+    derivative[STATE_X] = _v;
+    derivative[STATE_THETA] = _w;
     mass_term = (1.0 / mass_term);
-    deriv[STATE_V] = ((I + m * L * L)*(_a + m * L * _w * _w * sin(_theta)) + m * m * L * L * cos(_theta) * sin(_theta) * g) * mass_term;
-    deriv[STATE_W] = ((-m * L * cos(_theta))*(_a + m * L * _w * _w * sin(_theta))+(M + m)*(-m * g * L * sin(_theta))) * mass_term;
+    derivative[STATE_V] = ((I + m * L * L)*(_a + m * L * _w * _w * sin(_theta)) + m * m * L * L * cos(_theta) * sin(_theta) * g) * mass_term;
+    derivative[STATE_W] = ((-m * L * cos(_theta))*(_a + m * L * _w * _w * sin(_theta))+(M + m)*(-m * g * L * sin(_theta))) * mass_term;
 }
 
 
@@ -149,4 +218,14 @@ std::vector<bool> cart_pole_t::is_circular_topology() const {
             true,
             false
     };
+}
+
+
+std::vector<bool> cart_pole_t::is_velocity() const {
+    return {
+            false,
+            true,
+            false,
+            true
+    };
 }
\ No newline at end of file
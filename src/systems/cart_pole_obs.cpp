@@ -14,6 +14,8 @@
 
 
 #include "systems/cart_pole_obs.hpp"
+#include "systems/batch_propagation.hpp"
+#include "systems/swept_collision.hpp"
 #include "utilities/random.hpp"
 #include <iostream>
 
@@ -45,16 +47,63 @@
 #define MAX_W 2
 
 
+namespace
+{
+    /**
+     * @brief One integration step of cart_pole_obs_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The trigonometric functions are evaluated per lane, the rest of the step is vectorized
+        batch_lanes_t sin_theta, cos_theta;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            sin_theta[lane] = sin(state[STATE_THETA][lane]);
+            cos_theta[lane] = cos(state[STATE_THETA][lane]);
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double _v = state[STATE_V][lane];
+            double _w = state[STATE_W][lane];
+            double _a = control[CONTROL_A][lane];
+            _a = _a > 300 ? 300 : (_a < -300 ? -300 : _a);
+            double _sin = sin_theta[lane];
+            double _cos = cos_theta[lane];
+            double mass_term = (M + m)*(I + m * L * L) - m * m * L * L * _cos * _cos;
+            mass_term = (1.0 / mass_term);
+            double dv = ((I + m * L * L)*(_a + m * L * _w * _w * _sin) + m * m * L * L * _cos * _sin * g) * mass_term;
+            double dw = ((-m * L * _cos)*(_a + m * L * _w * _w * _sin)+(M + m)*(-m * g * L * _sin)) * mass_term;
+
+            double v = state[STATE_V][lane] + integration_step*dv;
+            double theta = state[STATE_THETA][lane] + integration_step*_w;
+            double w = state[STATE_W][lane] + integration_step*dw;
+
+            // The position is not bounded, leaving the bounds makes the state invalid
+            next[STATE_X][lane] = state[STATE_X][lane] + integration_step*_v;
+            next[STATE_V][lane] = v < MIN_V ? MIN_V : (v > MAX_V ? MAX_V : v);
+            next[STATE_THETA][lane] = theta < -M_PI ? theta + 2*M_PI : (theta > M_PI ? theta - 2*M_PI : theta);
+            next[STATE_W][lane] = w < MIN_W ? MIN_W : (w > MAX_W ? MAX_W : w);
+        }
+    }
+}
+
+
 bool cart_pole_obs_t::propagate(
     const double* start_state, unsigned int state_dimension,
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+        double temp_state[4];
+        double deriv[4];
+        kinematics_t kinematics;
         // std::cout<< start_state[0] <<","<<  start_state[1] <<","<<  start_state[2] <<","<<  start_state[3]<<std::endl;
         temp_state[0] = start_state[0];
         temp_state[1] = start_state[1];
         temp_state[2] = start_state[2];
         temp_state[3] = start_state[3];
+        update_kinematics(temp_state, kinematics);
+        double previous_state[4];
+        kinematics_t previous_kinematics;
         bool validity = false;
         double enforced_control;
         if(*control > 300){
@@ -66,14 +115,24 @@ bool cart_pole_obs_t::propagate(
         }
         for(int i=0;i<num_steps;i++)
         {
-                update_derivative(&enforced_control);
+                update_derivative(temp_state, &enforced_control, kinematics, deriv);
+                if (continuous_collision_checking)
+                {
+                    for (unsigned int d = 0; d < 4; d++)
+                        previous_state[d] = temp_state[d];
+                    previous_kinematics = kinematics;
+                }
                 temp_state[0] += integration_step*deriv[0];
                 temp_state[1] += integration_step*deriv[1];
                 temp_state[2] += integration_step*deriv[2];
                 temp_state[3] += integration_step*deriv[3];
-                enforce_bounds();
-                //validity = validity && valid_state();
-                if (valid_state() == true)
+                enforce_bounds(temp_state);
+                update_kinematics(temp_state, kinematics);
+                //validity = validity && valid_state(temp_state);
+                bool valid_step = continuous_collision_checking ?
+                    valid_sweep(previous_state, previous_kinematics, temp_state, kinematics) :
+                    valid_kinematics(temp_state, kinematics);
+                if (valid_step == true)
                 {
                     result_state[0] = temp_state[0];
                     result_state[1] = temp_state[1];
@@ -98,52 +157,90 @@ bool cart_pole_obs_t::propagate(
         return validity;
 }
 
-void cart_pole_obs_t::enforce_bounds()
+void cart_pole_obs_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step)
+{
+        if (continuous_collision_checking)
+        {
+            // The swept regions need the previous state of a propagation, which the lanes do not keep
+            enhanced_system_interface::propagate_batch(start_states, state_dimension, controls, control_dimension,
+                                                       num_steps, number_of_states, result_states, valid, integration_step);
+            return;
+        }
+        // Collisions are checked per lane on a copy of the lane state
+        propagate_lanes<4, 1, true>(
+            integrate_lanes,
+            [this](const batch_lanes_t* state, unsigned int lane) {
+                double lane_state[4];
+                for(unsigned int d = 0; d < 4; d++)
+                    lane_state[d] = state[d][lane];
+                return valid_state(lane_state);
+            },
+            false, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+void cart_pole_obs_t::enforce_bounds(double* state) const
 {
         // fpr the position, if it is outside of bound, we don't enforce it back
-        //if(temp_state[0]<MIN_X)
-        //        temp_state[0]=MIN_X;
-        //else if(temp_state[0]>MAX_X)
-        //        temp_state[0]=MAX_X;
-
-        if(temp_state[1]<MIN_V)
-                temp_state[1]=MIN_V;
-        else if(temp_state[1]>MAX_V)
-                temp_state[1]=MAX_V;
-
-        if(temp_state[2]<-M_PI)
-                temp_state[2]+=2*M_PI;
-        else if(temp_state[2]>M_PI)
-                temp_state[2]-=2*M_PI;
-
-        if(temp_state[3]<MIN_W)
-                temp_state[3]=MIN_W;
-        else if(temp_state[3]>MAX_W)
-                temp_state[3]=MAX_W;
+        //if(state[0]<MIN_X)
+        //        state[0]=MIN_X;
+        //else if(state[0]>MAX_X)
+        //        state[0]=MAX_X;
+
+        if(state[1]<MIN_V)
+                state[1]=MIN_V;
+        else if(state[1]>MAX_V)
+                state[1]=MAX_V;
+
+        if(state[2]<-M_PI)
+                state[2]+=2*M_PI;
+        else if(state[2]>M_PI)
+                state[2]-=2*M_PI;
+
+        if(state[3]<MIN_W)
+                state[3]=MIN_W;
+        else if(state[3]>MAX_W)
+                state[3]=MAX_W;
 }
 
 
-bool cart_pole_obs_t::valid_state()
+bool cart_pole_obs_t::valid_state(const double* state) const
+{
+    kinematics_t kinematics;
+    update_kinematics(state, kinematics);
+    return valid_kinematics(state, kinematics);
+}
+
+void cart_pole_obs_t::update_kinematics(const double* state, kinematics_t& kinematics) const
+{
+    kinematics.sin_theta = sin(state[STATE_THETA]);
+    kinematics.cos_theta = cos(state[STATE_THETA]);
+}
+
+bool cart_pole_obs_t::valid_kinematics(const double* state, const kinematics_t& kinematics) const
 {
     // check the pole with the rectangle to see if in collision
     // calculate the pole state
     // check if the position is within bound
-    if (temp_state[0] < MIN_X or temp_state[0] > MAX_X)
+    if (state[0] < MIN_X or state[0] > MAX_X)
     {
         return false;
     }
-    double pole_x1 = temp_state[0];
+    double pole_x1 = state[0];
     double pole_y1 = H;
-    double pole_x2 = temp_state[0] + L * sin(temp_state[2]);
-    double pole_y2 = H + L * cos(temp_state[2]);
-    //std::cout << "state:" << temp_state[0] << "\n";
+    double pole_x2 = state[0] + L * kinematics.sin_theta;
+    double pole_y2 = H + L * kinematics.cos_theta;
+    //std::cout << "state:" << state[0] << "\n";
     //std::cout << "pole point 1: " << "(" << pole_x1 << ", " << pole_y1 << ")\n";
     //std::cout << "pole point 2: " << "(" << pole_x2 << ", " << pole_y2 << ")\n";
-    for(unsigned int i = 0; i < obs_list.size(); i++)
-    {
+    // only the obstacles around the bounding box of the pole can intersect it
+    double pole_box[4] = {std::min(pole_x1, pole_x2), std::max(pole_x1, pole_x2),
+                          std::min(pole_y1, pole_y2), std::max(pole_y1, pole_y2)};
+    return !obstacle_grid.any_near(pole_box, [&](unsigned int i) {
         // check if any obstacle has intersection with pole
-        //std::cout << "obstacle " << i << "\n";
-        //std::cout << "points: \n";
         for (unsigned int j = 0; j < 8; j += 2)
         {
             // check each line of the obstacle
@@ -154,11 +251,33 @@ bool cart_pole_obs_t::valid_state()
             if (lineLine(pole_x1, pole_y1, pole_x2, pole_y2, x1, y1, x2, y2))
             {
                 // intersect
-                return false;
+                return true;
             }
         }
+        return false;
+    });
+}
+
+bool cart_pole_obs_t::valid_sweep(const double* from_state, const kinematics_t& from_kinematics,
+                                  const double* state, const kinematics_t& kinematics) const
+{
+    // the cart moves along a line, so the motion is within bounds if its end is
+    if (state[0] < MIN_X or state[0] > MAX_X)
+    {
+        return false;
     }
-    return true;
+    // the base and tip of the pole in both states
+    double pole[8] = {
+        from_state[STATE_X], H, from_state[STATE_X] + L * from_kinematics.sin_theta, H + L * from_kinematics.cos_theta,
+        state[STATE_X], H, state[STATE_X] + L * kinematics.sin_theta, H + L * kinematics.cos_theta
+    };
+    double margin = arc_deviation(L, from_state[STATE_THETA], state[STATE_THETA]);
+    double sweep_box[4];
+    hull_bounding_box(pole, 4, margin, sweep_box);
+    return !obstacle_grid.any_near(sweep_box, [&](unsigned int i) {
+        // the lower left and upper right corners of the obstacle
+        return hull_overlaps_box(pole, 4, margin, obs_list[i][6], obs_list[i][7], obs_list[i][2], obs_list[i][3]);
+    });
 }
 
 std::tuple<double, double> cart_pole_obs_t::visualize_point(const double* state, unsigned int state_dimension) const
@@ -171,23 +290,22 @@ std::tuple<double, double> cart_pole_obs_t::visualize_point(const double* state,
     return std::make_tuple(x, y);
 }
 
-void cart_pole_obs_t::update_derivative(const double* control)
+void cart_pole_obs_t::update_derivative(const double* state, const double* control, const kinematics_t& kinematics, double* derivative) const
 {
-    double _v = temp_state[STATE_V];
-    double _w = temp_state[STATE_W];
-    double _theta = temp_state[STATE_THETA];
+    double _v = state[STATE_V];
+    double _w = state[STATE_W];
     double _a = control[CONTROL_A];
-    double mass_term = (M + m)*(I + m * L * L) - m * m * L * L * cos(_theta) * cos(_theta);
+    double mass_term = (M + m)*(I + m * L * L) - m * m * L * L * kinematics.cos_theta * kinematics.cos_theta;
 
-    deriv[STATE_X] = _v;
-    deriv[STATE_THETA] = _w;
+    derivative[STATE_X] = _v;
+    derivative[STATE_THETA] = _w;
     mass_term = (1.0 / mass_term);
-    deriv[STATE_V] = ((I + m * L * L)*(_a + m * L * _w * _w * sin(_theta)) + m * m * L * L * cos(_theta) * sin(_theta) * g) * mass_term;
-    deriv[STATE_W] = ((-m * L * cos(_theta))*(_a + m * L * _w * _w * sin(_theta))+(M + m)*(-m * g * L * sin(_theta))) * mass_term;
+    derivative[STATE_V] = ((I + m * L * L)*(_a + m * L * _w * _w * kinematics.sin_theta) + m * m * L * L * kinematics.cos_theta * kinematics.sin_theta * g) * mass_term;
+    derivative[STATE_W] = ((-m * L * kinematics.cos_theta)*(_a + m * L * _w * _w * kinematics.sin_theta)+(M + m)*(-m * g * L * kinematics.sin_theta)) * mass_term;
 }
 
 
-bool cart_pole_obs_t::lineLine(double x1, double y1, double x2, double y2, double x3, double y3, double x4, double y4)
+bool cart_pole_obs_t::lineLine(double x1, double y1, double x2, double y2, double x3, double y3, double x4, double y4) const
 // compute whether two lines intersect with each other
 {
     // ref: http://www.jeffreythompson.org/collision-detection/line-rect.php
@@ -244,6 +362,10 @@ double cart_pole_obs_t::get_loss(double* state, const double* goal, double* weig
         + pow(state[STATE_W]-goal[STATE_W], 2.0)* weight[STATE_W]);
 }
 
+void cart_pole_obs_t::get_loss_batch(double* states, unsigned int number_of_states, const double* goal, double* weight, double* losses){
+    weighted_euclidean_loss_batch(states, number_of_states, goal, weight, losses);
+}
+
 double cart_pole_obs_t::angular_error(double angle, double goal){
     double error = angle - goal;
     if(error < 0){
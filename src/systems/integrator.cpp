@@ -0,0 +1,174 @@
+/**
+ * @file integrator.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "systems/integrator.hpp"
+
+namespace
+{
+    // Dormand-Prince 5(4) tableau
+    const double dp_a[7][6] = {
+        {0, 0, 0, 0, 0, 0},
+        {1.0/5, 0, 0, 0, 0, 0},
+        {3.0/40, 9.0/40, 0, 0, 0, 0},
+        {44.0/45, -56.0/15, 32.0/9, 0, 0, 0},
+        {19372.0/6561, -25360.0/2187, 64448.0/6561, -212.0/729, 0, 0},
+        {9017.0/3168, -355.0/33, 46732.0/5247, 49.0/176, -5103.0/18656, 0},
+        {35.0/384, 0, 500.0/1113, 125.0/192, -2187.0/6784, 11.0/84}
+    };
+    // Difference between the fifth and the fourth order weights
+    const double dp_error[7] = {
+        71.0/57600, 0, -71.0/16695, 71.0/1920, -17253.0/339200, 22.0/525, -1.0/40
+    };
+}
+
+integrator_t::integrator_t(unsigned int state_dimension)
+    : state_dimension(state_dimension)
+{
+}
+
+double* integrator_t::scratch(unsigned int size)
+{
+    thread_local std::vector<double> storage;
+    if(storage.size() < size)
+        storage.resize(size);
+    return storage.data();
+}
+
+euler_integrator_t::euler_integrator_t(unsigned int state_dimension)
+    : integrator_t(state_dimension)
+{
+}
+
+void euler_integrator_t::step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const
+{
+    double* stage_derivative = scratch(state_dimension);
+    derivative(state, control, stage_derivative);
+    for(unsigned int i = 0; i < state_dimension; i++)
+        state[i] += integration_step*stage_derivative[i];
+}
+
+semi_implicit_euler_integrator_t::semi_implicit_euler_integrator_t(const std::vector<bool>& is_velocity)
+    : integrator_t(is_velocity.size())
+    , is_velocity(is_velocity)
+{
+}
+
+void semi_implicit_euler_integrator_t::step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const
+{
+    double* stage_derivative = scratch(state_dimension);
+    derivative(state, control, stage_derivative);
+    for(unsigned int i = 0; i < state_dimension; i++)
+    {
+        if(is_velocity[i])
+            state[i] += integration_step*stage_derivative[i];
+    }
+    derivative(state, control, stage_derivative);
+    for(unsigned int i = 0; i < state_dimension; i++)
+    {
+        if(!is_velocity[i])
+            state[i] += integration_step*stage_derivative[i];
+    }
+}
+
+rk4_integrator_t::rk4_integrator_t(unsigned int state_dimension)
+    : integrator_t(state_dimension)
+{
+}
+
+void rk4_integrator_t::step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const
+{
+    const double stage_fraction[3] = {0.5, 0.5, 1.0};
+    const double stage_weight[3] = {2.0, 2.0, 1.0};
+    double* stage_derivative = scratch(3*state_dimension);
+    double* stage_state = stage_derivative + state_dimension;
+    double* derivative_sum = stage_state + state_dimension;
+
+    derivative(state, control, stage_derivative);
+    for(unsigned int i = 0; i < state_dimension; i++)
+        derivative_sum[i] = stage_derivative[i];
+    for(unsigned int s = 0; s < 3; s++)
+    {
+        for(unsigned int i = 0; i < state_dimension; i++)
+            stage_state[i] = state[i] + stage_fraction[s]*integration_step*stage_derivative[i];
+        derivative(stage_state, control, stage_derivative);
+        for(unsigned int i = 0; i < state_dimension; i++)
+            derivative_sum[i] += stage_weight[s]*stage_derivative[i];
+    }
+    for(unsigned int i = 0; i < state_dimension; i++)
+        state[i] += integration_step/6.0*derivative_sum[i];
+}
+
+rk45_integrator_t::rk45_integrator_t(unsigned int state_dimension, double tolerance)
+    : integrator_t(state_dimension)
+    , tolerance(tolerance)
+    , number_of_substeps(0)
+{
+}
+
+void rk45_integrator_t::step(const derivative_function_t& derivative, double* state, const double* control, double integration_step) const
+{
+    double* stages = scratch(9*state_dimension);
+    double* stage_state = stages + 7*state_dimension;
+    double* fifth_order = stage_state + state_dimension;
+
+    double remaining = integration_step;
+    double substep = integration_step;
+    unsigned int substeps = 0;
+    // The last stage of an accepted substep is the first stage of the next one
+    derivative(state, control, &stages[0]);
+    while(remaining > 0)
+    {
+        bool forced = substeps + 1 >= RK45_MAX_SUBSTEPS;
+        bool last = forced || substep >= remaining;
+        if(last)
+            substep = remaining;
+
+        for(unsigned int s = 1; s < 7; s++)
+        {
+            double* result = s == 6 ? fifth_order : stage_state;
+            for(unsigned int i = 0; i < state_dimension; i++)
+            {
+                double increment = 0;
+                for(unsigned int j = 0; j < s; j++)
+                    increment += dp_a[s][j]*stages[j*state_dimension + i];
+                result[i] = state[i] + substep*increment;
+            }
+            derivative(result, control, &stages[s*state_dimension]);
+        }
+
+        double error = 0;
+        for(unsigned int i = 0; i < state_dimension; i++)
+        {
+            double estimate = 0;
+            for(unsigned int j = 0; j < 7; j++)
+                estimate += dp_error[j]*stages[j*state_dimension + i];
+            double scale = tolerance*(1 + std::max(std::fabs(state[i]), std::fabs(fifth_order[i])));
+            error = std::max(error, std::fabs(substep*estimate)/scale);
+        }
+        substeps++;
+
+        if(error <= 1 || forced)
+        {
+            std::copy(fifth_order, fifth_order + state_dimension, state);
+            std::copy(stages + 6*state_dimension, stages + 7*state_dimension, stages);
+            remaining = last ? 0 : remaining - substep;
+        }
+        double factor = error == 0 ? 5 : 0.9*std::pow(error, -0.2);
+        substep *= std::min(5.0, std::max(0.2, factor));
+    }
+    number_of_substeps.fetch_add(substeps, std::memory_order_relaxed);
+}
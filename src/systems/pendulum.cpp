@@ -30,12 +30,15 @@
 #define MASS 1
 #define DAMPING .05
 
+#define PENDULUM_BACKWARD_ITERATIONS 20
+
 
 bool pendulum_t::propagate(
     const double* start_state, unsigned int state_dimension,
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+	double temp_state[2];
 	temp_state[0] = start_state[0]; temp_state[1] = start_state[1];
 	bool validity = true;
 	for(int i=0;i<num_steps;i++)
@@ -46,29 +49,63 @@ bool pendulum_t::propagate(
 		temp_state[1] += integration_step*
 							((control[0] - MASS * (9.81) * LENGTH * cos(temp0)*0.5 
 										 - DAMPING * temp1)* 3 / (MASS * LENGTH * LENGTH));
-		enforce_bounds();
-		validity = validity && valid_state();
+		enforce_bounds(temp_state);
+		validity = validity && valid_state(temp_state);
+	}
+	result_state[0] = temp_state[0];
+	result_state[1] = temp_state[1];
+	return validity;
+}
+
+bool pendulum_t::propagate_backward(
+    const double* end_state, unsigned int state_dimension,
+    const double* control, unsigned int control_dimension,
+    int num_steps, double* result_state, double integration_step)
+{
+	double temp_state[2];
+	temp_state[0] = end_state[0]; temp_state[1] = end_state[1];
+	bool validity = true;
+	for(int i=0;i<num_steps;i++)
+	{
+		// The forward step is implicit in the previous velocity, solve it by fixed point iteration.
+		// The iteration contracts with a factor of about integration_step^2 * 15
+		double temp0 = temp_state[0];
+		double temp1 = temp_state[1];
+		double velocity = temp1;
+		for(int j=0;j<PENDULUM_BACKWARD_ITERATIONS;j++)
+		{
+			double previous_velocity = velocity;
+			velocity = (temp1 - integration_step*
+						 ((control[0] - MASS * (9.81) * LENGTH * cos(temp0 - integration_step*velocity)*0.5)* 3 / (MASS * LENGTH * LENGTH)))
+					   / (1 - integration_step*DAMPING* 3 / (MASS * LENGTH * LENGTH));
+			if(fabs(velocity - previous_velocity) < 1e-12)
+				break;
+		}
+		temp_state[0] = temp0 - integration_step*velocity;
+		temp_state[1] = velocity;
+		enforce_bounds(temp_state);
+		validity = validity && valid_state(temp_state);
 	}
 	result_state[0] = temp_state[0];
 	result_state[1] = temp_state[1];
 	return validity;
 }
 
-void pendulum_t::enforce_bounds()
+void pendulum_t::enforce_bounds(double* state) const
 {
-	if(temp_state[0]<-M_PI)
-		temp_state[0]+=2*M_PI;
-	else if(temp_state[0]>M_PI)
-		temp_state[0]-=2*M_PI;
-
-	if(temp_state[1]<MIN_W)
-		temp_state[1]=MIN_W;
-	else if(temp_state[1]>MAX_W)
-		temp_state[1]=MAX_W;
+	if(state[0]<-M_PI)
+		state[0]+=2*M_PI;
+	else if(state[0]>M_PI)
+		state[0]-=2*M_PI;
+
+	if(state[1]<MIN_W)
+		state[1]=MIN_W;
+	else if(state[1]>MAX_W)
+		state[1]=MAX_W;
 }
 
 
-bool pendulum_t::valid_state()
+bool pendulum_t::valid_state(const double* state) const
 {
 	return true;
 }
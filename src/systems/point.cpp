@@ -16,6 +16,7 @@
 #include "utilities/random.hpp"
 #include "image_creation/svg_image.hpp"
 #include <cmath>
+#include <algorithm>
 #include <assert.h>
 
 #define MIN_X -10
@@ -34,6 +35,7 @@ bool point_t::propagate(
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+	double temp_state[2];
 	temp_state[0] = start_state[0];
 	temp_state[1] = start_state[1];
 	bool validity = true;
@@ -41,48 +43,84 @@ bool point_t::propagate(
 	{
 		temp_state[0] += integration_step*control[0]*cos(control[1]);
 		temp_state[1] += integration_step*control[0]*sin(control[1]);
-		enforce_bounds();
-		validity = validity && valid_state();
+		enforce_bounds(temp_state);
+		validity = validity && valid_state(temp_state);
 	}
 	result_state[0] = temp_state[0];
 	result_state[1] = temp_state[1];
 	return validity;
 }
 
-void point_t::enforce_bounds()
+bool point_t::propagate_backward(
+    const double* end_state, unsigned int state_dimension,
+    const double* control, unsigned int control_dimension,
+    int num_steps, double* result_state, double integration_step)
+{
+	double temp_state[2];
+	temp_state[0] = end_state[0];
+	temp_state[1] = end_state[1];
+	bool validity = true;
+	for(int i=0;i<num_steps;i++)
+	{
+		temp_state[0] -= integration_step*control[0]*cos(control[1]);
+		temp_state[1] -= integration_step*control[0]*sin(control[1]);
+		enforce_bounds(temp_state);
+		validity = validity && valid_state(temp_state);
+	}
+	result_state[0] = temp_state[0];
+	result_state[1] = temp_state[1];
+	return validity;
+}
+
+bool point_t::steer(
+    const double* start_state, const double* goal_state, unsigned int state_dimension,
+    double* control, unsigned int control_dimension,
+    int& num_steps, double integration_step)
+{
+	// Straight line at the highest speed that covers the distance in a whole number of steps
+	double dx = goal_state[0] - start_state[0];
+	double dy = goal_state[1] - start_state[1];
+	double distance = sqrt(dx*dx + dy*dy);
+	num_steps = std::max(1, (int)ceil(distance/(MAX_V*integration_step)));
+	control[0] = distance/(num_steps*integration_step);
+	control[1] = atan2(dy, dx);
+	return true;
+}
+
+void point_t::enforce_bounds(double* state) const
 {
-	if(temp_state[0]<MIN_X)
-		temp_state[0]=MIN_X;
-	else if(temp_state[0]>MAX_X)
-		temp_state[0]=MAX_X;
-
-	if(temp_state[1]<MIN_Y)
-		temp_state[1]=MIN_Y;
-	else if(temp_state[1]>MAX_Y)
-		temp_state[1]=MAX_Y;
+	if(state[0]<MIN_X)
+		state[0]=MIN_X;
+	else if(state[0]>MAX_X)
+		state[0]=MAX_X;
+
+	if(state[1]<MIN_Y)
+		state[1]=MIN_Y;
+	else if(state[1]>MAX_Y)
+		state[1]=MAX_Y;
 }
 
 
-bool point_t::valid_state()
+bool point_t::valid_state(const double* state) const
 {
 	bool obstacle_collision = false;
 	//any obstacles need to be checked here
 	for(unsigned i=0;i<obstacles.size() && !obstacle_collision;i++)
 	{
-		if(	temp_state[0]>obstacles[i].low_x && 
-			temp_state[0]<obstacles[i].high_x && 
-			temp_state[1]>obstacles[i].low_y && 
-			temp_state[1]<obstacles[i].high_y)
+		if(	state[0]>obstacles[i].low_x && 
+			state[0]<obstacles[i].high_x && 
+			state[1]>obstacles[i].low_y && 
+			state[1]<obstacles[i].high_y)
 		{
 			obstacle_collision = true;
 		}
 	}
 
 	return !obstacle_collision && 
-			(temp_state[0]!=MIN_X) &&
-			(temp_state[0]!=MAX_X) &&
-			(temp_state[1]!=MIN_Y) &&
-			(temp_state[1]!=MAX_Y);
+			(state[0]!=MIN_X) &&
+			(state[0]!=MAX_X) &&
+			(state[1]!=MIN_Y) &&
+			(state[1]!=MAX_Y);
 }
 
 std::tuple<double, double> point_t::visualize_point(const double* state, unsigned int state_dimension) const
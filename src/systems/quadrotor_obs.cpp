@@ -11,6 +11,7 @@
  */
 
 #include "systems/quadrotor_obs.hpp"
+#include "systems/batch_propagation.hpp"
 #include <iostream>
 #define _USE_MATH_DEFINES
 #include <cmath>
@@ -37,7 +38,63 @@
 #define MIN_C -1
 #define MAX_C 1.
 
-void quadrotor_obs_t::enforce_bounds_SO3(double *qstate){
+namespace
+{
+    /**
+     * @brief One integration step of quadrotor_obs_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(quadrotor_obs_t& system, const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The normalization of quaternions branches, it is done per lane
+        batch_lanes_t qomega[4];
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double omega[4] = {.5 * state[10][lane], .5 * state[11][lane], .5 * state[12][lane], 0};
+            system.enforce_bounds_SO3(omega);
+            for(int qi = 0; qi < 4; qi++){
+                qomega[qi][lane] = omega[qi];
+            }
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double u[4];
+            u[0] = control[0][lane] > MAX_C1 ? MAX_C1 : (control[0][lane] < MIN_C1 ? MIN_C1 : control[0][lane]);
+            for(int i_u = 1; i_u < 4; i_u++){
+                u[i_u] = control[i_u][lane] > MAX_C ? MAX_C : (control[i_u][lane] < MIN_C ? MIN_C : control[i_u][lane]);
+            }
+            double delta = state[3][lane] * qomega[0][lane] + state[4][lane] * qomega[1][lane] + state[5][lane] * qomega[2][lane];
+            double deriv[13];
+            deriv[0] = state[7][lane];
+            deriv[1] = state[8][lane];
+            deriv[2] = state[9][lane];
+            for(int qi = 0; qi < 4; qi++){
+                deriv[3 + qi] = qomega[qi][lane] - delta * state[3 + qi][lane];
+            }
+            deriv[7] = MASS_INV * (-2*u[0]*(state[6][lane]*state[4][lane] + state[3][lane]*state[5][lane]) - BETA * state[7][lane]);
+            deriv[8] = MASS_INV * (-2*u[0]*(state[4][lane]*state[5][lane] - state[6][lane]*state[3][lane]) - BETA * state[8][lane]);
+            deriv[9] = MASS_INV * (-u[0]*(state[6][lane]*state[6][lane]-state[3][lane]*state[3][lane]-state[4][lane]*state[4][lane]+state[5][lane]*state[5][lane]) - BETA * state[9][lane]) - 9.81;
+            deriv[10] = u[1];
+            deriv[11] = u[2];
+            deriv[12] = u[3];
+            for(int si = 0; si < 13; si++){
+                next[si][lane] = state[si][lane] + deriv[si] * integration_step;
+            }
+            for(int si = 7; si < 13; si++){
+                next[si][lane] = next[si][lane] < MIN_V ? MIN_V : (next[si][lane] > MAX_V ? MAX_V : next[si][lane]);
+            }
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double quaternion[4] = {next[3][lane], next[4][lane], next[5][lane], next[6][lane]};
+            system.enforce_bounds_SO3(quaternion);
+            for(int qi = 0; qi < 4; qi++){
+                next[3 + qi][lane] = quaternion[qi];
+            }
+        }
+    }
+}
+
+void quadrotor_obs_t::enforce_bounds_SO3(double *qstate) const{
     //https://ompl.kavrakilab.org/SO3StateSpace_8cpp_source.html#l00183
     double nrmSqr = qstate[0]*qstate[0] + qstate[1]*qstate[1] + qstate[2]*qstate[2] + qstate[3]*qstate[3];
     double nrmsq = (std::fabs(nrmSqr - 1.0) > std::numeric_limits<double>::epsilon()) ? std::sqrt(nrmSqr) : 1.0;
@@ -68,18 +125,20 @@ bool quadrotor_obs_t::propagate(
 		const double* start_state, unsigned int state_dimension,
         const double* control, unsigned int control_dimension,
 	    int num_steps, double* result_state, double integration_step){
+    double temp_state[13];
+    double deriv[13];
     for(int si = 0; si < state_dimension; si++){
         temp_state[si] = start_state[si];
     }
-    validity = true;
+    bool validity = true;
     for(int t = 0; t < num_steps; t++)
     {
-        update_derivative(control);
+        update_derivative(temp_state, control, deriv);
         for(int si = 0; si < state_dimension; si++){
             temp_state[si] += deriv[si] * integration_step;
         }
-        enforce_bounds();
-        validity = validity && valid_state();
+        enforce_bounds(temp_state);
+        validity = validity && valid_state(temp_state);
         if(validity){
             for(int si = 0; si < state_dimension; si++){
                 result_state[si] = temp_state[si];
@@ -92,7 +151,27 @@ bool quadrotor_obs_t::propagate(
     return validity;
 }
 
-bool quadrotor_obs_t::valid_state(){
+void quadrotor_obs_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step){
+    // Collisions are checked per lane on a copy of the lane state
+    propagate_lanes<13, 4, true>(
+        [this](const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next){
+            integrate_lanes(*this, state, control, integration_step, next);
+        },
+        [this](const batch_lanes_t* state, unsigned int lane){
+            double lane_state[13];
+            for(int si = 0; si < 13; si++){
+                lane_state[si] = state[si][lane];
+            }
+            return valid_state(lane_state);
+        },
+        true, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+bool quadrotor_obs_t::valid_state(const double* state) const{
      /** Quaternion to rotation matrix
      *  https://www.mathworks.com/help/fusion/ref/quaternion.rotmat.html    
      * also check 
@@ -101,15 +180,15 @@ bool quadrotor_obs_t::valid_state(){
      * Key points on frames
      */
     for(int si = 0; si < 3; si++){
-        if(temp_state[si] > MAX_X || temp_state[si] < MIN_X){
+        if(state[si] > MAX_X || state[si] < MIN_X){
             return false;
         }
     }
 
-    double a = temp_state[6],
-           b = temp_state[3],
-           c = temp_state[4],
-           d = temp_state[5];
+    double a = state[6],
+           b = state[3],
+           c = state[4],
+           d = state[5];
     std::vector<double> min_max = {MAX_X * 10, // min_x
                                    MIN_X * 10, // max_x
                                    MAX_X * 10, // min_y
@@ -120,7 +199,7 @@ bool quadrotor_obs_t::valid_state(){
         double x = (2 * a * a - 1 + 2 * b * b) * frame.at(f_i).at(0) +
                    (2 * b * c + 2 * a * d) * frame.at(f_i).at(1) +
                    (2 * b * d - 2 * a * c) * frame.at(f_i).at(2) +
-                   /*world frame*/temp_state[0];
+                   /*world frame*/state[0];
         // printf("%f, %f, %f\n", min_max.at(1), x, std::numeric_limits<double>::max());
         if(x < min_max.at(0)) {
             min_max.at(0) = x;
@@ -131,7 +210,7 @@ bool quadrotor_obs_t::valid_state(){
         double y = (2 * b * c - 2 * a * d) * frame.at(f_i).at(0) +
                    (2 * a * a - 1 + 2 * c * c) * frame.at(f_i).at(1) +
                    (2 * c * d + 2 * a * b) * frame.at(f_i).at(2) +
-                   /*world frame*/temp_state[1];
+                   /*world frame*/state[1];
 
         if(y < min_max.at(2)) {
             min_max.at(2) = y;
@@ -142,7 +221,7 @@ bool quadrotor_obs_t::valid_state(){
         double z = (2 * b * d  + 2 * a * c) * frame.at(f_i).at(0) +
                    (2 * c * d  - 2 * a * b) * frame.at(f_i).at(1) +
                    (2 * a * a - 1 + 2 * d * d) * frame.at(f_i).at(2) +
-                   /*world frame*/temp_state[2];
+                   /*world frame*/state[2];
         if(z < min_max.at(4)) {
             min_max.at(4) = z;
         } else if (z > min_max.at(5)) {
@@ -158,40 +237,34 @@ bool quadrotor_obs_t::valid_state(){
      *          (a.minZ <= b.maxZ && a.maxZ >= b.minZ);
      * }
      */
-    bool current_validity = true;
-    for(unsigned int oi = 0; oi < obs_min_max.size(); oi++){
-        // printf("%f,%f,%f,%f;;;;",  min_max.at(0), min_max.at(1), obs_min_max.at(oi).at(0), obs_min_max.at(oi).at(1));
-        // printf("%d, %d; %d, %d; %d, %d\n", 
-        //     min_max.at(0) <= obs_min_max.at(oi).at(1), min_max.at(1) >= obs_min_max.at(oi).at(0),
-        //     min_max.at(2) <= obs_min_max.at(oi).at(3), min_max.at(3) >= obs_min_max.at(oi).at(2),
-        //     min_max.at(4) <= obs_min_max.at(oi).at(5), min_max.at(5) >= obs_min_max.at(oi).at(4));
-        if(((min_max.at(0) <= obs_min_max.at(oi).at(1) && min_max.at(1) >= obs_min_max.at(oi).at(0)) &&
-             (min_max.at(2) <= obs_min_max.at(oi).at(3) && min_max.at(3) >= obs_min_max.at(oi).at(2)) &&
-             (min_max.at(4) <= obs_min_max.at(oi).at(5) && min_max.at(5) >= obs_min_max.at(oi).at(4)))){
-                 current_validity = false;
-                 break;
-           }
-    }
+    // only the obstacles in the cells of the bounding box are tested
+    bool current_validity = !obstacle_grid.any_near(min_max.data(), [&](unsigned int oi){
+        return ((min_max.at(0) <= obs_min_max.at(oi).at(1) && min_max.at(1) >= obs_min_max.at(oi).at(0)) &&
+                (min_max.at(2) <= obs_min_max.at(oi).at(3) && min_max.at(3) >= obs_min_max.at(oi).at(2)) &&
+                (min_max.at(4) <= obs_min_max.at(oi).at(5) && min_max.at(5) >= obs_min_max.at(oi).at(4)));
+    });
     return current_validity;
 }
 
-void quadrotor_obs_t::enforce_bounds(){
+void quadrotor_obs_t::enforce_bounds(double* state) const{
     // for R^3
     // for quaternion
-    enforce_bounds_SO3(&temp_state[3]);
+    enforce_bounds_SO3(&state[3]);
     // for v and w
     for(int si = 7; si < state_dimension; si++){
-        if(temp_state[si] < MIN_V){
-        temp_state[si] = MIN_V;
-        }else if(temp_state[si] > MAX_V){
-            temp_state[si] = MAX_V;
+        if(state[si] < MIN_V){
+        state[si] = MIN_V;
+        }else if(state[si] > MAX_V){
+            state[si] = MAX_V;
         }
     }
 
 };
 
-void quadrotor_obs_t::update_derivative(const double* control){
+void quadrotor_obs_t::update_derivative(const double* state, const double* control, double* derivative) const{
     //https://ompl.kavrakilab.org/src_2omplapp_2apps_2QuadrotorPlanning_8cpp_source.html
+    double u[4];
+    double qomega[4];
     // enforce control
     if(control[0] > MAX_C1){
         u[0] = MAX_C1;
@@ -210,28 +283,28 @@ void quadrotor_obs_t::update_derivative(const double* control){
         }
     }
     // dx/dt = v
-    deriv[0] = temp_state[7];
-    deriv[1] = temp_state[8];
-    deriv[2] = temp_state[9];
-    qomega[0] = .5 * temp_state[10];
-    qomega[1] = .5 * temp_state[11];
-    qomega[2] = .5 * temp_state[12];
+    derivative[0] = state[7];
+    derivative[1] = state[8];
+    derivative[2] = state[9];
+    qomega[0] = .5 * state[10];
+    qomega[1] = .5 * state[11];
+    qomega[2] = .5 * state[12];
     qomega[3] = 0;
     enforce_bounds_SO3(qomega);
-    double delta = temp_state[3] * qomega[0] + temp_state[4] * qomega[1] + temp_state[5] * qomega[2];
+    double delta = state[3] * qomega[0] + state[4] * qomega[1] + state[5] * qomega[2];
     // d theta / dt = omega
-    deriv[3] = qomega[0] - delta * temp_state[3];
-    deriv[4] = qomega[1] - delta * temp_state[4];
-    deriv[5] = qomega[2] - delta * temp_state[5];
-    deriv[6] = qomega[3] - delta * temp_state[6];
+    derivative[3] = qomega[0] - delta * state[3];
+    derivative[4] = qomega[1] - delta * state[4];
+    derivative[5] = qomega[2] - delta * state[5];
+    derivative[6] = qomega[3] - delta * state[6];
     // d v / dt = a 
-    deriv[7] = MASS_INV * (-2*u[0]*(temp_state[6]*temp_state[4] + temp_state[3]*temp_state[5]) - BETA * temp_state[7]);
-    deriv[8] = MASS_INV * (-2*u[0]*(temp_state[4]*temp_state[5] - temp_state[6]*temp_state[3]) - BETA * temp_state[8]);
-    deriv[9] = MASS_INV * (-u[0]*(temp_state[6]*temp_state[6]-temp_state[3]*temp_state[3]-temp_state[4]*temp_state[4]+temp_state[5]*temp_state[5]) - BETA * temp_state[9]) - 9.81;
+    derivative[7] = MASS_INV * (-2*u[0]*(state[6]*state[4] + state[3]*state[5]) - BETA * state[7]);
+    derivative[8] = MASS_INV * (-2*u[0]*(state[4]*state[5] - state[6]*state[3]) - BETA * state[8]);
+    derivative[9] = MASS_INV * (-u[0]*(state[6]*state[6]-state[3]*state[3]-state[4]*state[4]+state[5]*state[5]) - BETA * state[9]) - 9.81;
     // d omega / dt = alpha
-    deriv[10] = u[1];
-    deriv[11] = u[2];
-    deriv[12] = u[3];
+    derivative[10] = u[1];
+    derivative[11] = u[2];
+    derivative[12] = u[3];
 
 };
 
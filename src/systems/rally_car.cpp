@@ -84,6 +84,8 @@ bool rally_car_t::propagate(
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+        double temp_state[8];
+        double deriv[8];
         temp_state[0] = start_state[0]; 
         temp_state[1] = start_state[1];
         temp_state[2] = start_state[2];
@@ -95,17 +97,24 @@ bool rally_car_t::propagate(
         bool validity = true;
         for(int i=0;i<num_steps;i++)
         {
-                update_derivative(control);
-                temp_state[0] += integration_step*deriv[0];
-                temp_state[1] += integration_step*deriv[1];
-                temp_state[2] += integration_step*deriv[2];
-                temp_state[3] += integration_step*deriv[3];
-                temp_state[4] += integration_step*deriv[4];
-                temp_state[5] += integration_step*deriv[5];
-                temp_state[6] += integration_step*deriv[6];
-                temp_state[7] += integration_step*deriv[7];
-                enforce_bounds();
-                validity = validity && valid_state();
+                if(integrator)
+                {
+                        integrate(temp_state, control, integration_step);
+                }
+                else
+                {
+                        update_derivative(temp_state, control, deriv);
+                        temp_state[0] += integration_step*deriv[0];
+                        temp_state[1] += integration_step*deriv[1];
+                        temp_state[2] += integration_step*deriv[2];
+                        temp_state[3] += integration_step*deriv[3];
+                        temp_state[4] += integration_step*deriv[4];
+                        temp_state[5] += integration_step*deriv[5];
+                        temp_state[6] += integration_step*deriv[6];
+                        temp_state[7] += integration_step*deriv[7];
+                }
+                enforce_bounds(temp_state);
+                validity = validity && valid_state(temp_state);
         }
         result_state[0] = temp_state[0];
         result_state[1] = temp_state[1];
@@ -118,64 +127,64 @@ bool rally_car_t::propagate(
         return validity;
 }
 
-void rally_car_t::enforce_bounds()
+void rally_car_t::enforce_bounds(double* state) const
 {
 // #x y xdot ydot theta thetadot wf wr
 // state_space: 
 //   min: [-25, -40, -18, -18, -3.14, -17, -40, -40]
 //   max: [25, 25, 18, 18, 3.14, 17, 40, 40]
-        if(temp_state[0]<MIN_X)
-                temp_state[0]=MIN_X;
-        else if(temp_state[0]>MAX_X)
-                temp_state[0]=MAX_X;
-
-        if(temp_state[1]<MIN_Y)
-                temp_state[1]=MIN_Y;
-        else if(temp_state[1]>MAX_Y)
-                temp_state[1]=MAX_Y;
-
-        if(temp_state[2]<-18)
-                temp_state[2]=-18;
-        else if(temp_state[2]>18)
-                temp_state[2]=18;
-
-        if(temp_state[3]<-18)
-                temp_state[3]=-18;
-        else if(temp_state[3]>18)
-                temp_state[3]=18;
-
-        if(temp_state[4]<-M_PI)
-                temp_state[4]+=2*M_PI;
-        else if(temp_state[4]>M_PI)
-                temp_state[4]-=2*M_PI;
-
-        if(temp_state[5]<-17)
-                temp_state[5]=-17;
-        else if(temp_state[5]>17)
-                temp_state[5]=17;
-
-        if(temp_state[6]<-40)
-                temp_state[6]=-40;
-        else if(temp_state[6]>40)
-                temp_state[6]=40;
-
-        if(temp_state[7]<-40)
-                temp_state[7]=-40;
-        else if(temp_state[7]>40)
-                temp_state[7]=40;
+        if(state[0]<MIN_X)
+                state[0]=MIN_X;
+        else if(state[0]>MAX_X)
+                state[0]=MAX_X;
+
+        if(state[1]<MIN_Y)
+                state[1]=MIN_Y;
+        else if(state[1]>MAX_Y)
+                state[1]=MAX_Y;
+
+        if(state[2]<-18)
+                state[2]=-18;
+        else if(state[2]>18)
+                state[2]=18;
+
+        if(state[3]<-18)
+                state[3]=-18;
+        else if(state[3]>18)
+                state[3]=18;
+
+        if(state[4]<-M_PI)
+                state[4]+=2*M_PI;
+        else if(state[4]>M_PI)
+                state[4]-=2*M_PI;
+
+        if(state[5]<-17)
+                state[5]=-17;
+        else if(state[5]>17)
+                state[5]=17;
+
+        if(state[6]<-40)
+                state[6]=-40;
+        else if(state[6]>40)
+                state[6]=40;
+
+        if(state[7]<-40)
+                state[7]=-40;
+        else if(state[7]>40)
+                state[7]=40;
 }
 
 
-bool rally_car_t::valid_state()
+bool rally_car_t::valid_state(const double* state) const
 {
         bool obstacle_collision = false;
         //any obstacles need to be checked here
         for(unsigned i=0;i<obstacles.size() && !obstacle_collision;i++)
         {
-                if(     temp_state[0]>obstacles[i].low_x-1 && 
-                        temp_state[0]<obstacles[i].high_x+1 && 
-                        temp_state[1]>obstacles[i].low_y-1 && 
-                        temp_state[1]<obstacles[i].high_y+1)
+                if(     state[0]>obstacles[i].low_x-1 && 
+                        state[0]<obstacles[i].high_x+1 && 
+                        state[1]>obstacles[i].low_y-1 && 
+                        state[1]<obstacles[i].high_y+1)
                 {
                         obstacle_collision = true;
                 }
@@ -190,22 +199,22 @@ std::tuple<double, double> rally_car_t::visualize_point(const double* state, uns
         return std::make_tuple(x, y);
 }
 
-void rally_car_t::update_derivative(const double* control)
+void rally_car_t::update_derivative(const double* state, const double* control, double* derivative) const
 {
-        double _vx = temp_state[2];
-        double _vy = temp_state[3];
-        double _theta = temp_state[4];
-        double _thetadot = temp_state[5];
-        double _wf = temp_state[6];
-        double _wr = temp_state[7];
+        double _vx = state[2];
+        double _vy = state[3];
+        double _theta = state[4];
+        double _thetadot = state[5];
+        double _wf = state[6];
+        double _wr = state[7];
 
         double _sta = control[0];
         double _tf = control[0];
         double _tr = control[0];
 
-        deriv[STATE_X] = _vx;
-        deriv[STATE_Y] = _vy;
-        deriv[STATE_THETA] = _thetadot;
+        derivative[STATE_X] = _vx;
+        derivative[STATE_Y] = _vy;
+        derivative[STATE_THETA] = _thetadot;
 
         double V = sqrt(_vx*_vx+_vy*_vy);
         double beta = atan2(_vy,_vx) - _theta;
@@ -253,11 +262,11 @@ void rally_car_t::update_derivative(const double* control)
         double fRx = mu_Rx * fRz;
         double fRy = mu_Ry * fRz;;
 
-        deriv[STATE_VX] = (fFx*cos(_theta+_sta)-fFy*sin(_theta+_sta)+fRx*cos(_theta)-fRy*sin(_theta) )/M;
-        deriv[STATE_VY] = (fFx*sin(_theta+_sta)+fFy*cos(_theta+_sta)+fRx*sin(_theta)+fRy*cos(_theta) )/M;
-        deriv[STATE_THETADOT] = ((fFy*cos(_sta)+fFx*sin(_sta))*LF - fRy*LR)/IZ;
-        deriv[STATE_WF] = (_tf-fFx*R)/IF;
-        deriv[STATE_WR] = (_tr-fRx*R)/IR;
+        derivative[STATE_VX] = (fFx*cos(_theta+_sta)-fFy*sin(_theta+_sta)+fRx*cos(_theta)-fRy*sin(_theta) )/M;
+        derivative[STATE_VY] = (fFx*sin(_theta+_sta)+fFy*cos(_theta+_sta)+fRx*sin(_theta)+fRy*cos(_theta) )/M;
+        derivative[STATE_THETADOT] = ((fFy*cos(_sta)+fFx*sin(_sta))*LF - fRy*LR)/IZ;
+        derivative[STATE_WF] = (_tf-fFx*R)/IF;
+        derivative[STATE_WR] = (_tr-fRx*R)/IR;
 }
 
 std::string rally_car_t::visualize_obstacles(int image_width, int image_height) const
@@ -316,3 +325,17 @@ std::vector<bool> rally_car_t::is_circular_topology() const {
 }
 
 
+std::vector<bool> rally_car_t::is_velocity() const {
+    return {
+            false,
+            false,
+            true,
+            true,
+            false,
+            true,
+            true,
+            true
+    };
+}
+
+
@@ -14,6 +14,7 @@
 
 
 #include "systems/two_link_acrobot.hpp"
+#include "systems/batch_propagation.hpp"
 
 
 #define _USE_MATH_DEFINES
@@ -47,6 +48,58 @@
 #define MIN_T -4
 #define MAX_T 4
 
+namespace
+{
+    /**
+     * @brief One integration step of two_link_acrobot_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The trigonometric functions are evaluated per lane, the rest of the step is vectorized
+        batch_lanes_t sin_theta2, cos_theta2, cos_theta1, cos_theta12;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double theta2 = state[STATE_THETA_2][lane];
+            double theta1 = state[STATE_THETA_1][lane] - M_PI / 2;
+            sin_theta2[lane] = sin(theta2);
+            cos_theta2[lane] = cos(theta2);
+            cos_theta1[lane] = cos(theta1);
+            cos_theta12[lane] = cos(theta1 + theta2);
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double theta1dot = state[STATE_V_1][lane];
+            double theta2dot = state[STATE_V_2][lane];
+            double _tau = control[CONTROL_T][lane];
+
+            double d11 = m * lc2 + m * (l2 + lc2 + 2 * l * lc * cos_theta2[lane]) + I1 + I2;
+            double d22 = m * lc2 + I2;
+            double d12 = m * (lc2 + l * lc * cos_theta2[lane]) + I2;
+            double d21 = d12;
+
+            double c1 = -m * l * lc * theta2dot * theta2dot * sin_theta2[lane] - (2 * m * l * lc * theta1dot * theta2dot * sin_theta2[lane]);
+            double c2 = m * l * lc * theta1dot * theta1dot * sin_theta2[lane];
+            double g1 = (m * lc + m * l) * g * cos_theta1[lane] + (m * lc * g * cos_theta12[lane]);
+            double g2 = m * lc * g * cos_theta12[lane];
+
+            double u2 = _tau - 1 * .1 * theta2dot;
+            double u1 = -1 * .1 * theta1dot;
+            double theta1dot_dot = (d22 * (u1 - c1 - g1) - d12 * (u2 - c2 - g2)) / (d11 * d22 - d12 * d21);
+            double theta2dot_dot = (d11 * (u2 - c2 - g2) - d21 * (u1 - c1 - g1)) / (d11 * d22 - d12 * d21);
+
+            double theta_1 = state[STATE_THETA_1][lane] + integration_step*theta1dot;
+            double theta_2 = state[STATE_THETA_2][lane] + integration_step*theta2dot;
+            double v_1 = state[STATE_V_1][lane] + integration_step*theta1dot_dot;
+            double v_2 = state[STATE_V_2][lane] + integration_step*theta2dot_dot;
+
+            next[STATE_THETA_1][lane] = theta_1 < -M_PI ? theta_1 + 2*M_PI : (theta_1 > M_PI ? theta_1 - 2*M_PI : theta_1);
+            next[STATE_THETA_2][lane] = theta_2 < -M_PI ? theta_2 + 2*M_PI : (theta_2 > M_PI ? theta_2 - 2*M_PI : theta_2);
+            next[STATE_V_1][lane] = v_1 < MIN_V_1 ? MIN_V_1 : (v_1 > MAX_V_1 ? MAX_V_1 : v_1);
+            next[STATE_V_2][lane] = v_2 < MIN_V_2 ? MIN_V_2 : (v_2 > MAX_V_2 ? MAX_V_2 : v_2);
+        }
+    }
+}
+
 double two_link_acrobot_t::distance(const double* point1, const double* point2, unsigned int state_dimension)
 {
         double x = (LENGTH) * cos(point1[STATE_THETA_1] - M_PI / 2)+(LENGTH) * cos(point1[STATE_THETA_1] + point1[STATE_THETA_2] - M_PI / 2);
@@ -61,6 +114,8 @@ bool two_link_acrobot_t::propagate(
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+        double temp_state[4];
+        double deriv[4];
         temp_state[0] = start_state[0]; 
         temp_state[1] = start_state[1];
         temp_state[2] = start_state[2];
@@ -68,13 +123,20 @@ bool two_link_acrobot_t::propagate(
         bool validity = true;
         for(int i=0;i<num_steps;i++)
         {
-                update_derivative(control);
-                temp_state[0] += integration_step*deriv[0];
-                temp_state[1] += integration_step*deriv[1];
-                temp_state[2] += integration_step*deriv[2];
-                temp_state[3] += integration_step*deriv[3];
-                enforce_bounds();
-                validity = validity && valid_state();
+                if(integrator)
+                {
+                        integrate(temp_state, control, integration_step);
+                }
+                else
+                {
+                        update_derivative(temp_state, control, deriv);
+                        temp_state[0] += integration_step*deriv[0];
+                        temp_state[1] += integration_step*deriv[1];
+                        temp_state[2] += integration_step*deriv[2];
+                        temp_state[3] += integration_step*deriv[3];
+                }
+                enforce_bounds(temp_state);
+                validity = validity && valid_state(temp_state);
         }
         result_state[0] = temp_state[0];
         result_state[1] = temp_state[1];
@@ -83,29 +145,48 @@ bool two_link_acrobot_t::propagate(
         return validity;
 }
 
-void two_link_acrobot_t::enforce_bounds()
+void two_link_acrobot_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step)
+{
+        if(integrator)
+        {
+                // Other integrators than explicit Euler are not vectorized
+                system_interface::propagate_batch(start_states, state_dimension, controls, control_dimension,
+                                                  num_steps, number_of_states, result_states, valid, integration_step);
+                return;
+        }
+        propagate_lanes<4, 1, false>(
+            integrate_lanes,
+            [](const batch_lanes_t*, unsigned int) { return true; },
+            true, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+void two_link_acrobot_t::enforce_bounds(double* state) const
 {
 
-    if(temp_state[0]<-M_PI)
-            temp_state[0]+=2*M_PI;
-    else if(temp_state[0]>M_PI)
-            temp_state[0]-=2*M_PI;
-    if(temp_state[1]<-M_PI)
-            temp_state[1]+=2*M_PI;
-    else if(temp_state[1]>M_PI)
-            temp_state[1]-=2*M_PI;
-    if(temp_state[2]<MIN_V_1)
-            temp_state[2]=MIN_V_1;
-    else if(temp_state[2]>MAX_V_1)
-            temp_state[2]=MAX_V_1;
-    if(temp_state[3]<MIN_V_2)
-            temp_state[3]=MIN_V_2;
-    else if(temp_state[3]>MAX_V_2)
-            temp_state[3]=MAX_V_2;
+    if(state[0]<-M_PI)
+            state[0]+=2*M_PI;
+    else if(state[0]>M_PI)
+            state[0]-=2*M_PI;
+    if(state[1]<-M_PI)
+            state[1]+=2*M_PI;
+    else if(state[1]>M_PI)
+            state[1]-=2*M_PI;
+    if(state[2]<MIN_V_1)
+            state[2]=MIN_V_1;
+    else if(state[2]>MAX_V_1)
+            state[2]=MAX_V_1;
+    if(state[3]<MIN_V_2)
+            state[3]=MIN_V_2;
+    else if(state[3]>MAX_V_2)
+            state[3]=MAX_V_2;
 }
 
 
-bool two_link_acrobot_t::valid_state()
+bool two_link_acrobot_t::valid_state(const double* state) const
 {
     return true;
 }
@@ -119,12 +200,12 @@ std::tuple<double, double> two_link_acrobot_t::visualize_point(const double* sta
     return std::make_tuple(x, y);
 }
 
-void two_link_acrobot_t::update_derivative(const double* control)
+void two_link_acrobot_t::update_derivative(const double* state, const double* control, double* derivative) const
 {
-    double theta2 = temp_state[STATE_THETA_2];
-    double theta1 = temp_state[STATE_THETA_1] - M_PI / 2;
-    double theta1dot = temp_state[STATE_V_1];
-    double theta2dot = temp_state[STATE_V_2];
+    double theta2 = state[STATE_THETA_2];
+    double theta1 = state[STATE_THETA_1] - M_PI / 2;
+    double theta1dot = state[STATE_V_1];
+    double theta2dot = state[STATE_V_2];
     double _tau = control[CONTROL_T];
 
     //extra term m*lc2
@@ -140,16 +221,16 @@ void two_link_acrobot_t::update_derivative(const double* control)
     double g1 = (m * lc + m * l) * g * cos(theta1) + (m * lc * g * cos(theta1 + theta2));
     double g2 = m * lc * g * cos(theta1 + theta2);
 
-    deriv[STATE_THETA_1] = theta1dot;
-    deriv[STATE_THETA_2] = theta2dot;
+    derivative[STATE_THETA_1] = theta1dot;
+    derivative[STATE_THETA_2] = theta2dot;
 
     double u2 = _tau - 1 * .1 * theta2dot;
     double u1 = -1 * .1 * theta1dot;
     double theta1dot_dot = (d22 * (u1 - c1 - g1) - d12 * (u2 - c2 - g2)) / (d11 * d22 - d12 * d21);
     double theta2dot_dot = (d11 * (u2 - c2 - g2) - d21 * (u1 - c1 - g1)) / (d11 * d22 - d12 * d21);
 
-    deriv[STATE_V_1] = theta1dot_dot;
-    deriv[STATE_V_2] = theta2dot_dot;
+    derivative[STATE_V_1] = theta1dot_dot;
+    derivative[STATE_V_2] = theta2dot_dot;
 }
 
 
@@ -177,3 +258,13 @@ std::vector<bool> two_link_acrobot_t::is_circular_topology() const{
             false
     };
 }
+
+
+std::vector<bool> two_link_acrobot_t::is_velocity() const {
+    return {
+            false,
+            false,
+            true,
+            true
+    };
+}
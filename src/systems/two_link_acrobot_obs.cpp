@@ -14,6 +14,8 @@
 
 
 #include "systems/two_link_acrobot_obs.hpp"
+#include "systems/batch_propagation.hpp"
+#include "systems/swept_collision.hpp"
 
 
 #define _USE_MATH_DEFINES
@@ -47,6 +49,81 @@
 #define MIN_T -4
 #define MAX_T 4
 
+namespace
+{
+    /**
+     * @brief Angular accelerations of the links, from the trigonometric terms of the link angles.
+     */
+    inline void link_accelerations(
+        double sin_theta1, double sin_theta2, double cos_theta2, double sin_theta12,
+        double theta1dot, double theta2dot, double _tau,
+        double& theta1dot_dot, double& theta2dot_dot)
+    {
+        //extra term m*lc2
+        double d11 = m * lc2 + m * (l2 + lc2 + 2 * l * lc * cos_theta2) + I1 + I2;
+
+        double d22 = m * lc2 + I2;
+        double d12 = m * (lc2 + l * lc * cos_theta2) + I2;
+        double d21 = d12;
+
+        //extra theta1dot
+        double c1 = -m * l * lc * theta2dot * theta2dot * sin_theta2 - (2 * m * l * lc * theta1dot * theta2dot * sin_theta2);
+        double c2 = m * l * lc * theta1dot * theta1dot * sin_theta2;
+        // cos(theta1 - pi/2) = sin(theta1) and cos(theta1 + theta2 - pi/2) = sin(theta1 + theta2)
+        double g1 = (m * lc + m * l) * g * sin_theta1 + (m * lc * g * sin_theta12);
+        double g2 = m * lc * g * sin_theta12;
+
+        double u2 = _tau - 1 * .1 * theta2dot;
+        double u1 = -1 * .1 * theta1dot;
+        double determinant = d11 * d22 - d12 * d21;
+        theta1dot_dot = (d22 * (u1 - c1 - g1) - d12 * (u2 - c2 - g2)) / determinant;
+        theta2dot_dot = (d11 * (u2 - c2 - g2) - d21 * (u1 - c1 - g1)) / determinant;
+    }
+
+    /**
+     * @brief One integration step of two_link_acrobot_obs_t::propagate() for all lanes of a batch.
+     */
+    void integrate_lanes(const batch_lanes_t* state, const batch_lanes_t* control, double integration_step, batch_lanes_t* next)
+    {
+        // The trigonometric functions are evaluated per lane, the rest of the step is vectorized
+        batch_lanes_t sin_theta1, cos_theta1, sin_theta2, cos_theta2;
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            sin_theta1[lane] = sin(state[STATE_THETA_1][lane]);
+            cos_theta1[lane] = cos(state[STATE_THETA_1][lane]);
+            sin_theta2[lane] = sin(state[STATE_THETA_2][lane]);
+            cos_theta2[lane] = cos(state[STATE_THETA_2][lane]);
+        }
+        for(unsigned int lane = 0; lane < PROPAGATE_BATCH_LANES; lane++)
+        {
+            double theta1dot = state[STATE_V_1][lane];
+            double theta2dot = state[STATE_V_2][lane];
+            double _tau = control[CONTROL_T][lane];
+            if(_tau > MAX_T){
+                _tau = MAX_T;
+            }
+            else if (_tau < MIN_T){
+                _tau = MIN_T;
+            }
+
+            double sin_theta12 = sin_theta1[lane] * cos_theta2[lane] + cos_theta1[lane] * sin_theta2[lane];
+            double theta1dot_dot, theta2dot_dot;
+            link_accelerations(sin_theta1[lane], sin_theta2[lane], cos_theta2[lane], sin_theta12,
+                               theta1dot, theta2dot, _tau, theta1dot_dot, theta2dot_dot);
+
+            double theta_1 = state[STATE_THETA_1][lane] + integration_step*theta1dot;
+            double theta_2 = state[STATE_THETA_2][lane] + integration_step*theta2dot;
+            double v_1 = state[STATE_V_1][lane] + integration_step*theta1dot_dot;
+            double v_2 = state[STATE_V_2][lane] + integration_step*theta2dot_dot;
+
+            next[STATE_THETA_1][lane] = theta_1 < -M_PI ? theta_1 + 2*M_PI : (theta_1 > M_PI ? theta_1 - 2*M_PI : theta_1);
+            next[STATE_THETA_2][lane] = theta_2 < -M_PI ? theta_2 + 2*M_PI : (theta_2 > M_PI ? theta_2 - 2*M_PI : theta_2);
+            next[STATE_V_1][lane] = v_1 < MIN_V_1 ? MIN_V_1 : (v_1 > MAX_V_1 ? MAX_V_1 : v_1);
+            next[STATE_V_2][lane] = v_2 < MIN_V_2 ? MIN_V_2 : (v_2 > MAX_V_2 ? MAX_V_2 : v_2);
+        }
+    }
+}
+
 double two_link_acrobot_obs_t::distance(const double* point1, const double* point2, unsigned int state_dimension)
 {
         double x = (LENGTH) * cos(point1[STATE_THETA_1] - M_PI / 2)+(LENGTH) * cos(point1[STATE_THETA_1] + point1[STATE_THETA_2] - M_PI / 2);
@@ -61,22 +138,38 @@ bool two_link_acrobot_obs_t::propagate(
     const double* control, unsigned int control_dimension,
     int num_steps, double* result_state, double integration_step)
 {
+            double temp_state[4];
+            double deriv[4];
+            kinematics_t kinematics;
             temp_state[0] = start_state[0];
             temp_state[1] = start_state[1];
             temp_state[2] = start_state[2];
             temp_state[3] = start_state[3];
+            update_kinematics(temp_state, kinematics);
+            double previous_state[4];
+            kinematics_t previous_kinematics;
             bool validity = true;
             // find the last valid position, if no valid position is found, then return false
             for(int i=0;i<num_steps;i++)
             {
-                    update_derivative(control);
+                    update_derivative(temp_state, control, kinematics, deriv);
+                    if (continuous_collision_checking)
+                    {
+                        for (unsigned int d = 0; d < 4; d++)
+                            previous_state[d] = temp_state[d];
+                        previous_kinematics = kinematics;
+                    }
                     temp_state[0] += integration_step*deriv[0];
                     temp_state[1] += integration_step*deriv[1];
                     temp_state[2] += integration_step*deriv[2];
                     temp_state[3] += integration_step*deriv[3];
-                    enforce_bounds();
-                    //validity = validity && valid_state();
-                    if (valid_state() == true)
+                    enforce_bounds(temp_state);
+                    update_kinematics(temp_state, kinematics);
+                    //validity = validity && valid_state(temp_state);
+                    bool valid_step = continuous_collision_checking ?
+                        valid_sweep(previous_state, previous_kinematics, temp_state, kinematics) :
+                        valid_kinematics(temp_state, kinematics);
+                    if (valid_step == true)
                     {
                         result_state[0] = temp_state[0];
                         result_state[1] = temp_state[1];
@@ -98,52 +191,90 @@ bool two_link_acrobot_obs_t::propagate(
             return validity;
     }
 
-void two_link_acrobot_obs_t::enforce_bounds()
+void two_link_acrobot_obs_t::propagate_batch(
+    const double* start_states, unsigned int state_dimension,
+    const double* controls, unsigned int control_dimension,
+    const int* num_steps, unsigned int number_of_states,
+    double* result_states, bool* valid, double integration_step)
 {
+        if (continuous_collision_checking)
+        {
+            // The swept regions need the previous state of a propagation, which the lanes do not keep
+            enhanced_system_interface::propagate_batch(start_states, state_dimension, controls, control_dimension,
+                                                       num_steps, number_of_states, result_states, valid, integration_step);
+            return;
+        }
+        // Collisions are checked per lane on a copy of the lane state
+        propagate_lanes<4, 1, true>(
+            integrate_lanes,
+            [this](const batch_lanes_t* state, unsigned int lane) {
+                double lane_state[4];
+                for(unsigned int d = 0; d < 4; d++)
+                    lane_state[d] = state[d][lane];
+                return valid_state(lane_state);
+            },
+            true, start_states, controls, num_steps, number_of_states, result_states, valid, integration_step);
+}
+
+void two_link_acrobot_obs_t::enforce_bounds(double* state) const
+{
+
+    if(state[0]<-M_PI)
+            state[0]+=2*M_PI;
+    else if(state[0]>M_PI)
+            state[0]-=2*M_PI;
+    if(state[1]<-M_PI)
+            state[1]+=2*M_PI;
+    else if(state[1]>M_PI)
+            state[1]-=2*M_PI;
+    if(state[2]<MIN_V_1)
+            state[2]=MIN_V_1;
+    else if(state[2]>MAX_V_1)
+            state[2]=MAX_V_1;
+    if(state[3]<MIN_V_2)
+            state[3]=MIN_V_2;
+    else if(state[3]>MAX_V_2)
+            state[3]=MAX_V_2;
+}
+
 
-    if(temp_state[0]<-M_PI)
-            temp_state[0]+=2*M_PI;
-    else if(temp_state[0]>M_PI)
-            temp_state[0]-=2*M_PI;
-    if(temp_state[1]<-M_PI)
-            temp_state[1]+=2*M_PI;
-    else if(temp_state[1]>M_PI)
-            temp_state[1]-=2*M_PI;
-    if(temp_state[2]<MIN_V_1)
-            temp_state[2]=MIN_V_1;
-    else if(temp_state[2]>MAX_V_1)
-            temp_state[2]=MAX_V_1;
-    if(temp_state[3]<MIN_V_2)
-            temp_state[3]=MIN_V_2;
-    else if(temp_state[3]>MAX_V_2)
-            temp_state[3]=MAX_V_2;
+bool two_link_acrobot_obs_t::valid_state(const double* state) const
+{
+    kinematics_t kinematics;
+    update_kinematics(state, kinematics);
+    return valid_kinematics(state, kinematics);
 }
 
+void two_link_acrobot_obs_t::update_kinematics(const double* state, kinematics_t& kinematics) const
+{
+    kinematics.sin_theta1 = sin(state[STATE_THETA_1]);
+    kinematics.cos_theta1 = cos(state[STATE_THETA_1]);
+    kinematics.sin_theta2 = sin(state[STATE_THETA_2]);
+    kinematics.cos_theta2 = cos(state[STATE_THETA_2]);
+    kinematics.sin_theta12 = kinematics.sin_theta1 * kinematics.cos_theta2 + kinematics.cos_theta1 * kinematics.sin_theta2;
+    kinematics.cos_theta12 = kinematics.cos_theta1 * kinematics.cos_theta2 - kinematics.sin_theta1 * kinematics.sin_theta2;
+}
 
-bool two_link_acrobot_obs_t::valid_state()
+bool two_link_acrobot_obs_t::valid_kinematics(const double* state, const kinematics_t& kinematics) const
 {
     // check the pole with the rectangle to see if in collision
-    // calculate the pole state
+    // calculate the pole state, cos(theta - pi/2) = sin(theta) and sin(theta - pi/2) = -cos(theta)
     double pole_x0 = 0.;
     double pole_y0 = 0.;
-    double pole_x1 = (LENGTH) * cos(temp_state[STATE_THETA_1] - M_PI / 2);
-    double pole_y1 = (LENGTH) * sin(temp_state[STATE_THETA_1] - M_PI / 2);
-    double pole_x2 = pole_x1 + (LENGTH) * cos(temp_state[STATE_THETA_1] + temp_state[STATE_THETA_2] - M_PI / 2);
-    double pole_y2 = pole_y1 + (LENGTH) * sin(temp_state[STATE_THETA_1] + temp_state[STATE_THETA_2] - M_PI / 2);
+    double pole_x1 = (LENGTH) * kinematics.sin_theta1;
+    double pole_y1 = -(LENGTH) * kinematics.cos_theta1;
+    double pole_x2 = pole_x1 + (LENGTH) * kinematics.sin_theta12;
+    double pole_y2 = pole_y1 - (LENGTH) * kinematics.cos_theta12;
 
-    //std::cout << "state:" << temp_state[0] << "\n";
+    //std::cout << "state:" << state[0] << "\n";
     //std::cout << "pole point 1: " << "(" << pole_x1 << ", " << pole_y1 << ")\n";
     //std::cout << "pole point 2: " << "(" << pole_x2 << ", " << pole_y2 << ")\n";
-    for(unsigned int i = 0; i < obs_list.size(); i++)
-    {
-        // check if any obstacle has intersection with pole
-        //std::cout << "obstacle " << i << "\n";
-        //std::cout << "points: \n";
-        for (unsigned int j = 0; j < 8; j+=2)
-        {
-
-            //std::cout << j << "-th point: " << "(" << obs_list[i][j] << ", " << obs_list[i][j+1] << ")\n";
-        }
+    // only the obstacles around the bounding box of a link can intersect it
+    double first_link_box[4] = {std::min(pole_x0, pole_x1), std::max(pole_x0, pole_x1),
+                                std::min(pole_y0, pole_y1), std::max(pole_y0, pole_y1)};
+    double second_link_box[4] = {std::min(pole_x1, pole_x2), std::max(pole_x1, pole_x2),
+                                 std::min(pole_y1, pole_y2), std::max(pole_y1, pole_y2)};
+    auto intersects = [&](unsigned int i, double link_x1, double link_y1, double link_x2, double link_y2) {
         for (unsigned int j = 0; j < 8; j+=2)
         {
             // check each line of the obstacle
@@ -151,19 +282,49 @@ bool two_link_acrobot_obs_t::valid_state()
             double y1 = obs_list[i][j+1];
             double x2 = obs_list[i][(j+2) % 8];
             double y2 = obs_list[i][(j+3) % 8];
-            if (lineLine(pole_x0, pole_y0, pole_x1, pole_y1, x1, y1, x2, y2))
-            {
-                // intersect
-                return false;
-            }
-            if (lineLine(pole_x1, pole_y1, pole_x2, pole_y2, x1, y1, x2, y2))
+            if (lineLine(link_x1, link_y1, link_x2, link_y2, x1, y1, x2, y2))
             {
                 // intersect
-                return false;
+                return true;
             }
         }
-    }
-    return true;
+        return false;
+    };
+    return !obstacle_grid.any_near(first_link_box, [&](unsigned int i) {
+        return intersects(i, pole_x0, pole_y0, pole_x1, pole_y1);
+    }) && !obstacle_grid.any_near(second_link_box, [&](unsigned int i) {
+        return intersects(i, pole_x1, pole_y1, pole_x2, pole_y2);
+    });
+}
+
+bool two_link_acrobot_obs_t::valid_sweep(const double* from_state, const kinematics_t& from_kinematics,
+                                         const double* state, const kinematics_t& kinematics) const
+{
+    // the joints of both states, cos(theta - pi/2) = sin(theta) and sin(theta - pi/2) = -cos(theta)
+    double first_link[6] = {
+        0., 0.,
+        (LENGTH) * from_kinematics.sin_theta1, -(LENGTH) * from_kinematics.cos_theta1,
+        (LENGTH) * kinematics.sin_theta1, -(LENGTH) * kinematics.cos_theta1
+    };
+    double second_link[8] = {
+        first_link[2], first_link[3],
+        first_link[2] + (LENGTH) * from_kinematics.sin_theta12, first_link[3] - (LENGTH) * from_kinematics.cos_theta12,
+        first_link[4], first_link[5],
+        first_link[4] + (LENGTH) * kinematics.sin_theta12, first_link[5] - (LENGTH) * kinematics.cos_theta12
+    };
+    // the second link turns with both angles, and its joint moves on the arc of the first link
+    double first_margin = arc_deviation(LENGTH, from_state[STATE_THETA_1], state[STATE_THETA_1]);
+    double second_margin = first_margin + arc_deviation(LENGTH,
+        from_state[STATE_THETA_1] + from_state[STATE_THETA_2], state[STATE_THETA_1] + state[STATE_THETA_2]);
+    double first_sweep_box[4], second_sweep_box[4];
+    hull_bounding_box(first_link, 3, first_margin, first_sweep_box);
+    hull_bounding_box(second_link, 4, second_margin, second_sweep_box);
+    // the lower left and upper right corners of the obstacle
+    return !obstacle_grid.any_near(first_sweep_box, [&](unsigned int i) {
+        return hull_overlaps_box(first_link, 3, first_margin, obs_list[i][6], obs_list[i][7], obs_list[i][2], obs_list[i][3]);
+    }) && !obstacle_grid.any_near(second_sweep_box, [&](unsigned int i) {
+        return hull_overlaps_box(second_link, 4, second_margin, obs_list[i][6], obs_list[i][7], obs_list[i][2], obs_list[i][3]);
+    });
 }
 
 std::tuple<double, double> two_link_acrobot_obs_t::visualize_point(const double* state, unsigned int state_dimension) const
@@ -175,12 +336,10 @@ std::tuple<double, double> two_link_acrobot_obs_t::visualize_point(const double*
     return std::make_tuple(x, y);
 }
 
-void two_link_acrobot_obs_t::update_derivative(const double* control)
+void two_link_acrobot_obs_t::update_derivative(const double* state, const double* control, const kinematics_t& kinematics, double* derivative) const
 {
-    double theta2 = temp_state[STATE_THETA_2];
-    double theta1 = temp_state[STATE_THETA_1] - M_PI / 2;
-    double theta1dot = temp_state[STATE_V_1];
-    double theta2dot = temp_state[STATE_V_2];
+    double theta1dot = state[STATE_V_1];
+    double theta2dot = state[STATE_V_2];
     double _tau = control[CONTROL_T];
 
     if(_tau > MAX_T){
@@ -190,31 +349,12 @@ void two_link_acrobot_obs_t::update_derivative(const double* control)
         _tau = MIN_T;
     }
 
-    //extra term m*lc2
-    double d11 = m * lc2 + m * (l2 + lc2 + 2 * l * lc * cos(theta2)) + I1 + I2;
-
-    double d22 = m * lc2 + I2;
-    double d12 = m * (lc2 + l * lc * cos(theta2)) + I2;
-    double d21 = d12;
-
-    //extra theta1dot
-    double c1 = -m * l * lc * theta2dot * theta2dot * sin(theta2) - (2 * m * l * lc * theta1dot * theta2dot * sin(theta2));
-    double c2 = m * l * lc * theta1dot * theta1dot * sin(theta2);
-    double g1 = (m * lc + m * l) * g * cos(theta1) + (m * lc * g * cos(theta1 + theta2));
-    double g2 = m * lc * g * cos(theta1 + theta2);
-
-    deriv[STATE_THETA_1] = theta1dot;
-    deriv[STATE_THETA_2] = theta2dot;
-
-    double u2 = _tau - 1 * .1 * theta2dot;
-    double u1 = -1 * .1 * theta1dot;
-    double theta1dot_dot = (d22 * (u1 - c1 - g1) - d12 * (u2 - c2 - g2)) / (d11 * d22 - d12 * d21);
-    double theta2dot_dot = (d11 * (u2 - c2 - g2) - d21 * (u1 - c1 - g1)) / (d11 * d22 - d12 * d21);
-
-    deriv[STATE_V_1] = theta1dot_dot;
-    deriv[STATE_V_2] = theta2dot_dot;
+    derivative[STATE_THETA_1] = theta1dot;
+    derivative[STATE_THETA_2] = theta2dot;
+    link_accelerations(kinematics.sin_theta1, kinematics.sin_theta2, kinematics.cos_theta2, kinematics.sin_theta12,
+                       theta1dot, theta2dot, _tau, derivative[STATE_V_1], derivative[STATE_V_2]);
 }
-bool two_link_acrobot_obs_t::lineLine(double x1, double y1, double x2, double y2, double x3, double y3, double x4, double y4)
+bool two_link_acrobot_obs_t::lineLine(double x1, double y1, double x2, double y2, double x3, double y3, double x4, double y4) const
 // compute whether two lines intersect with each other
 {
     // ref: http://www.jeffreythompson.org/collision-detection/line-rect.php
@@ -92,26 +92,23 @@ namespace trajectory_optimizers{
                 loss.at(si).second = si;
             }
             for(unsigned int ti=0; ti < number_of_t; ti++){ // time loop
+                // propagate all samples of the time segment at once, inactive samples take no steps
+                for(unsigned int si = 0; si < number_of_samples; si++){
+                    for(unsigned int ci = 0; ci < c_dim; ci++){
+                        batch_controls[si * c_dim + ci] = controls[si * number_of_t * c_dim + ti + ci];
+                    }
+                    batch_steps[si] = active_mask[si] ? (int)(time[si * number_of_t + ti] / dt) : 0;
+                }
+                system -> propagate_batch(states, s_dim, batch_controls, c_dim,
+                    batch_steps, number_of_samples, states, batch_valid, dt);
                 for(unsigned int si = 0; si < number_of_samples; si++){
                     if (active_mask[si]){
-                        if (system -> propagate(&states[si * s_dim], 
-                            s_dim, 
-                            &controls[si * number_of_t * c_dim + ti],
-                            c_dim,
-                            (int)(time[si * number_of_t + ti] / dt),
-                            &states[si * s_dim],
-                            dt)){// collision free
-                                // loss.at(si).first += time[si * number_of_t + ti];
-                                // std::cout <<"si="<<si<<",ti="<<ti <<"\t"<<controls[si * number_of_t * c_dim + ti]<<std::endl;    
-                                // loss.at(si).first += system -> get_loss(
-                                //     &states[si*s_dim], goal, weight
-                                //     );
+                        if (batch_valid[si]){// collision free
                                 double current_sample_loss = system -> get_loss(
                                     &states[si*s_dim], goal, weight
                                     );
                                 if (current_sample_loss < converge_radius){
                                     active_mask[si] = false;
-                                    // std::cout <<"si="<<si<<",ti="<<ti<<" reached,"<<current_sample_loss<<std::endl;
                                 }
                         }
                         else{ // collision
@@ -121,8 +118,10 @@ namespace trajectory_optimizers{
                     }
                 }
             }            
-            for(unsigned int si = 0; si < number_of_samples; si++){ // terminal_loss
-                loss.at(si).first += system -> get_loss(&states[si * s_dim], goal, weight);
+            // terminal_loss, evaluated for all samples at once
+            system -> get_loss_batch(states, number_of_samples, goal, weight, terminal_loss);
+            for(unsigned int si = 0; si < number_of_samples; si++){
+                loss.at(si).first += terminal_loss[si];
             }
             #ifdef DEBUG
             for(unsigned int si = 0; si < number_of_samples; si++){
@@ -0,0 +1,206 @@
+/**
+ * @file batch_distance.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <assert.h>
+#include <cmath>
+
+#include "utilities/batch_distance.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_DISTANCE_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /**
+     * @brief Addresses points stored one after another.
+     */
+    struct contiguous_points_t
+    {
+        const double* points;
+        unsigned int stride;
+        const double* operator()(unsigned int i) const
+        {
+            return points + (size_t)i * stride;
+        }
+    };
+
+    /**
+     * @brief Addresses points of a slot-addressed point store.
+     */
+    struct slot_points_t
+    {
+        const double* store;
+        unsigned int stride;
+        const unsigned int* slots;
+        const double* operator()(unsigned int i) const
+        {
+            return store + (size_t)slots[i] * stride;
+        }
+    };
+
+    template <class points_t>
+    void scalar_squared_distances(const double* query, const points_t& points, unsigned int number_of_points,
+                                  unsigned int dimension, const long long* circular_mask,
+                                  const double* weights, double* result)
+    {
+        for( unsigned int n=0; n<number_of_points; n++ )
+        {
+            const double* point = points(n);
+            double distance = 0;
+            for( unsigned int i=0; i<dimension; i++ )
+            {
+                double val = fabs(point[i] - query[i]);
+                if( circular_mask[i] && val > M_PI )
+                    val = 2*M_PI - val;
+                distance += weights[i]*val*val;
+            }
+            result[n] = distance;
+        }
+    }
+
+#ifdef BATCH_DISTANCE_HAS_AVX2
+    bool cpu_supports_avx2()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+
+    template <class points_t>
+    __attribute__((target("avx2,fma")))
+    void avx2_squared_distances(const double* query, const points_t& points, unsigned int number_of_points,
+                                unsigned int dimension, unsigned int padded_dimension,
+                                const long long* circular_mask, const long long* load_mask,
+                                const double* weights, double* result)
+    {
+        const __m256d sign_bit = _mm256_set1_pd(-0.0);
+        const __m256d pi = _mm256_set1_pd(M_PI);
+        const __m256d two_pi = _mm256_set1_pd(2*M_PI);
+        // The last chunk of a point is loaded through a mask so that points do not need padding
+        unsigned int full_chunks = dimension / BATCH_DISTANCE_LANES * BATCH_DISTANCE_LANES;
+
+        for( unsigned int n=0; n<number_of_points; n++ )
+        {
+            const double* point = points(n);
+            __m256d accumulator = _mm256_setzero_pd();
+            for( unsigned int c=0; c<padded_dimension; c+=BATCH_DISTANCE_LANES )
+            {
+                __m256d p, q;
+                if( c < full_chunks )
+                {
+                    p = _mm256_loadu_pd(point + c);
+                    q = _mm256_loadu_pd(query + c);
+                }
+                else
+                {
+                    __m256i mask = _mm256_load_si256((const __m256i*)(load_mask + c));
+                    p = _mm256_maskload_pd(point + c, mask);
+                    q = _mm256_maskload_pd(query + c, mask);
+                }
+                __m256d val = _mm256_andnot_pd(sign_bit, _mm256_sub_pd(p, q));
+                __m256d wrap = _mm256_and_pd(_mm256_castsi256_pd(_mm256_load_si256((const __m256i*)(circular_mask + c))),
+                                             _mm256_cmp_pd(val, pi, _CMP_GT_OQ));
+                val = _mm256_blendv_pd(val, _mm256_sub_pd(two_pi, val), wrap);
+                accumulator = _mm256_fmadd_pd(_mm256_mul_pd(_mm256_load_pd(weights + c), val), val, accumulator);
+            }
+            __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(accumulator), _mm256_extractf128_pd(accumulator, 1));
+            result[n] = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+        }
+    }
+#else
+    bool cpu_supports_avx2()
+    {
+        return false;
+    }
+#endif
+
+    bool& simd_enabled()
+    {
+        static bool enabled = cpu_supports_avx2();
+        return enabled;
+    }
+}
+
+batch_distance_t::batch_distance_t()
+    : dimension(0)
+    , padded_dimension(0)
+{
+}
+
+batch_distance_t::batch_distance_t(const std::vector<bool>& is_circular_topology, const std::vector<double>& new_weights)
+    : dimension(is_circular_topology.size())
+{
+    assert( new_weights.empty() || new_weights.size() == dimension );
+    padded_dimension = ((dimension + BATCH_DISTANCE_LANES - 1) / BATCH_DISTANCE_LANES) * BATCH_DISTANCE_LANES;
+    circular_mask.assign(padded_dimension, 0);
+    load_mask.assign(padded_dimension, 0);
+    weights.assign(padded_dimension, 0.);
+    for( unsigned int i=0; i<dimension; i++ )
+    {
+        circular_mask[i] = is_circular_topology[i] ? -1 : 0;
+        load_mask[i] = -1;
+        weights[i] = new_weights.empty() ? 1. : new_weights[i];
+    }
+}
+
+void batch_distance_t::squared_distances(const double* query, const double* points, unsigned int stride,
+                                         unsigned int number_of_points, double* result) const
+{
+    assert( stride >= dimension );
+    contiguous_points_t addressing = {points, stride};
+#ifdef BATCH_DISTANCE_HAS_AVX2
+    if( simd_enabled() )
+    {
+        avx2_squared_distances(query, addressing, number_of_points, dimension, padded_dimension,
+                               circular_mask.data(), load_mask.data(), weights.data(), result);
+        return;
+    }
+#endif
+    scalar_squared_distances(query, addressing, number_of_points, dimension, circular_mask.data(), weights.data(), result);
+}
+
+void batch_distance_t::squared_distances(const double* query, const double* store, unsigned int stride,
+                                         const unsigned int* slots, unsigned int number_of_points, double* result) const
+{
+    assert( stride >= dimension );
+    slot_points_t addressing = {store, stride, slots};
+#ifdef BATCH_DISTANCE_HAS_AVX2
+    if( simd_enabled() )
+    {
+        avx2_squared_distances(query, addressing, number_of_points, dimension, padded_dimension,
+                               circular_mask.data(), load_mask.data(), weights.data(), result);
+        return;
+    }
+#endif
+    scalar_squared_distances(query, addressing, number_of_points, dimension, circular_mask.data(), weights.data(), result);
+}
+
+void batch_distance_t::distances(const double* query, const double* points, unsigned int stride,
+                                 unsigned int number_of_points, double* result) const
+{
+    squared_distances(query, points, stride, number_of_points, result);
+    for( unsigned int n=0; n<number_of_points; n++ )
+        result[n] = std::sqrt(result[n]);
+}
+
+const char* batch_distance_t::kernel_name()
+{
+    return simd_enabled() ? "avx2" : "scalar";
+}
+
+void batch_distance_t::set_simd_enabled(bool enabled)
+{
+    simd_enabled() = enabled && cpu_supports_avx2();
+}
@@ -0,0 +1,63 @@
+/**
+ * @file slab_allocator.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <new>
+
+#include "utilities/slab_allocator.hpp"
+
+namespace
+{
+	size_t round_up(size_t size, size_t alignment)
+	{
+		return (size + alignment - 1) / alignment * alignment;
+	}
+}
+
+slab_allocator_t::slab_allocator_t(size_t a_block_size, size_t a_blocks_per_slab)
+	: block_size(round_up(a_block_size < sizeof(void*) ? sizeof(void*) : a_block_size, alignof(std::max_align_t)))
+	, blocks_per_slab(a_blocks_per_slab)
+	, used_in_last_slab(a_blocks_per_slab)
+	, free_list(nullptr)
+	, number_of_blocks(0)
+{
+}
+
+slab_allocator_t::~slab_allocator_t()
+{
+	for (auto slab: slabs) {
+		::operator delete(slab);
+	}
+}
+
+void* slab_allocator_t::allocate()
+{
+	number_of_blocks++;
+	if (free_list != nullptr) {
+		void* block = free_list;
+		free_list = *static_cast<void**>(block);
+		return block;
+	}
+	if (used_in_last_slab == blocks_per_slab) {
+		slabs.push_back(static_cast<char*>(::operator new(blocks_per_slab * block_size)));
+		used_in_last_slab = 0;
+	}
+	return slabs.back() + block_size * used_in_last_slab++;
+}
+
+void slab_allocator_t::deallocate(void* block)
+{
+	number_of_blocks--;
+	*static_cast<void**>(block) = free_list;
+	free_list = block;
+}
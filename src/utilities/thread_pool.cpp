@@ -0,0 +1,86 @@
+/**
+ * @file thread_pool.cpp
+ *
+ * @copyright Software License Agreement (BSD License)
+ * Original work Copyright (c) 2014, Rutgers the State University of New Jersey, New Brunswick
+ * Modified work Copyright 2017 Oleg Y. Sinyavskiy
+ * All Rights Reserved.
+ * For a full description see the file named LICENSE.
+ *
+ * Original authors: Zakary Littlefield, Kostas Bekris
+ * Modifications by: Oleg Y. Sinyavskiy
+ *
+ */
+
+#include <assert.h>
+
+#include "utilities/thread_pool.hpp"
+
+thread_pool_t::thread_pool_t(unsigned int number_of_threads)
+    : current_task(nullptr)
+    , number_of_tasks(0)
+    , next_task(0)
+    , finished_threads(0)
+    , generation(0)
+    , stopping(false)
+{
+    assert(number_of_threads > 0);
+    for (unsigned int i = 0; i < number_of_threads; i++) {
+        threads.emplace_back(&thread_pool_t::work, this, i);
+    }
+}
+
+thread_pool_t::~thread_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& t: threads) {
+        t.join();
+    }
+}
+
+void thread_pool_t::parallel_for(unsigned int a_number_of_tasks, const std::function<void(unsigned int, unsigned int)>& task)
+{
+    if (a_number_of_tasks == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    current_task = &task;
+    number_of_tasks = a_number_of_tasks;
+    next_task = 0;
+    finished_threads = 0;
+    generation++;
+    work_available.notify_all();
+    work_finished.wait(lock, [this]() { return finished_threads == threads.size(); });
+    current_task = nullptr;
+}
+
+void thread_pool_t::work(unsigned int thread)
+{
+    unsigned long seen_generation = 0;
+    while (true) {
+        const std::function<void(unsigned int, unsigned int)>* task;
+        unsigned int tasks;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [this, seen_generation]() { return stopping || generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+            task = current_task;
+            tasks = number_of_tasks;
+        }
+        for (unsigned int index = next_task++; index < tasks; index = next_task++) {
+            (*task)(index, thread);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished_threads++;
+        }
+        work_finished.notify_one();
+    }
+}
@@ -0,0 +1,105 @@
+#include "nearest_neighbors/graph_nearest_neighbors.hpp"
+#include "nearest_neighbors/kd_tree_nearest_neighbors.hpp"
+#include "motion_planners/tree_node.hpp"
+#include "systems/distance_functions.h"
+#include "utilities/random.hpp"
+#include "utilities/timer.hpp"
+
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+// Inserts random points, removes a part of them and compares the closest points
+// returned by the index against brute force.
+unsigned int test_index(nearest_neighbors_t* index, const char* name, const vector<bool>& topology,
+               unsigned int number_of_points, unsigned int number_of_queries){
+    unsigned int dimension = topology.size();
+    euclidean_distance metric(topology);
+    index->set_distance(
+        [&metric, dimension](const double* s0, const double* s1) {
+            return metric.distance(s0, s1, dimension);
+        }, dimension);
+
+    RandomGenerator random_generator(0);
+    vector<double> point(dimension);
+    auto random_point = [&]() {
+        for (unsigned int i = 0; i < dimension; i++) {
+            point[i] = topology[i] ? random_generator.uniform_random(-M_PI, M_PI) : random_generator.uniform_random(-10, 10);
+        }
+    };
+
+    vector<state_point_t*> points;
+    sys_timer_t timer;
+    timer.reset();
+    for (unsigned int i = 0; i < number_of_points; i++) {
+        random_point();
+        points.push_back(new state_point_t(&point[0], dimension));
+        index->add_node(points.back());
+    }
+    for (unsigned int i = 0; i < number_of_points; i += 3) {
+        index->remove_node(points[i]);
+    }
+    double insert_time = timer.measure();
+
+    unsigned int exact = 0;
+    double query_time = 0;
+    for (unsigned int q = 0; q < number_of_queries; q++) {
+        random_point();
+        double distance;
+        timer.reset();
+        proximity_node_t* closest = index->find_closest(&point[0], &distance);
+        query_time += timer.measure();
+
+        double best = std::numeric_limits<double>::max();
+        for (unsigned int i = 0; i < number_of_points; i++) {
+            if (points[i]->get_proximity_node() != nullptr) {
+                best = std::min(best, metric.distance(points[i]->get_point(), &point[0], dimension));
+            }
+        }
+        if (closest != nullptr && fabs(distance - best) < 1e-9) {
+            exact++;
+        }
+    }
+
+    cout << name << " dim " << dimension << ": insert " << insert_time << "s, "
+         << number_of_queries / query_time << " queries/s, exact " << exact << "/" << number_of_queries << endl;
+
+    delete index;
+    for (auto p: points) {
+        delete p;
+    }
+    return exact;
+}
+
+int main(){
+    vector<vector<bool>> topologies = {
+        {false, false},
+        {true, true, false, false},
+        {false, false, false, false, false, false, false, false, false, false, false, false, false}
+    };
+    bool success = true;
+    cout << "distance kernel: " << batch_distance_t::kernel_name() << endl;
+    for (auto& topology: topologies) {
+        unsigned int graph_exact = test_index(new graph_nearest_neighbors_t(), "graph", topology, 20000, 1000);
+        concrete_distance_t<euclidean_distance> functor(euclidean_distance(topology), topology.size());
+        success &= test_index(new specialized_graph_nearest_neighbors_t<concrete_distance_t<euclidean_distance>>(functor),
+                              "graph specialized", topology, 20000, 1000) == graph_exact;
+        success &= test_index(new kd_tree_nearest_neighbors_t(topology), "kd_tree", topology, 20000, 1000) == 1000;
+    }
+    // Fixed-dimension distances used by the Python wrapper for the point and cart-pole systems
+    // return the same neighbors as the runtime dimension
+    vector<bool> point_topology = {false, false};
+    success &= test_index(new specialized_graph_nearest_neighbors_t<fixed_euclidean_distance_t<2>>(),
+                          "graph fixed", point_topology, 20000, 1000) ==
+               test_index(new graph_nearest_neighbors_t(), "graph", point_topology, 20000, 1000);
+    vector<bool> cart_pole_topology = {false, false, true, false};
+    success &= test_index(new specialized_graph_nearest_neighbors_t<fixed_euclidean_distance_t<4, 0x4>>(),
+                          "graph fixed", cart_pole_topology, 20000, 1000) ==
+               test_index(new graph_nearest_neighbors_t(), "graph", cart_pole_topology, 20000, 1000);
+    batch_distance_t::set_simd_enabled(false);
+    for (auto& topology: topologies) {
+        success &= test_index(new kd_tree_nearest_neighbors_t(topology), "kd_tree scalar", topology, 20000, 1000) == 1000;
+    }
+    return success ? 0 : 1;
+}
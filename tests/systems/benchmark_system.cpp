@@ -0,0 +1,109 @@
+#include "systems/cart_pole.hpp"
+#include "systems/cart_pole_obs.hpp"
+#include "systems/two_link_acrobot_obs.hpp"
+#include "utilities/random.hpp"
+#include "utilities/timer.hpp"
+
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+// Measures the cost of one integration step of propagate(), including the bounds enforcement
+// and the discrete or continuous collision check. The obstacles are out of reach, so every propagation runs all of its steps.
+template <class system_type_t>
+double benchmark_propagate(system_type_t* system, const char* name, const vector<pair<double, double>>& start_bounds,
+                           unsigned int number_of_propagations, int num_steps, double integration_step){
+    unsigned int s_dim = system->get_state_dimension(), c_dim = system->get_control_dimension();
+    vector<pair<double, double>> control_bounds = system->get_control_bounds();
+
+    RandomGenerator random_generator(0);
+    vector<double> starts(number_of_propagations * s_dim), controls(number_of_propagations * c_dim);
+    for (unsigned int i = 0; i < number_of_propagations; i++) {
+        for (unsigned int d = 0; d < s_dim; d++) {
+            starts[i * s_dim + d] = random_generator.uniform_random(start_bounds[d].first, start_bounds[d].second);
+        }
+        for (unsigned int d = 0; d < c_dim; d++) {
+            controls[i * c_dim + d] = random_generator.uniform_random(control_bounds[d].first, control_bounds[d].second);
+        }
+    }
+
+    vector<double> result(s_dim);
+    unsigned int number_of_valid = 0;
+    double best_time = numeric_limits<double>::max();
+    sys_timer_t timer;
+    for (unsigned int repetition = 0; repetition < 5; repetition++) {
+        number_of_valid = 0;
+        timer.reset();
+        for (unsigned int i = 0; i < number_of_propagations; i++) {
+            number_of_valid += system->propagate(&starts[i * s_dim], s_dim, &controls[i * c_dim], c_dim,
+                                                 num_steps, &result[0], integration_step);
+        }
+        best_time = min(best_time, timer.measure());
+    }
+    double step_time = best_time / (double(number_of_propagations) * num_steps) * 1e9;
+    cout << name << ": " << step_time << " ns per step, "
+         << number_of_valid << "/" << number_of_propagations << " valid propagations" << endl;
+    return step_time;
+}
+
+int main(){
+    unsigned int number_of_propagations = 2000;
+    int num_steps = 100;
+
+    vector<vector<double>> cart_pole_obstacles;
+    for (unsigned int i = 0; i < 7; i++) {
+        cart_pole_obstacles.push_back(vector<double> {-24. + 8. * i, 20.});
+    }
+    cart_pole_obs_t cart_pole(cart_pole_obstacles, 4.);
+    benchmark_propagate(&cart_pole, "cart_pole_obs",
+                        {{-5, 5}, {-5, 5}, {-M_PI, M_PI}, {-2, 2}},
+                        number_of_propagations, num_steps, 0.002);
+    cart_pole.set_continuous_collision_checking(true);
+    benchmark_propagate(&cart_pole, "cart_pole_obs continuous",
+                        {{-5, 5}, {-5, 5}, {-M_PI, M_PI}, {-2, 2}},
+                        number_of_propagations, num_steps, 0.002);
+
+    // Hundreds of obstacles above and below the reach of the pole, which the broad phase has to sort out
+    RandomGenerator obstacle_generator(1);
+    vector<vector<double>> map_obstacles;
+    for (unsigned int i = 0; i < 400; i++) {
+        double height = obstacle_generator.uniform_random(4, 30);
+        map_obstacles.push_back(vector<double> {obstacle_generator.uniform_random(-30, 30), i % 2 == 0 ? height : -height});
+    }
+    cart_pole_obs_t map_cart_pole(map_obstacles, 1.);
+    benchmark_propagate(&map_cart_pole, "cart_pole_obs 400 obstacles",
+                        {{-5, 5}, {-5, 5}, {-M_PI, M_PI}, {-2, 2}},
+                        number_of_propagations, num_steps, 0.002);
+
+    // The integrators of the cart-pole without obstacles, every step evaluates the derivatives
+    // once (euler), twice (semi_implicit_euler), four times (rk4) or at least six times (rk45)
+    cart_pole_t free_cart_pole;
+    unsigned int cart_pole_dimension = free_cart_pole.get_state_dimension();
+    vector<pair<integrator_t*, const char*>> integrators = {
+        {nullptr, "cart_pole euler"},
+        {new semi_implicit_euler_integrator_t(free_cart_pole.is_velocity()), "cart_pole semi_implicit_euler"},
+        {new rk4_integrator_t(cart_pole_dimension), "cart_pole rk4"},
+        {new rk45_integrator_t(cart_pole_dimension), "cart_pole rk45"}
+    };
+    for (auto& integrator: integrators) {
+        free_cart_pole.set_integrator(integrator.first);
+        benchmark_propagate(&free_cart_pole, integrator.second,
+                            {{-5, 5}, {-5, 5}, {-M_PI, M_PI}, {-2, 2}},
+                            number_of_propagations, num_steps, 0.002);
+    }
+
+    vector<vector<double>> acrobot_obstacles;
+    for (unsigned int i = 0; i < 6; i++) {
+        acrobot_obstacles.push_back(vector<double> {-50. + 20. * i, 60.});
+    }
+    two_link_acrobot_obs_t acrobot(acrobot_obstacles, 6.);
+    benchmark_propagate(&acrobot, "two_link_acrobot_obs",
+                        {{-M_PI, M_PI}, {-M_PI, M_PI}, {-6, 6}, {-6, 6}},
+                        number_of_propagations, num_steps, 0.02);
+    acrobot.set_continuous_collision_checking(true);
+    benchmark_propagate(&acrobot, "two_link_acrobot_obs continuous",
+                        {{-M_PI, M_PI}, {-M_PI, M_PI}, {-6, 6}, {-6, 6}},
+                        number_of_propagations, num_steps, 0.02);
+    return 0;
+}
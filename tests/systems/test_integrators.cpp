@@ -0,0 +1,74 @@
+#include "systems/cart_pole.hpp"
+#include "systems/integrator.hpp"
+
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+// Largest difference of two cart-pole states, the angle is compared on the circle.
+double state_error(const vector<double>& state, const vector<double>& reference, const vector<bool>& topology){
+    double error = 0;
+    for (unsigned int i = 0; i < state.size(); i++) {
+        double difference = fabs(state[i] - reference[i]);
+        if (topology[i] && difference > M_PI) {
+            difference = 2 * M_PI - difference;
+        }
+        error = max(error, difference);
+    }
+    return error;
+}
+
+// Propagates the cart-pole with an integrator and compares the result with the reference.
+double test_integrator(cart_pole_t& system, integrator_t* integrator, const char* name,
+                       const vector<double>& start, const vector<double>& control, double duration,
+                       double integration_step, const vector<double>& reference, double error_bound){
+    unsigned int s_dim = system.get_state_dimension(), c_dim = system.get_control_dimension();
+    system.set_integrator(integrator);
+    vector<double> result(s_dim);
+    system.propagate(&start[0], s_dim, &control[0], c_dim, (int)round(duration / integration_step),
+                     &result[0], integration_step);
+    double error = state_error(result, reference, system.is_circular_topology());
+    cout << name << " step " << integration_step << ": error " << error << " (bound " << error_bound << ")" << endl;
+    return error;
+}
+
+int main(){
+    cart_pole_t system;
+    unsigned int s_dim = system.get_state_dimension(), c_dim = system.get_control_dimension();
+    vector<double> start = {0, 0, 0.5, 0};
+    vector<double> control = {20};
+    double duration = 1.;
+
+    // Reference trajectory: RK4 with a step a hundred times finer than the finest tested one
+    double reference_step = 2e-5;
+    vector<double> reference(s_dim);
+    system.set_integrator(new rk4_integrator_t(s_dim));
+    system.propagate(&start[0], s_dim, &control[0], c_dim, (int)round(duration / reference_step),
+                     &reference[0], reference_step);
+
+    bool success = true;
+    for (double integration_step: {0.002, 0.02}) {
+        // The bounds are about ten times the errors of the current implementation,
+        // the first order methods scale with the step, RK4 with its fourth power
+        double scale = integration_step / 0.02;
+        double euler_bound = 0.5 * scale, semi_implicit_bound = 0.2 * scale;
+        double rk4_bound = 2e-7 * pow(scale, 4), rk45_bound = 1e-6;
+        double euler = test_integrator(system, nullptr, "euler", start, control, duration,
+                                       integration_step, reference, euler_bound);
+        double semi_implicit = test_integrator(system, new semi_implicit_euler_integrator_t(system.is_velocity()),
+                                               "semi_implicit_euler", start, control, duration,
+                                               integration_step, reference, semi_implicit_bound);
+        double rk4 = test_integrator(system, new rk4_integrator_t(s_dim), "rk4", start, control, duration,
+                                     integration_step, reference, rk4_bound);
+        double rk45 = test_integrator(system, new rk45_integrator_t(s_dim, 1e-6), "rk45", start, control, duration,
+                                      integration_step, reference, rk45_bound);
+        success &= euler < euler_bound;
+        success &= semi_implicit < semi_implicit_bound && semi_implicit < euler;
+        success &= rk4 < rk4_bound && rk4 < semi_implicit;
+        success &= rk45 < rk45_bound;
+    }
+    system.set_integrator(nullptr);
+    cout << (success ? "integrators match the reference" : "integrator error above its bound") << endl;
+    return success ? 0 : 1;
+}
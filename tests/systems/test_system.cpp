@@ -1,6 +1,10 @@
 #include "systems/quadrotor_obs.hpp"
+#include "systems/cart_pole_obs.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <utilities/debug.hpp>
 
 using namespace std;
@@ -58,5 +62,85 @@ int main(){
         // check_state_validity(model, state);
 
     }
-    return 0;
+
+    // Test batch propagation against single propagations
+    unsigned int s_dim = model->get_state_dimension(), c_dim = model->get_control_dimension();
+    unsigned int number_of_states = 19;
+    std::vector<double> starts, controls, singles, batch;
+    std::vector<int> num_steps;
+    for(unsigned int i = 0; i < number_of_states; i++){
+        starts.insert(starts.end(), in_start, in_start + s_dim);
+        controls.insert(controls.end(), control, control + c_dim);
+        controls[i * c_dim + 1] = 0.1 * i - 1;
+        num_steps.push_back(5 * i);
+    }
+    singles = starts;
+    batch = starts;
+    bool* valid = new bool[number_of_states];
+    model->propagate_batch(starts.data(), s_dim, controls.data(), c_dim,
+                           num_steps.data(), number_of_states, batch.data(), valid, dt);
+    bool same = true;
+    for(unsigned int i = 0; i < number_of_states; i++){
+        bool single_valid = model->propagate(&starts[i * s_dim], s_dim, &controls[i * c_dim], c_dim,
+                                             num_steps[i], &singles[i * s_dim], dt);
+        same = same && single_valid == valid[i];
+    }
+    same = same && singles == batch;
+    std::cout << "batch propagation matches: " << same << std::endl;
+    bool success = same;
+
+    // Test propagations of the same system from several threads against single propagations
+    std::vector<double> parallel = starts;
+    std::vector<int> parallel_valid(number_of_states);
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < 4; t++){
+        threads.emplace_back([&, t](){
+            for(unsigned int i = t; i < number_of_states; i += 4){
+                parallel_valid[i] = model->propagate(&starts[i * s_dim], s_dim, &controls[i * c_dim], c_dim,
+                                                     num_steps[i], &parallel[i * s_dim], dt);
+            }
+        });
+    }
+    for(auto& thread : threads){
+        thread.join();
+    }
+    same = singles == parallel;
+    for(unsigned int i = 0; i < number_of_states; i++){
+        same = same && (parallel_valid[i] != 0) == valid[i];
+    }
+    std::cout << "parallel propagation matches: " << same << std::endl;
+    success = success && same;
+
+    // Test batch losses of the same system with different weights from several threads
+    std::vector<std::vector<double>> cart_pole_obstacles;
+    cart_pole_obs_t cart_pole(cart_pole_obstacles, 1.);
+    std::vector<double> loss_states;
+    for(unsigned int i = 0; i < 64 * 4; i++){
+        loss_states.push_back(0.01 * i - 1);
+    }
+    double loss_goal[4] = {0.5, -0.5, 1., 0.};
+    std::vector<int> losses_match(4);
+    threads.clear();
+    for(unsigned int t = 0; t < 4; t++){
+        threads.emplace_back([&, t](){
+            double weights[4] = {1. + t, 0.5, 2. - 0.25 * t, 0.3};
+            std::vector<double> losses(64);
+            bool match = true;
+            for(unsigned int repetition = 0; repetition < 100; repetition++){
+                cart_pole.get_loss_batch(loss_states.data(), 64, loss_goal, weights, losses.data());
+                for(unsigned int i = 0; i < 64; i++){
+                    match = match && std::abs(losses[i] - cart_pole.get_loss(&loss_states[i * 4], loss_goal, weights)) < 1e-9;
+                }
+            }
+            losses_match[t] = match;
+        });
+    }
+    for(auto& thread : threads){
+        thread.join();
+    }
+    same = std::all_of(losses_match.begin(), losses_match.end(), [](int match){ return match != 0; });
+    std::cout << "parallel losses match: " << same << std::endl;
+    success = success && same;
+    delete[] valid;
+    return success ? 0 : 1;
 }
\ No newline at end of file